@@ -0,0 +1,14 @@
+#version 450 core
+
+in vec2 vCoord;
+in vec4 vColor;
+
+out vec4 FragColor;
+
+void main() {
+    float alpha = min(0.99, vColor.a * exp(-0.5 * dot(vCoord, vCoord)));
+    // quad corners outside the ellipse contribute nothing
+    if (alpha < 1.0 / 255.0) discard;
+    // premultiplied, blended with (ONE, ONE_MINUS_SRC_ALPHA)
+    FragColor = vec4(vColor.rgb * alpha, alpha);
+}
@@ -0,0 +1,107 @@
+#version 450 core
+
+// One instanced quad per splat, no vertex buffers: the instance picks the
+// splat through the sorted order, the vertex id picks the quad corner.
+//
+// The 3D covariance R*S*S^T*R^T is projected to screen space with the
+// Jacobian of the perspective divide (EWA splatting). The quad is spanned
+// by the eigenvectors of the resulting 2D covariance, scaled by the sqrt
+// of the eigenvalues, and only reaches as far as the splat's alpha stays
+// above 1/255 (at most 3 sigma), so dim and thin splats cover few pixels.
+
+struct PackedSplat {
+    uvec4 a; // position.xyz (float bits), half scale.xy
+    uvec4 b; // half (scale.z, 0), half (w, x), half (y, z), unorm8 rgba
+};
+
+layout(std430, binding = 0) readonly buffer Splats {
+    PackedSplat splats[];
+};
+
+// back-to-front draw order
+layout(std430, binding = 1) readonly buffer Order {
+    uint order[];
+};
+
+uniform mat4 uView;
+uniform mat4 uProj;
+uniform vec2 uViewport; // pixels
+uniform vec2 uFocal;    // focal length in pixels
+uniform float uSplatScale;
+
+// position inside the splat in units of standard deviations along its 2D
+// eigenvectors, where the conic d^T * cov2D^-1 * d is simply dot(vCoord, vCoord)
+out vec2 vCoord;
+out vec4 vColor;
+
+const vec2 kCorners[4] = vec2[4](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));
+
+mat3 quat_to_mat3(vec4 q) // (w, x, y, z)
+{
+    float w = q.x, x = q.y, y = q.z, z = q.w;
+    return mat3(1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y + w * z), 2.0 * (x * z - w * y),
+                2.0 * (x * y - w * z), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z + w * x),
+                2.0 * (x * z + w * y), 2.0 * (y * z - w * x), 1.0 - 2.0 * (x * x + y * y));
+}
+
+void cull()
+{
+    gl_Position = vec4(0.0, 0.0, 2.0, 1.0); // outside the clip volume
+    vCoord = vec2(0.0);
+    vColor = vec4(0.0);
+}
+
+void main() {
+    PackedSplat s = splats[order[gl_InstanceID]];
+    vec4 color = unpackUnorm4x8(s.b.w);
+    if (color.a < 1.0 / 255.0) {
+        cull();
+        return;
+    }
+
+    vec4 t = uView * vec4(uintBitsToFloat(s.a.xyz), 1.0);
+    vec4 clip = uProj * t;
+    float limit = 1.2 * clip.w;
+    if (clip.w <= 0.0 || abs(clip.x) > limit || abs(clip.y) > limit) {
+        cull();
+        return;
+    }
+
+    vec3 scale = vec3(unpackHalf2x16(s.a.w), unpackHalf2x16(s.b.x).x) * uSplatScale;
+    vec4 q = vec4(unpackHalf2x16(s.b.y), unpackHalf2x16(s.b.z));
+    mat3 M = quat_to_mat3(q) * mat3(scale.x, 0.0, 0.0, 0.0, scale.y, 0.0, 0.0, 0.0, scale.z);
+    mat3 cov3D = M * transpose(M);
+
+    // Jacobian of (x, y, z) -> focal * (x, y) / -z; the view looks down -z.
+    // Off-center positions are clamped a bit outside the frustum so splats
+    // near the edges don't blow up.
+    float d = -t.z;
+    vec2 tanLimit = 1.3 * 0.5 * uViewport / uFocal;
+    vec2 xy = clamp(t.xy / d, -tanLimit, tanLimit) * d;
+    mat3 J = mat3(uFocal.x / d, 0.0, 0.0,
+                  0.0, uFocal.y / d, 0.0,
+                  uFocal.x * xy.x / (d * d), uFocal.y * xy.y / (d * d), 0.0);
+    mat3 T = J * mat3(uView);
+    mat3 cov = T * cov3D * transpose(T);
+
+    // low-pass: every splat covers at least about a pixel
+    float a = cov[0][0] + 0.3;
+    float b = cov[0][1];
+    float c = cov[1][1] + 0.3;
+
+    float mid = 0.5 * (a + c);
+    float disc = sqrt(max(mid * mid - (a * c - b * b), 0.0));
+    float lambda1 = mid + disc;
+    float lambda2 = max(mid - disc, 0.1);
+    vec2 v1 = abs(b) > 1e-6 ? normalize(vec2(b, lambda1 - a)) : (a >= c ? vec2(1.0, 0.0) : vec2(0.0, 1.0));
+    vec2 v2 = vec2(-v1.y, v1.x);
+
+    // opacity * exp(-r^2 / 2) = 1/255
+    float r = min(3.0, sqrt(2.0 * log(255.0 * color.a)));
+    vec2 corner = kCorners[gl_VertexID] * r;
+    vec2 offset = corner.x * sqrt(lambda1) * v1 + corner.y * sqrt(lambda2) * v2;
+
+    gl_Position = clip + vec4(offset * 2.0 / uViewport * clip.w, 0.0, 0.0);
+    vCoord = corner;
+    vColor = color;
+}
@@ -0,0 +1,75 @@
+#include <math.h>
+#include "camera.h"
+#include "math3d.h"
+
+static const float k_up[3] = {0.0f, 1.0f, 0.0f};
+
+void camera_fit_bounds(Camera *cam, const float boundsMin[3], const float boundsMax[3])
+{
+    if (!cam) return;
+    float radius = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+        cam->target[k] = 0.5f * (boundsMin[k] + boundsMax[k]);
+        float half = 0.5f * (boundsMax[k] - boundsMin[k]);
+        radius += half * half;
+    }
+    radius = sqrtf(radius);
+    if (!(radius > 0.0f)) radius = 1.0f;
+
+    cam->distance = radius / sinf(cam->fovy * 0.5f);
+    cam->znear = cam->distance * 0.001f;
+    cam->zfar = (cam->distance + radius) * 10.0f;
+}
+
+void camera_orbit(Camera *cam, float dYaw, float dPitch)
+{
+    if (!cam) return;
+    cam->yaw += dYaw;
+    cam->pitch += dPitch;
+    const float limit = 1.55f; // stay clear of the poles
+    if (cam->pitch > limit) cam->pitch = limit;
+    if (cam->pitch < -limit) cam->pitch = -limit;
+}
+
+void camera_pan(Camera *cam, float dx, float dy)
+{
+    if (!cam) return;
+    float eye[3], f[3], s[3], u[3];
+    camera_eye(*cam, eye);
+    vec3_sub(cam->target, eye, f);
+    vec3_normalize(f);
+    vec3_cross(f, k_up, s);
+    vec3_normalize(s);
+    vec3_cross(s, f, u);
+
+    float scale = 2.0f * cam->distance * tanf(cam->fovy * 0.5f);
+    for (int k = 0; k < 3; ++k)
+        cam->target[k] += (-dx * s[k] + dy * u[k]) * scale;
+}
+
+void camera_zoom(Camera *cam, float steps)
+{
+    if (!cam) return;
+    cam->distance *= powf(0.9f, steps);
+    if (cam->distance < 1e-4f) cam->distance = 1e-4f;
+}
+
+void camera_eye(const Camera &cam, float out[3])
+{
+    float cp = cosf(cam.pitch);
+    out[0] = cam.target[0] + cam.distance * cp * sinf(cam.yaw);
+    out[1] = cam.target[1] + cam.distance * sinf(cam.pitch);
+    out[2] = cam.target[2] + cam.distance * cp * cosf(cam.yaw);
+}
+
+void camera_view_matrix(const Camera &cam, float out[16])
+{
+    float eye[3];
+    camera_eye(cam, eye);
+    mat4_look_at(eye, cam.target, k_up, out);
+}
+
+void camera_proj_matrix(const Camera &cam, float aspect, float out[16])
+{
+    mat4_perspective(cam.fovy, aspect > 0.0f ? aspect : 1.0f, cam.znear, cam.zfar, out);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// Orbit camera around a target point.
+struct Camera {
+    float target[3] = {0.0f, 0.0f, 0.0f};
+    float distance = 3.0f;
+    float yaw = 0.0f;    // radians around +Y
+    float pitch = 0.2f;  // radians above the target's horizon
+    float fovy = 0.8f;   // vertical field of view, radians
+    float znear = 0.01f;
+    float zfar = 1000.0f;
+};
+
+// Center the camera on an axis-aligned box and back off until it fits.
+void camera_fit_bounds(Camera *cam, const float boundsMin[3], const float boundsMax[3]);
+
+// Rotate around the target (radians).
+void camera_orbit(Camera *cam, float dYaw, float dPitch);
+
+// Move the target in the view plane; dx/dy are fractions of the view height.
+void camera_pan(Camera *cam, float dx, float dy);
+
+// Dolly towards (steps > 0) or away from the target.
+void camera_zoom(Camera *cam, float steps);
+
+// World-space eye position.
+void camera_eye(const Camera &cam, float out[3]);
+
+void camera_view_matrix(const Camera &cam, float out[16]);
+void camera_proj_matrix(const Camera &cam, float aspect, float out[16]);
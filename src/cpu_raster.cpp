@@ -0,0 +1,488 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "cpu_raster.h"
+#include "parallel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_RASTER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+// must match shaders/tile_preprocess.comp and tile_render.comp
+static const int k_tileSize = 16;
+static const int k_groupPixels = 8; // pixels blended together, half a tile row
+
+// SH basis constants for bands 1..3 (band 0 is folded into GpuSplat::color)
+static const float k_shC1 = 0.4886025119029199f;
+static const float k_shC2[5] = {1.0925484305920792f, -1.0925484305920792f, 0.31539156525252005f,
+                                -1.0925484305920792f, 0.5462742152960396f};
+static const float k_shC3[7] = {-0.5900435899266435f, 2.890611442640554f, -0.4570457994644658f,
+                                0.3731763325901154f, -0.4570457994644658f, 1.445305721320277f,
+                                -0.5900435899266435f};
+
+// One splat as seen from the camera.
+struct Projected {
+    float center[2];  // pixels, y up
+    float conic[3];   // inverse 2D covariance (xx, xy, yy)
+    float color[4];   // rgb, opacity
+    uint32_t key;     // depth key, ascending is back to front
+    uint16_t tileMin[2], tileMax[2]; // empty when tileMin > tileMax
+};
+
+// Front-to-back SoA copy of one tile's list.
+struct TileScratch {
+    std::vector<uint64_t> order;
+    std::vector<float> cx, cy, ca, cb, cc, r, g, b, a;
+};
+
+static std::vector<Projected> g_projected;
+static std::vector<uint32_t> g_laneCounts; // per lane and tile; then write cursors
+static std::vector<uint32_t> g_tileStart;  // tiles + 1
+static std::vector<uint32_t> g_entries;    // splat indices grouped by tile
+static std::vector<TileScratch> g_scratch; // per lane
+
+static double ms_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Run fn(lane) for every lane, each on its own thread where the pool has one.
+template <typename Fn>
+static void run_lanes(unsigned lanes, const Fn &fn)
+{
+    parallel_for(lanes, 1, [&](size_t begin, size_t end) {
+        for (size_t lane = begin; lane < end; ++lane) fn((unsigned)lane);
+    });
+}
+
+static bool detect_simd()
+{
+#if defined(CPU_RASTER_X86) && defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0, osxsave = (info[2] & (1 << 27)) != 0;
+    if (!fma || !osxsave || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(CPU_RASTER_X86)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+bool cpu_raster_simd()
+{
+    static const bool simd = detect_simd();
+    return simd;
+}
+
+// View-dependent color of splat i from its SH bands, clamped like the
+// packed GPU color.
+static void sh_color(const CpuRasterScene &scene, size_t i, const float eye[3], float out[3])
+{
+    const GpuSplat &s = scene.splats[i];
+    for (int k = 0; k < 3; ++k) out[k] = s.color[k];
+    if (scene.shRest && scene.shDegree > 0) {
+        float d[3] = {s.position[0] - eye[0], s.position[1] - eye[1], s.position[2] - eye[2]};
+        float len = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        if (len > 0.0f) {
+            float x = d[0] / len, y = d[1] / len, z = d[2] / len;
+            float basis[SPLAT_SH_REST_COEFFS];
+            int n = 3;
+            basis[0] = -k_shC1 * y;
+            basis[1] = k_shC1 * z;
+            basis[2] = -k_shC1 * x;
+            if (scene.shDegree > 1) {
+                float xx = x * x, yy = y * y, zz = z * z;
+                basis[3] = k_shC2[0] * x * y;
+                basis[4] = k_shC2[1] * y * z;
+                basis[5] = k_shC2[2] * (2.0f * zz - xx - yy);
+                basis[6] = k_shC2[3] * x * z;
+                basis[7] = k_shC2[4] * (xx - yy);
+                n = 8;
+                if (scene.shDegree > 2) {
+                    basis[8] = k_shC3[0] * y * (3.0f * xx - yy);
+                    basis[9] = k_shC3[1] * x * y * z;
+                    basis[10] = k_shC3[2] * y * (4.0f * zz - xx - yy);
+                    basis[11] = k_shC3[3] * z * (2.0f * zz - 3.0f * xx - 3.0f * yy);
+                    basis[12] = k_shC3[4] * x * (4.0f * zz - xx - yy);
+                    basis[13] = k_shC3[5] * z * (xx - yy);
+                    basis[14] = k_shC3[6] * x * (xx - 3.0f * yy);
+                    n = 15;
+                }
+            }
+            const float *rest = scene.shRest + i * SPLAT_SH_REST_FLOATS;
+            for (int c = 0; c < n; ++c)
+                for (int k = 0; k < 3; ++k) out[k] += basis[c] * rest[c * 3 + k];
+        }
+    }
+    for (int k = 0; k < 3; ++k) out[k] = std::min(std::max(out[k], 0.0f), 1.0f);
+}
+
+// Same math as tile_preprocess.comp. Returns the number of tiles overlapped.
+static uint32_t project(const CpuRasterScene &scene, const CpuRasterParams &p, size_t i, const float eye[3],
+                        uint32_t tilesX, uint32_t tilesY, Projected *out)
+{
+    const GpuSplat &s = scene.splats[i];
+    out->tileMin[0] = out->tileMin[1] = 1;
+    out->tileMax[0] = out->tileMax[1] = 0;
+    if (s.opacity < 1.0f / 255.0f) return 0;
+
+    const float *v = p.view, *P = p.proj;
+    float x = s.position[0], y = s.position[1], z = s.position[2];
+    float t[3];
+    for (int r = 0; r < 3; ++r) t[r] = v[r] * x + v[4 + r] * y + v[8 + r] * z + v[12 + r];
+    float clip[4];
+    for (int r = 0; r < 4; ++r) clip[r] = P[r] * t[0] + P[4 + r] * t[1] + P[8 + r] * t[2] + P[12 + r];
+    float limit = 1.2f * clip[3];
+    if (clip[3] <= 0.0f || fabsf(clip[0]) > limit || fabsf(clip[1]) > limit) return 0;
+
+    // cov3D = R S S^T R^T
+    float qw = s.rotation[0], qx = s.rotation[1], qy = s.rotation[2], qz = s.rotation[3];
+    float R[3][3] = {
+        {1.0f - 2.0f * (qy * qy + qz * qz), 2.0f * (qx * qy - qw * qz), 2.0f * (qx * qz + qw * qy)},
+        {2.0f * (qx * qy + qw * qz), 1.0f - 2.0f * (qx * qx + qz * qz), 2.0f * (qy * qz - qw * qx)},
+        {2.0f * (qx * qz - qw * qy), 2.0f * (qy * qz + qw * qx), 1.0f - 2.0f * (qx * qx + qy * qy)},
+    };
+    float M[3][3], cov3[3][3];
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c) M[r][c] = R[r][c] * s.scale[c] * p.splatScale;
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c) cov3[r][c] = M[r][0] * M[c][0] + M[r][1] * M[c][1] + M[r][2] * M[c][2];
+
+    // Jacobian of the perspective divide, with off-center positions clamped
+    float fx = P[0] * p.width * 0.5f, fy = P[5] * p.height * 0.5f;
+    float d = -t[2];
+    float tanX = 1.3f * 0.5f * p.width / fx, tanY = 1.3f * 0.5f * p.height / fy;
+    float jx = std::min(std::max(t[0] / d, -tanX), tanX) * d;
+    float jy = std::min(std::max(t[1] / d, -tanY), tanY) * d;
+    float J[2][3] = {{fx / d, 0.0f, fx * jx / (d * d)}, {0.0f, fy / d, fy * jy / (d * d)}};
+    float T[2][3];
+    for (int r = 0; r < 2; ++r)
+        for (int c = 0; c < 3; ++c) T[r][c] = J[r][0] * v[c * 4] + J[r][1] * v[c * 4 + 1] + J[r][2] * v[c * 4 + 2];
+    float cov[2][2];
+    for (int r = 0; r < 2; ++r) {
+        for (int c = 0; c < 2; ++c) {
+            float sum = 0.0f;
+            for (int a = 0; a < 3; ++a)
+                for (int b = 0; b < 3; ++b) sum += T[r][a] * cov3[a][b] * T[c][b];
+            cov[r][c] = sum;
+        }
+    }
+
+    // low-pass: every splat covers at least about a pixel
+    float a = cov[0][0] + 0.3f, b = cov[0][1], c = cov[1][1] + 0.3f;
+    float det = a * c - b * b;
+    if (det <= 0.0f) return 0;
+
+    // axis-aligned box of the ellipse where alpha stays above 1/255
+    float radius = std::min(3.0f, sqrtf(2.0f * logf(255.0f * s.opacity)));
+    float ex = radius * sqrtf(a), ey = radius * sqrtf(c);
+    float cx = (clip[0] / clip[3] * 0.5f + 0.5f) * p.width;
+    float cy = (clip[1] / clip[3] * 0.5f + 0.5f) * p.height;
+    int lo[2] = {(int)floorf((cx - ex) / k_tileSize), (int)floorf((cy - ey) / k_tileSize)};
+    int hi[2] = {(int)floorf((cx + ex) / k_tileSize), (int)floorf((cy + ey) / k_tileSize)};
+    lo[0] = std::max(lo[0], 0);
+    lo[1] = std::max(lo[1], 0);
+    hi[0] = std::min(hi[0], (int)tilesX - 1);
+    hi[1] = std::min(hi[1], (int)tilesY - 1);
+    if (hi[0] < lo[0] || hi[1] < lo[1]) return 0;
+
+    out->center[0] = cx;
+    out->center[1] = cy;
+    out->conic[0] = c / det;
+    out->conic[1] = -b / det;
+    out->conic[2] = a / det;
+    sh_color(scene, i, eye, out->color);
+    out->color[3] = s.opacity;
+
+    // same association as the GPU sort's keys
+    float vz = (x * v[2] + y * v[6]) + (z * v[10] + v[14]);
+    uint32_t u;
+    memcpy(&u, &vz, sizeof(u));
+    out->key = u ^ ((u >> 31) * 0x7FFFFFFFu | 0x80000000u);
+
+    for (int k = 0; k < 2; ++k) {
+        out->tileMin[k] = (uint16_t)lo[k];
+        out->tileMax[k] = (uint16_t)hi[k];
+    }
+    return (uint32_t)(hi[0] - lo[0] + 1) * (uint32_t)(hi[1] - lo[1] + 1);
+}
+
+// Blend n splats of a tile over 8 pixels at (x0 + i + 0.5, y + 0.5), front
+// to back as tile_render.comp does. out gets straight rgb and coverage.
+static void blend_group(const TileScratch &s, size_t n, float x0, float y, float out[4][k_groupPixels])
+{
+    float C[3][k_groupPixels] = {}, T[k_groupPixels];
+    bool done[k_groupPixels];
+    int remaining = k_groupPixels;
+    for (int i = 0; i < k_groupPixels; ++i) {
+        T[i] = 1.0f;
+        done[i] = false;
+    }
+    float py = y + 0.5f;
+    for (size_t k = 0; k < n && remaining > 0; ++k) {
+        float dy = py - s.cy[k];
+        for (int i = 0; i < k_groupPixels; ++i) {
+            if (done[i]) continue;
+            float dx = x0 + (float)i + 0.5f - s.cx[k];
+            float power = -0.5f * (s.ca[k] * dx * dx + s.cc[k] * dy * dy) - s.cb[k] * dx * dy;
+            if (power > 0.0f) continue;
+            float alpha = std::min(0.99f, s.a[k] * expf(power));
+            if (alpha < 1.0f / 255.0f) continue;
+            float w = alpha * T[i];
+            C[0][i] += s.r[k] * w;
+            C[1][i] += s.g[k] * w;
+            C[2][i] += s.b[k] * w;
+            T[i] *= 1.0f - alpha;
+            if (T[i] < 1e-4f) {
+                done[i] = true;
+                --remaining;
+            }
+        }
+    }
+    for (int i = 0; i < k_groupPixels; ++i) {
+        float coverage = 1.0f - T[i];
+        for (int k = 0; k < 3; ++k) out[k][i] = coverage > 0.0f ? C[k][i] / coverage : 0.0f;
+        out[3][i] = coverage;
+    }
+}
+
+#ifdef CPU_RASTER_X86
+// exp(x) for x <= 0: 2^n * p(r), r in [-ln2/2, ln2/2], relative error ~2e-7
+TARGET_AVX2 static inline __m256 exp_avx2(__m256 x)
+{
+    x = _mm256_max_ps(x, _mm256_set1_ps(-87.0f));
+    __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504f)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+    __m256 p = _mm256_set1_ps(1.0f / 720.0f);
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 120.0f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 24.0f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 6.0f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(0.5f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+    __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+}
+
+// blend_group with one AVX2 lane per pixel.
+TARGET_AVX2 static void blend_group_avx2(const TileScratch &s, size_t n, float x0, float y,
+                                         float out[4][k_groupPixels])
+{
+    const __m256 px = _mm256_add_ps(_mm256_set1_ps(x0), _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f));
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    const __m256 maxAlpha = _mm256_set1_ps(0.99f), minAlpha = _mm256_set1_ps(1.0f / 255.0f);
+    const __m256 minT = _mm256_set1_ps(1e-4f), half = _mm256_set1_ps(-0.5f);
+    __m256 cr = zero, cg = zero, cb = zero, T = one;
+    __m256 done = zero; // all ones where finished
+    float py = y + 0.5f;
+    for (size_t k = 0; k < n; ++k) {
+        float dyS = py - s.cy[k];
+        __m256 dx = _mm256_sub_ps(px, _mm256_set1_ps(s.cx[k]));
+        __m256 dy = _mm256_set1_ps(dyS);
+        // -0.5 * (a dx^2 + c dy^2) - b dx dy
+        __m256 q = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_set1_ps(s.ca[k]), dx), dx,
+                                   _mm256_set1_ps(s.cc[k] * dyS * dyS));
+        __m256 power = _mm256_fnmadd_ps(_mm256_mul_ps(_mm256_set1_ps(s.cb[k]), dx), dy, _mm256_mul_ps(half, q));
+        __m256 live = _mm256_andnot_ps(done, _mm256_cmp_ps(power, zero, _CMP_LE_OQ));
+        if (_mm256_movemask_ps(live) == 0) continue;
+        __m256 alpha = _mm256_min_ps(maxAlpha, _mm256_mul_ps(_mm256_set1_ps(s.a[k]), exp_avx2(power)));
+        live = _mm256_and_ps(live, _mm256_cmp_ps(alpha, minAlpha, _CMP_GE_OQ));
+        if (_mm256_movemask_ps(live) == 0) continue;
+        __m256 w = _mm256_and_ps(live, _mm256_mul_ps(alpha, T));
+        cr = _mm256_fmadd_ps(_mm256_set1_ps(s.r[k]), w, cr);
+        cg = _mm256_fmadd_ps(_mm256_set1_ps(s.g[k]), w, cg);
+        cb = _mm256_fmadd_ps(_mm256_set1_ps(s.b[k]), w, cb);
+        T = _mm256_blendv_ps(T, _mm256_sub_ps(T, _mm256_mul_ps(T, alpha)), live);
+        done = _mm256_or_ps(done, _mm256_and_ps(live, _mm256_cmp_ps(T, minT, _CMP_LT_OQ)));
+        if (_mm256_movemask_ps(done) == 0xFF) break;
+    }
+    __m256 coverage = _mm256_sub_ps(one, T);
+    __m256 covered = _mm256_cmp_ps(coverage, zero, _CMP_GT_OQ);
+    __m256 inv = _mm256_and_ps(covered, _mm256_div_ps(one, _mm256_max_ps(coverage, _mm256_set1_ps(1e-30f))));
+    _mm256_storeu_ps(out[0], _mm256_mul_ps(cr, inv));
+    _mm256_storeu_ps(out[1], _mm256_mul_ps(cg, inv));
+    _mm256_storeu_ps(out[2], _mm256_mul_ps(cb, inv));
+    _mm256_storeu_ps(out[3], coverage);
+}
+#endif
+
+static uint8_t to_unorm8(float v)
+{
+    return (uint8_t)(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+// Sort tile t's list back to front; ties keep splat order, as in the
+// stable GPU sort.
+static void sort_tile(uint32_t t, TileScratch *scratch)
+{
+    uint32_t begin = g_tileStart[t], end = g_tileStart[t + 1];
+    if (end - begin < 2) return;
+    std::vector<uint64_t> &order = scratch->order;
+    order.resize(end - begin);
+    for (uint32_t j = begin; j < end; ++j)
+        order[j - begin] = (uint64_t)g_projected[g_entries[j]].key << 32 | g_entries[j];
+    std::sort(order.begin(), order.end());
+    for (uint32_t j = begin; j < end; ++j) g_entries[j] = (uint32_t)order[j - begin];
+}
+
+static void blend_tile(uint32_t t, const CpuRasterParams &p, uint32_t tilesX, bool simd, TileScratch *s,
+                       uint8_t *rgba)
+{
+    uint32_t begin = g_tileStart[t], end = g_tileStart[t + 1];
+    size_t n = end - begin;
+    std::vector<float> *arrays[9] = {&s->cx, &s->cy, &s->ca, &s->cb, &s->cc, &s->r, &s->g, &s->b, &s->a};
+    for (std::vector<float> *v : arrays)
+        if (v->size() < n) v->resize(n);
+    // the list is back to front, so walk it from the end
+    for (size_t k = 0; k < n; ++k) {
+        const Projected &q = g_projected[g_entries[end - 1 - k]];
+        s->cx[k] = q.center[0];
+        s->cy[k] = q.center[1];
+        s->ca[k] = q.conic[0];
+        s->cb[k] = q.conic[1];
+        s->cc[k] = q.conic[2];
+        s->r[k] = q.color[0];
+        s->g[k] = q.color[1];
+        s->b[k] = q.color[2];
+        s->a[k] = q.color[3];
+    }
+
+    int tx = (int)(t % tilesX) * k_tileSize, ty = (int)(t / tilesX) * k_tileSize;
+    float out[4][k_groupPixels];
+    for (int row = 0; row < k_tileSize; ++row) {
+        int y = ty + row;
+        if (y >= p.height) break;
+        for (int x0 = tx; x0 < tx + k_tileSize && x0 < p.width; x0 += k_groupPixels) {
+#ifdef CPU_RASTER_X86
+            if (simd) blend_group_avx2(*s, n, (float)x0, (float)y, out);
+            else blend_group(*s, n, (float)x0, (float)y, out);
+#else
+            (void)simd;
+            blend_group(*s, n, (float)x0, (float)y, out);
+#endif
+            for (int i = 0; i < k_groupPixels && x0 + i < p.width; ++i) {
+                uint8_t *px = rgba + ((size_t)y * p.width + x0 + i) * 4;
+                for (int k = 0; k < 4; ++k) px[k] = to_unorm8(out[k][i]);
+            }
+        }
+    }
+}
+
+bool cpu_raster_render(const CpuRasterScene &scene, const CpuRasterParams &p, uint8_t *rgba, CpuRasterStats *stats)
+{
+    if (!rgba || p.width <= 0 || p.height <= 0 || (scene.count > 0 && !scene.splats) || scene.count > 0xFFFFFFFFu)
+        return false;
+    auto t0 = std::chrono::steady_clock::now();
+    CpuRasterStats st;
+    st.tilesX = (uint32_t)((p.width + k_tileSize - 1) / k_tileSize);
+    st.tilesY = (uint32_t)((p.height + k_tileSize - 1) / k_tileSize);
+    if (st.tilesX > 65535 || st.tilesY > 65535) return false;
+    uint32_t tiles = st.tilesX * st.tilesY;
+    unsigned lanes = parallel_thread_count();
+    if (p.threads > 0) lanes = std::min(lanes, p.threads);
+    st.threads = lanes;
+    st.simd = cpu_raster_simd();
+    if (g_scratch.size() < lanes) g_scratch.resize(lanes);
+
+    // eye = -R^T t of the view matrix
+    const float *v = p.view;
+    float eye[3];
+    for (int k = 0; k < 3; ++k) eye[k] = -(v[k * 4] * v[12] + v[k * 4 + 1] * v[13] + v[k * 4 + 2] * v[14]);
+
+    // 1. project, each lane over a contiguous range, counting per tile
+    auto stage = std::chrono::steady_clock::now();
+    size_t count = scene.count;
+    g_projected.resize(count);
+    g_laneCounts.assign((size_t)lanes * tiles, 0);
+    std::vector<size_t> laneVisible(lanes, 0);
+    run_lanes(lanes, [&](unsigned lane) {
+        size_t begin = count * lane / lanes, end = count * (lane + 1) / lanes;
+        uint32_t *counts = &g_laneCounts[(size_t)lane * tiles];
+        for (size_t i = begin; i < end; ++i) {
+            Projected &q = g_projected[i];
+            if (project(scene, p, i, eye, st.tilesX, st.tilesY, &q) == 0) continue;
+            ++laneVisible[lane];
+            for (uint32_t y = q.tileMin[1]; y <= q.tileMax[1]; ++y)
+                for (uint32_t x = q.tileMin[0]; x <= q.tileMax[0]; ++x) ++counts[y * st.tilesX + x];
+        }
+    });
+    for (size_t n : laneVisible) st.visible += n;
+    st.projectMs = (float)ms_since(stage);
+
+    // 2. bin: tile-major offsets, lanes in order within a tile, so every
+    // tile's list starts out in splat order. Offsets are 32-bit, so a view
+    // with more (tile, splat) pairs than that (huge splats over many tiles)
+    // is refused rather than wrapped.
+    stage = std::chrono::steady_clock::now();
+    g_tileStart.resize(tiles + 1);
+    size_t total = 0;
+    for (uint32_t t = 0; t < tiles; ++t) {
+        g_tileStart[t] = (uint32_t)total;
+        for (unsigned lane = 0; lane < lanes; ++lane) {
+            uint32_t &c = g_laneCounts[(size_t)lane * tiles + t];
+            uint32_t n = c;
+            c = (uint32_t)total;
+            total += n;
+        }
+        if (total > 0xFFFFFFFFu) return false;
+    }
+    g_tileStart[tiles] = (uint32_t)total;
+    st.instances = total;
+    g_entries.resize(total);
+    run_lanes(lanes, [&](unsigned lane) {
+        size_t begin = count * lane / lanes, end = count * (lane + 1) / lanes;
+        uint32_t *cursor = &g_laneCounts[(size_t)lane * tiles];
+        for (size_t i = begin; i < end; ++i) {
+            const Projected &q = g_projected[i];
+            for (uint32_t y = q.tileMin[1]; y <= q.tileMax[1]; ++y)
+                for (uint32_t x = q.tileMin[0]; x <= q.tileMax[0]; ++x)
+                    g_entries[cursor[y * st.tilesX + x]++] = (uint32_t)i;
+        }
+    });
+    st.binMs = (float)ms_since(stage);
+
+    // 3 and 4: lanes take tiles from a shared counter, so dense tiles
+    // balance out
+    stage = std::chrono::steady_clock::now();
+    std::atomic<uint32_t> next{0};
+    run_lanes(lanes, [&](unsigned lane) {
+        for (uint32_t t; (t = next.fetch_add(1, std::memory_order_relaxed)) < tiles;) sort_tile(t, &g_scratch[lane]);
+    });
+    st.sortMs = (float)ms_since(stage);
+
+    stage = std::chrono::steady_clock::now();
+    next = 0;
+    run_lanes(lanes, [&](unsigned lane) {
+        for (uint32_t t; (t = next.fetch_add(1, std::memory_order_relaxed)) < tiles;)
+            blend_tile(t, p, st.tilesX, st.simd, &g_scratch[lane], rgba);
+    });
+    st.blendMs = (float)ms_since(stage);
+
+    st.totalMs = (float)ms_since(t0);
+    if (stats) *stats = st;
+    return true;
+}
+
+void cpu_raster_release()
+{
+    std::vector<Projected>().swap(g_projected);
+    std::vector<uint32_t>().swap(g_laneCounts);
+    std::vector<uint32_t>().swap(g_tileStart);
+    std::vector<uint32_t>().swap(g_entries);
+    std::vector<TileScratch>().swap(g_scratch);
+}
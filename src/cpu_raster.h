@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "splat.h"
+
+// Reference splat renderer on the CPU alone, with no GL: the same pipeline
+// as the tile engine (tile_raster.h), in full float precision.
+//   1. project every splat to a screen-space center, conic and color
+//      (view-dependent, from its SH bands) and count the 16x16 tiles its
+//      bounding box overlaps
+//   2. bin splat indices per tile
+//   3. sort every tile's list by depth
+//   4. blend each tile front to back, stopping once its pixels are opaque
+// Every step is split across up to `threads` threads of the parallel_for
+// pool, steps 3 and 4 by tile. Blending runs 8 pixels at a time with AVX2
+// and FMA where the CPU has them, otherwise with the same scalar math.
+//
+// It renders on machines with no usable GL, is the golden image GPU paths
+// are compared against, and is the throughput baseline of gsgl_bench.
+
+struct CpuRasterScene {
+    const GpuSplat *splats = nullptr;
+    const float *shRest = nullptr; // SPLAT_SH_REST_FLOATS per splat, or null
+    int shDegree = 0;              // bands of shRest to evaluate (0..3)
+    size_t count = 0;
+};
+
+struct CpuRasterParams {
+    float view[16], proj[16]; // column-major
+    int width = 0, height = 0;
+    float splatScale = 1.0f;  // as in the raster engine
+    unsigned threads = 0;     // 0: every thread of the pool
+};
+
+struct CpuRasterStats {
+    float projectMs = 0.0f, binMs = 0.0f, sortMs = 0.0f, blendMs = 0.0f, totalMs = 0.0f;
+    size_t visible = 0;   // splats that reach a tile
+    size_t instances = 0; // (tile, splat) pairs
+    uint32_t tilesX = 0, tilesY = 0;
+    unsigned threads = 0; // threads the frame was split across
+    bool simd = false;    // AVX2 blending
+};
+
+// Render the scene into `rgba` (width * height * 4 bytes, bottom row first):
+// straight color with alpha = coverage, like the tile engine's image, to be
+// composited over the background. Returns false on invalid parameters, or
+// when the view covers more than 2^32 - 1 (tile, splat) pairs.
+bool cpu_raster_render(const CpuRasterScene &scene, const CpuRasterParams &params, uint8_t *rgba,
+                       CpuRasterStats *stats);
+
+// Whether blending uses AVX2 on this CPU.
+bool cpu_raster_simd();
+
+// Free the per-frame working memory.
+void cpu_raster_release();
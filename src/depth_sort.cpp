@@ -0,0 +1,316 @@
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include "depth_sort.h"
+#include "parallel.h"
+#include "profiler.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DEPTH_SORT_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DEPTH_SORT_SSE2 1
+#endif
+
+static const size_t k_keyGrain = 1 << 15;
+static const size_t k_minBlock = 1 << 14; // below this a block is not worth a thread
+
+static double ms_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// IEEE float -> uint32 with the same ordering (negatives flipped entirely).
+static inline uint32_t sortable_bits(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, 4);
+    uint32_t mask = (uint32_t)((int32_t)u >> 31) | 0x80000000u;
+    return u ^ mask;
+}
+
+static inline uint32_t depth_key(const float view[16], float x, float y, float z)
+{
+    // view-space z is negative in front of the camera, so ascending z is far-to-near.
+    // Same association as the SIMD paths so every path produces identical keys.
+    return sortable_bits((x * view[2] + y * view[6]) + (z * view[10] + view[14]));
+}
+
+static void keys_range(const float *x, const float *y, const float *z, size_t begin, size_t end,
+                       const float view[16], uint32_t *keys)
+{
+    size_t i = begin;
+#if defined(DEPTH_SORT_AVX2)
+    const __m256 r0 = _mm256_set1_ps(view[2]), r1 = _mm256_set1_ps(view[6]);
+    const __m256 r2 = _mm256_set1_ps(view[10]), r3 = _mm256_set1_ps(view[14]);
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+    for (; i + 8 <= end; i += 8) {
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(x + i), r0),
+                                               _mm256_mul_ps(_mm256_loadu_ps(y + i), r1)),
+                                 _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(z + i), r2), r3));
+        __m256i bits = _mm256_castps_si256(d);
+        __m256i mask = _mm256_or_si256(_mm256_srai_epi32(bits, 31), sign);
+        _mm256_storeu_si256((__m256i *)(keys + i), _mm256_xor_si256(bits, mask));
+    }
+#elif defined(DEPTH_SORT_SSE2)
+    const __m128 r0 = _mm_set1_ps(view[2]), r1 = _mm_set1_ps(view[6]);
+    const __m128 r2 = _mm_set1_ps(view[10]), r3 = _mm_set1_ps(view[14]);
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    for (; i + 4 <= end; i += 4) {
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(x + i), r0), _mm_mul_ps(_mm_loadu_ps(y + i), r1)),
+                              _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(z + i), r2), r3));
+        __m128i bits = _mm_castps_si128(d);
+        __m128i mask = _mm_or_si128(_mm_srai_epi32(bits, 31), sign);
+        _mm_storeu_si128((__m128i *)(keys + i), _mm_xor_si128(bits, mask));
+    }
+#endif
+    for (; i < end; ++i) keys[i] = depth_key(view, x[i], y[i], z[i]);
+}
+
+void depth_sort_keys(const float *x, const float *y, const float *z, size_t count,
+                     const float view[16], uint32_t *keys)
+{
+    parallel_for(count, k_keyGrain, [&](size_t begin, size_t end) {
+        PROFILE_ZONE("keys_chunk");
+        keys_range(x, y, z, begin, end, view, keys);
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Radix sort
+// ---------------------------------------------------------------------------
+
+static size_t block_count(size_t count)
+{
+    size_t blocks = parallel_thread_count();
+    size_t maxBlocks = (count + k_minBlock - 1) / k_minBlock;
+    if (blocks > maxBlocks) blocks = maxBlocks;
+    return blocks ? blocks : 1;
+}
+
+void radix_sort_pairs(std::vector<uint32_t> &keys, std::vector<uint32_t> &values,
+                      std::vector<uint32_t> &keysTmp, std::vector<uint32_t> &valuesTmp)
+{
+    const size_t count = keys.size();
+    if (count < 2) return;
+    keysTmp.resize(count);
+    valuesTmp.resize(count);
+
+    const size_t blocks = block_count(count);
+    const size_t grain = (count + blocks - 1) / blocks;
+    std::vector<uint32_t> hist(blocks * 256);
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t *srcK = keys.data();
+        const uint32_t *srcV = values.data();
+        uint32_t *dstK = keysTmp.data();
+        uint32_t *dstV = valuesTmp.data();
+
+        std::fill(hist.begin(), hist.end(), 0u);
+        parallel_for(count, grain, [&](size_t begin, size_t end) {
+            uint32_t *h = &hist[(begin / grain) * 256];
+            for (size_t i = begin; i < end; ++i) ++h[(srcK[i] >> shift) & 0xFF];
+        });
+
+        // exclusive scan in (digit, block) order keeps the sort stable
+        uint32_t sum = 0;
+        bool trivial = false;
+        for (int d = 0; d < 256; ++d) {
+            uint32_t digitTotal = 0;
+            for (size_t b = 0; b < blocks; ++b) {
+                uint32_t c = hist[b * 256 + d];
+                hist[b * 256 + d] = sum;
+                sum += c;
+                digitTotal += c;
+            }
+            if (digitTotal == count) trivial = true;
+        }
+        // every key shares this digit: the pass would be an identity copy
+        if (trivial) continue;
+
+        parallel_for(count, grain, [&](size_t begin, size_t end) {
+            PROFILE_ZONE("radix_scatter");
+            uint32_t *h = &hist[(begin / grain) * 256];
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t pos = h[(srcK[i] >> shift) & 0xFF]++;
+                dstK[pos] = srcK[i];
+                dstV[pos] = srcV[i];
+            }
+        });
+
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Temporal-coherence fast path
+// ---------------------------------------------------------------------------
+
+static bool camera_moved_little(const DepthSorter &s, const float view[16])
+{
+    if (!s.hasLast) return false;
+    for (int c = 0; c < 3; ++c) {
+        for (int r = 0; r < 3; ++r) {
+            if (fabsf(view[c * 4 + r] - s.lastView[c * 4 + r]) > s.maxRotationDelta) return false;
+        }
+    }
+    float dt = 0.0f;
+    for (int r = 0; r < 3; ++r) {
+        float d = view[12 + r] - s.lastView[12 + r];
+        dt += d * d;
+    }
+    return sqrtf(dt) <= s.maxTranslationDelta;
+}
+
+// Insertion sort of (keys, vals)[begin, end) that gives up after `budget` shifts.
+static bool insertion_sort_bounded(uint32_t *keys, uint32_t *vals, size_t begin, size_t end, size_t budget)
+{
+    size_t shifts = 0;
+    for (size_t i = begin + 1; i < end; ++i) {
+        uint32_t k = keys[i];
+        if (keys[i - 1] <= k) continue;
+        uint32_t v = vals[i];
+        size_t j = i;
+        while (j > begin && keys[j - 1] > k) {
+            keys[j] = keys[j - 1];
+            vals[j] = vals[j - 1];
+            --j;
+        }
+        shifts += i - j;
+        if (shifts > budget) return false;
+        keys[j] = k;
+        vals[j] = v;
+    }
+    return true;
+}
+
+static void merge_runs(const uint32_t *k, const uint32_t *v, size_t a, size_t mid, size_t b,
+                       uint32_t *outK, uint32_t *outV)
+{
+    size_t i = a, j = mid, o = a;
+    while (i < mid && j < b) {
+        if (k[j] < k[i]) {
+            outK[o] = k[j];
+            outV[o++] = v[j++];
+        } else {
+            outK[o] = k[i];
+            outV[o++] = v[i++];
+        }
+    }
+    while (i < mid) {
+        outK[o] = k[i];
+        outV[o++] = v[i++];
+    }
+    while (j < b) {
+        outK[o] = k[j];
+        outV[o++] = v[j++];
+    }
+}
+
+// Re-sort last frame's order using this frame's keys (in index order, in
+// keysTmp). Returns false, leaving keysTmp intact, when the order changed too much.
+static bool coherent_resort(DepthSorter *s)
+{
+    const size_t count = s->order.size();
+    uint32_t *keys = s->keys.data();
+    const uint32_t *byIndex = s->keysTmp.data();
+    const uint32_t *order = s->order.data();
+    parallel_for(count, k_keyGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) keys[i] = byIndex[order[i]];
+    });
+
+    const size_t blocks = block_count(count);
+    const size_t width = (count + blocks - 1) / blocks;
+    std::atomic<bool> failed{false};
+    parallel_for(count, width, [&](size_t begin, size_t end) {
+        if (failed.load(std::memory_order_relaxed)) return;
+        size_t budget = (size_t)(s->maxShiftsPerSplat * (float)(end - begin));
+        if (!insertion_sort_bounded(keys, s->order.data(), begin, end, budget))
+            failed.store(true, std::memory_order_relaxed);
+    });
+    if (failed.load()) return false;
+
+    // merge the sorted blocks pairwise; nearly sorted input keeps this linear
+    s->orderTmp.resize(count);
+    for (size_t run = width; run < count; run *= 2) {
+        size_t merges = (count + 2 * run - 1) / (2 * run);
+        const uint32_t *k = s->keys.data();
+        const uint32_t *v = s->order.data();
+        uint32_t *ok = s->keysTmp.data();
+        uint32_t *ov = s->orderTmp.data();
+        parallel_for(merges, 1, [&](size_t mb, size_t me) {
+            for (size_t m = mb; m < me; ++m) {
+                size_t a = m * 2 * run;
+                size_t mid = std::min(a + run, count);
+                size_t b = std::min(a + 2 * run, count);
+                merge_runs(k, v, a, mid, b, ok, ov);
+            }
+        });
+        s->keys.swap(s->keysTmp);
+        s->order.swap(s->orderTmp);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+void depth_sort_reset(DepthSorter *sorter)
+{
+    if (!sorter) return;
+    sorter->hasLast = false;
+    sorter->fastPathBackoff = 0;
+    sorter->order.clear();
+    sorter->stats = DepthSortStats();
+}
+
+const uint32_t *depth_sort(DepthSorter *s, const float *x, const float *y, const float *z,
+                           size_t count, const float view[16])
+{
+    if (!s) return nullptr;
+    s->stats = DepthSortStats();
+    s->stats.count = count;
+    if (count == 0) return nullptr;
+
+    if (s->order.size() != count) s->hasLast = false;
+
+    // a still camera keeps last frame's order as is
+    if (s->hasLast && memcmp(view, s->lastView, sizeof(s->lastView)) == 0) {
+        s->stats.reusedOrder = true;
+        s->stats.unchanged = true;
+        return s->order.data();
+    }
+
+    PROFILE_ZONE("depth_sort");
+    auto t0 = std::chrono::steady_clock::now();
+    s->keys.resize(count);
+    s->keysTmp.resize(count);
+    depth_sort_keys(x, y, z, count, view, s->keysTmp.data());
+    s->stats.keyMs = ms_since(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    // after a failed fix-up, skip the fast path for a few frames instead of
+    // paying for a doomed attempt every frame of a fast camera move
+    bool attempt = camera_moved_little(*s, view) && s->fastPathBackoff == 0;
+    if (s->fastPathBackoff > 0) --s->fastPathBackoff;
+    bool reused = attempt && coherent_resort(s);
+    if (attempt && !reused) s->fastPathBackoff = 8;
+    if (!reused) {
+        s->keys.swap(s->keysTmp);
+        s->order.resize(count);
+        uint32_t *order = s->order.data();
+        parallel_for(count, k_keyGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) order[i] = (uint32_t)i;
+        });
+        radix_sort_pairs(s->keys, s->order, s->keysTmp, s->orderTmp);
+    }
+    s->stats.sortMs = ms_since(t0);
+
+    memcpy(s->lastView, view, sizeof(s->lastView));
+    s->hasLast = true;
+    s->stats.reusedOrder = reused;
+    return s->order.data();
+}
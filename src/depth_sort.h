@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Back-to-front ordering of splats for alpha blending.
+//
+// Keys are view-space z mapped to order-preserving uint32 (ascending key =
+// farthest first) and sorted with a multithreaded LSD radix sort. When the
+// camera moved only slightly since the previous call, last frame's order is
+// re-keyed and repaired with a bounded insertion sort plus block merge.
+
+struct DepthSortStats {
+    size_t count = 0;
+    double keyMs = 0.0;
+    double sortMs = 0.0;
+    bool reusedOrder = false; // coherent fast path taken
+    bool unchanged = false;   // same view as last call; order returned untouched
+};
+
+struct DepthSorter {
+    // camera motion allowed for the fast path: largest change of any view
+    // rotation entry, and of the view translation (world units)
+    float maxRotationDelta = 0.05f;
+    float maxTranslationDelta = 0.05f;
+    // fast path gives up once insertion shifts exceed this many per splat
+    float maxShiftsPerSplat = 4.0f;
+
+    std::vector<uint32_t> keys, keysTmp;
+    std::vector<uint32_t> order, orderTmp;
+    float lastView[16] = {};
+    bool hasLast = false;
+    int fastPathBackoff = 0;
+    DepthSortStats stats;
+};
+
+// Forget the previous order (e.g. after loading a new scene).
+void depth_sort_reset(DepthSorter *sorter);
+
+// Sort `count` splats whose centers are given as SoA arrays for a
+// column-major view matrix. Returns the back-to-front index order, valid
+// until the next call.
+const uint32_t *depth_sort(DepthSorter *sorter, const float *x, const float *y, const float *z,
+                           size_t count, const float view[16]);
+
+// Sortable keys for centers [0, count) (SIMD, multithreaded).
+void depth_sort_keys(const float *x, const float *y, const float *z, size_t count,
+                     const float view[16], uint32_t *keys);
+
+// Stable multithreaded LSD radix sort of (key, value) pairs by key. The
+// result ends up in `keys`/`values`; the tmp vectors are scratch.
+void radix_sort_pairs(std::vector<uint32_t> &keys, std::vector<uint32_t> &values,
+                      std::vector<uint32_t> &keysTmp, std::vector<uint32_t> &valuesTmp);
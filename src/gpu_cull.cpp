@@ -0,0 +1,114 @@
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <algorithm>
+#include "gpu_cull.h"
+#include "gpu_readback.h"
+#include "shader.h"
+
+// must match shaders/splat_cull.comp
+static const uint32_t k_groupSize = 256;
+
+static GLuint g_cullProgram = 0;
+static GLint g_viewLoc = -1, g_projLoc = -1, g_focalLoc = -1, g_scaleLoc = -1, g_minRadiusLoc = -1;
+static GLint g_countLoc = -1, g_gatherLoc = -1;
+
+static GpuReadback g_visibleReadback;
+
+bool gpu_cull_alloc(GpuCullBuffers *b, size_t count)
+{
+    if (!b || count == 0) return false;
+    size_t bytes = count * sizeof(uint32_t);
+    bool ok = b->visible ? ssbo_resize(b->visible, bytes) : (b->visible = ssbo_alloc(bytes)) != 0;
+    if (ok && !b->args) {
+        GpuIndirectArgs args;
+        ok = (b->args = ssbo_alloc(sizeof(args), &args)) != 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "gpu_cull: failed to allocate buffers for %zu splats\n", count);
+        gpu_cull_free(b);
+        return false;
+    }
+    b->count = count;
+    return true;
+}
+
+void gpu_cull_free(GpuCullBuffers *b)
+{
+    if (!b) return;
+    ssbo_free(b->visible);
+    ssbo_free(b->args);
+    *b = GpuCullBuffers();
+}
+
+static void locate_uniforms()
+{
+    g_viewLoc = glGetUniformLocation(g_cullProgram, "uView");
+    g_projLoc = glGetUniformLocation(g_cullProgram, "uProj");
+    g_focalLoc = glGetUniformLocation(g_cullProgram, "uFocal");
+    g_scaleLoc = glGetUniformLocation(g_cullProgram, "uSplatScale");
+    g_minRadiusLoc = glGetUniformLocation(g_cullProgram, "uMinRadius");
+    g_countLoc = glGetUniformLocation(g_cullProgram, "uCount");
+    g_gatherLoc = glGetUniformLocation(g_cullProgram, "uGather");
+}
+
+bool gpu_cull_init()
+{
+    g_cullProgram = shader_begin_compute("shaders/splat_cull.comp");
+    if (!shader_finish(&g_cullProgram)) {
+        fprintf(stderr, "gpu_cull: failed to build the cull program\n");
+        return false;
+    }
+    locate_uniforms();
+    shader_watch(&g_cullProgram, locate_uniforms);
+
+    // culling works without it; only the visible count goes unreported
+    if (!gpu_readback_init(&g_visibleReadback))
+        fprintf(stderr, "gpu_cull: no readback buffer, visible counts unavailable\n");
+    return true;
+}
+
+void gpu_cull_run(const GpuCullBuffers &b, SsboHandle packed, SsboHandle candidates, size_t count,
+                  const GpuCullParams &params)
+{
+    if (!g_cullProgram || !b.args || count > b.count) return;
+
+    // an empty list and a zero-sized sort dispatch
+    GpuIndirectArgs reset;
+    ssbo_update(b.args, 0, &reset, sizeof(reset));
+    if (count > 0) {
+        glUseProgram(g_cullProgram);
+        glUniformMatrix4fv(g_viewLoc, 1, GL_FALSE, params.view);
+        glUniformMatrix4fv(g_projLoc, 1, GL_FALSE, params.proj);
+        glUniform1f(g_focalLoc, params.focal);
+        glUniform1f(g_scaleLoc, params.splatScale);
+        glUniform1f(g_minRadiusLoc, params.minPixelRadius);
+        glUniform1ui(g_countLoc, (GLuint)count);
+        glUniform1ui(g_gatherLoc, candidates ? 1u : 0u);
+        ssbo_bind(packed, 0);
+        // unused without candidates, but every declared block gets a buffer
+        ssbo_bind(candidates ? candidates : b.visible, 1);
+        ssbo_bind(b.visible, 2);
+        ssbo_bind_range(b.args, 7, 0, sizeof(GpuIndirectArgs));
+        glDispatchCompute(std::min<uint32_t>((uint32_t)((count + k_groupSize - 1) / k_groupSize), 65535u), 1, 1);
+        glUseProgram(0);
+    }
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // the count for gpu_cull_poll_visible
+    gpu_readback_copy(&g_visibleReadback, b.args, offsetof(GpuIndirectArgs, instanceCount));
+}
+
+bool gpu_cull_poll_visible(size_t *visible)
+{
+    return gpu_readback_poll(&g_visibleReadback, visible);
+}
+
+void gpu_cull_shutdown()
+{
+    gpu_readback_shutdown(&g_visibleReadback);
+    if (g_cullProgram) { glDeleteProgram(g_cullProgram); g_cullProgram = 0; }
+}
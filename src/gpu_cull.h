@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ssbo.h"
+#include "gpu_sort.h"
+
+// GPU-driven visibility ahead of the GPU sort.
+//
+// A compute pass tests every candidate splat against the view (centers
+// outside the vertex shader's clip guard, alpha below 1/255, optionally a
+// minimum projected size) and compacts the survivors into a visible list
+// with an atomic counter. The counter doubles as the instance count of a
+// DrawArraysIndirectCommand, and the pass also writes the sort's dispatch
+// size (GpuIndirectArgs), so the sort and the draw only ever touch visible
+// splats while the CPU never learns how many there are.
+
+struct GpuCullBuffers {
+    size_t count = 0;
+    SsboHandle visible = 0; // uint32[count], survivors in no particular order
+    SsboHandle args = 0;    // GpuIndirectArgs
+};
+
+// Allocate (or resize) buffers for culling up to `count` candidates.
+bool gpu_cull_alloc(GpuCullBuffers *buffers, size_t count);
+void gpu_cull_free(GpuCullBuffers *buffers);
+
+// Compile the cull program. Returns false if it fails to build.
+bool gpu_cull_init();
+
+struct GpuCullParams {
+    float view[16], proj[16]; // column-major
+    float focal = 1.0f;       // vertical focal length in pixels
+    float splatScale = 1.0f;  // as in the raster engine
+    float minPixelRadius = 0.0f; // splats smaller than this on screen are dropped (0: none)
+};
+
+// Cull `count` PackedSplats, or with `candidates` set, the `count` splat
+// indices it lists (an LOD cut), into buffers.visible and buffers.args.
+// Issues the barriers the indirect sort and draw need.
+void gpu_cull_run(const GpuCullBuffers &buffers, SsboHandle packed, SsboHandle candidates, size_t count,
+                  const GpuCullParams &params);
+
+// Visible count of the newest culled frame the GPU has finished, read
+// without waiting for it. Returns false while none has finished since the
+// last call.
+bool gpu_cull_poll_visible(size_t *visible);
+
+void gpu_cull_shutdown();
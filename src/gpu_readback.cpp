@@ -0,0 +1,73 @@
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include "gpu_readback.h"
+
+bool gpu_readback_init(GpuReadback *rb)
+{
+    if (!rb) return false;
+    gpu_readback_shutdown(rb);
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, GPU_READBACK_SLOTS * sizeof(uint32_t), nullptr, flags);
+    rb->data = (const volatile uint32_t *)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0,
+                                                           GPU_READBACK_SLOTS * sizeof(uint32_t), flags);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    rb->buffer = buffer;
+    return rb->data != nullptr;
+}
+
+void gpu_readback_copy(GpuReadback *rb, SsboHandle source, size_t offset)
+{
+    int slot = rb->nextSlot;
+    if (!rb->data || rb->fences[slot]) return;
+    glBindBuffer(GL_COPY_READ_BUFFER, ssbo_buffer(source));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, rb->buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)(ssbo_offset(source) + offset),
+                        (GLintptr)(slot * sizeof(uint32_t)), sizeof(uint32_t));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    rb->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    rb->serials[slot] = ++rb->copies;
+    rb->nextSlot = (slot + 1) % GPU_READBACK_SLOTS;
+}
+
+bool gpu_readback_poll(GpuReadback *rb, size_t *value)
+{
+    bool found = false;
+    for (int i = 0; i < GPU_READBACK_SLOTS; ++i) {
+        GLsync fence = (GLsync)rb->fences[i];
+        if (!fence) continue;
+        GLint status = GL_UNSIGNALED;
+        glGetSynciv(fence, GL_SYNC_STATUS, 1, nullptr, &status);
+        if (status != GL_SIGNALED) continue;
+        glDeleteSync(fence);
+        rb->fences[i] = nullptr;
+        // slots finish in order, but a poll can see several at once
+        if (rb->serials[i] > rb->newestRead) {
+            rb->newestRead = rb->serials[i];
+            *value = rb->data[i];
+            found = true;
+        }
+    }
+    return found;
+}
+
+void gpu_readback_shutdown(GpuReadback *rb)
+{
+    if (!rb) return;
+    for (int i = 0; i < GPU_READBACK_SLOTS; ++i) {
+        if (rb->fences[i]) glDeleteSync((GLsync)rb->fences[i]);
+    }
+    if (rb->buffer) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, rb->buffer);
+        if (rb->data) glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        GLuint buffer = rb->buffer;
+        glDeleteBuffers(1, &buffer);
+    }
+    *rb = GpuReadback();
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ssbo.h"
+
+// Small counters read back from the GPU without stalling it.
+//
+// Each copy moves one uint32 from a storage buffer into a slot of a
+// persistently mapped ring a few frames deep, like the profiler's queries,
+// and fences it. Polling returns the newest copy the GPU has finished, so
+// stats such as the cull's visible count arrive a frame or two late but
+// never cost a glFinish.
+
+constexpr int GPU_READBACK_SLOTS = 4;
+
+struct GpuReadback {
+    uint32_t buffer = 0;                       // GL buffer of the ring
+    const volatile uint32_t *data = nullptr;   // its persistent mapping
+    void *fences[GPU_READBACK_SLOTS] = {};     // GLsync per slot in flight
+    uint64_t serials[GPU_READBACK_SLOTS] = {}; // copy number per slot
+    uint64_t copies = 0, newestRead = 0;
+    int nextSlot = 0;
+};
+
+// Create and map the ring. Returns false when the driver can't map it; the
+// readback then stays empty and polls never find a value.
+bool gpu_readback_init(GpuReadback *readback);
+
+// Copy the uint32 at byte `offset` of `source` into the next slot, after
+// the commands issued so far. Skipped while that slot's last copy is still
+// in flight. Call after the barrier that makes the value visible to copies.
+void gpu_readback_copy(GpuReadback *readback, SsboHandle source, size_t offset);
+
+// The newest finished copy, read without waiting. Returns false while none
+// has finished since the last call.
+bool gpu_readback_poll(GpuReadback *readback, size_t *value);
+
+void gpu_readback_shutdown(GpuReadback *readback);
@@ -0,0 +1,388 @@
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "gpu_sort.h"
+#include "depth_sort.h"
+#include "parallel.h"
+#include "shader.h"
+#include "splat.h"
+#include "ssbo.h"
+
+// must match the compute shaders
+static const uint32_t k_groupSize = 256;
+static const uint32_t k_blockKeys = 256 * 8;
+// values per group of the scan's reduce and downsweep, and at most this
+// many groups (the scan of their sums runs in one group)
+static const uint32_t k_scanSpan = 256 * 8;
+static const uint32_t k_scanMaxGroups = 4096;
+
+static GLuint g_keysProgram = 0, g_histProgram = 0, g_scanProgram = 0, g_scatterProgram = 0;
+static GLint g_keysViewZLoc = -1, g_keysCountLoc = -1, g_keysGatherLoc = -1, g_keysIndirectLoc = -1;
+static GLint g_histCountLoc = -1, g_histShiftLoc = -1, g_histBlocksLoc = -1, g_histIndirectLoc = -1;
+static GLint g_scanCountLoc = -1, g_scanIndirectLoc = -1, g_scanPhaseLoc = -1, g_scanGroupsLoc = -1;
+static GLint g_scatterCountLoc = -1, g_scatterShiftLoc = -1, g_scatterBlocksLoc = -1, g_scatterIndirectLoc = -1;
+static SsboHandle g_scanSums = 0; // uint32[k_scanMaxGroups + 1]
+
+static uint32_t block_count(size_t count)
+{
+    return (uint32_t)((count + k_blockKeys - 1) / k_blockKeys);
+}
+
+bool gpu_sort_alloc(GpuSortBuffers *b, size_t count)
+{
+    if (!b || count == 0) return false;
+    size_t bytes = count * sizeof(uint32_t);
+    size_t histBytes = ((size_t)256 * block_count(count) + 1) * sizeof(uint32_t);
+    SsboHandle *handles[4] = {&b->orderTmp, &b->keys, &b->keysTmp, &b->hist};
+    size_t sizes[4] = {bytes, bytes, bytes, histBytes};
+    for (int i = 0; i < 4; ++i) {
+        bool ok = *handles[i] ? ssbo_resize(*handles[i], sizes[i]) : (*handles[i] = ssbo_alloc(sizes[i])) != 0;
+        if (!ok) {
+            fprintf(stderr, "gpu_sort: failed to allocate scratch for %zu splats\n", count);
+            gpu_sort_free(b);
+            return false;
+        }
+    }
+    b->count = count;
+    return true;
+}
+
+void gpu_sort_free(GpuSortBuffers *b)
+{
+    if (!b) return;
+    ssbo_free(b->orderTmp);
+    ssbo_free(b->keys);
+    ssbo_free(b->keysTmp);
+    ssbo_free(b->hist);
+    *b = GpuSortBuffers();
+}
+
+static void locate_uniforms()
+{
+    g_keysViewZLoc = glGetUniformLocation(g_keysProgram, "uViewZ");
+    g_keysCountLoc = glGetUniformLocation(g_keysProgram, "uCount");
+    g_keysGatherLoc = glGetUniformLocation(g_keysProgram, "uGather");
+    g_keysIndirectLoc = glGetUniformLocation(g_keysProgram, "uIndirect");
+    g_histCountLoc = glGetUniformLocation(g_histProgram, "uCount");
+    g_histShiftLoc = glGetUniformLocation(g_histProgram, "uShift");
+    g_histBlocksLoc = glGetUniformLocation(g_histProgram, "uNumBlocks");
+    g_histIndirectLoc = glGetUniformLocation(g_histProgram, "uIndirect");
+    g_scanCountLoc = glGetUniformLocation(g_scanProgram, "uCount");
+    g_scanIndirectLoc = glGetUniformLocation(g_scanProgram, "uIndirect");
+    g_scanPhaseLoc = glGetUniformLocation(g_scanProgram, "uPhase");
+    g_scanGroupsLoc = glGetUniformLocation(g_scanProgram, "uGroups");
+    g_scatterCountLoc = glGetUniformLocation(g_scatterProgram, "uCount");
+    g_scatterShiftLoc = glGetUniformLocation(g_scatterProgram, "uShift");
+    g_scatterBlocksLoc = glGetUniformLocation(g_scatterProgram, "uNumBlocks");
+    g_scatterIndirectLoc = glGetUniformLocation(g_scatterProgram, "uIndirect");
+}
+
+bool gpu_sort_init()
+{
+    // all four build in parallel where the driver can
+    g_keysProgram = shader_begin_compute("shaders/sort_keys.comp");
+    g_histProgram = shader_begin_compute("shaders/sort_histogram.comp");
+    g_scanProgram = shader_begin_compute("shaders/sort_scan.comp");
+    g_scatterProgram = shader_begin_compute("shaders/sort_scatter.comp");
+    bool ok = shader_finish(&g_keysProgram);
+    ok = shader_finish(&g_histProgram) && ok;
+    ok = shader_finish(&g_scanProgram) && ok;
+    ok = shader_finish(&g_scatterProgram) && ok;
+    if (ok && !(g_scanSums = ssbo_alloc((k_scanMaxGroups + 1) * sizeof(uint32_t)))) ok = false;
+    if (!ok) {
+        fprintf(stderr, "gpu_sort: failed to build the sort programs\n");
+        gpu_sort_shutdown();
+        return false;
+    }
+
+    locate_uniforms();
+    shader_watch(&g_keysProgram, locate_uniforms);
+    shader_watch(&g_histProgram, locate_uniforms);
+    shader_watch(&g_scanProgram, locate_uniforms);
+    shader_watch(&g_scatterProgram, locate_uniforms);
+    return true;
+}
+
+// The three scan dispatches over the values bound at 5: `count` of them,
+// or with `indirect` set, as many as the histogram of the instance count
+// bound at 7 holds (at most `count`).
+static void scan_passes(size_t count, GLuint indirect)
+{
+    uint32_t groups = (uint32_t)std::min<size_t>((count + k_scanSpan - 1) / k_scanSpan, k_scanMaxGroups);
+    ssbo_bind(g_scanSums, 6);
+    glUseProgram(g_scanProgram);
+    glUniform1ui(g_scanCountLoc, (GLuint)count);
+    glUniform1ui(g_scanIndirectLoc, indirect);
+    glUniform1ui(g_scanGroupsLoc, std::max(groups, 1u));
+    for (GLuint phase = 0; phase < 3; ++phase) {
+        glUniform1ui(g_scanPhaseLoc, phase);
+        glDispatchCompute(phase == 1 ? 1 : std::max(groups, 1u), 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+}
+
+void gpu_sort_scan(SsboHandle values, size_t count)
+{
+    if (!g_scanProgram || count == 0) return;
+    ssbo_bind_range(values, 5, 0, (count + 1) * sizeof(uint32_t));
+    scan_passes(count, 0u);
+    glUseProgram(0);
+}
+
+// Dispatch `groups` workgroups, or with `args` set, as many as the cull
+// pass wrote into it.
+static void dispatch(uint32_t groups, SsboHandle args)
+{
+    if (args) glDispatchComputeIndirect((GLintptr)(ssbo_offset(args) + offsetof(GpuIndirectArgs, groups)));
+    else glDispatchCompute(groups, 1, 1);
+}
+
+// The radix passes over `count` pairs, or with `args` set, over its
+// instance count (at most `count`); the dispatch buffer is then bound.
+static void sort_passes(const GpuSortBuffers &b, SsboHandle keys, SsboHandle values, size_t count, int passes,
+                        SsboHandle args)
+{
+    size_t bytes = count * sizeof(uint32_t);
+    uint32_t blocks = block_count(count);
+    GLuint indirect = args ? 1u : 0u;
+
+    ssbo_bind_range(b.hist, 5, 0, ((size_t)256 * blocks + 1) * sizeof(uint32_t));
+    for (int pass = 0; pass < passes; ++pass) {
+        // even passes read A and write B, odd passes the reverse, so after
+        // an even number of passes the result is back in A
+        bool fromA = (pass & 1) == 0;
+        ssbo_bind_range(fromA ? values : b.orderTmp, 1, 0, bytes);
+        ssbo_bind_range(fromA ? b.orderTmp : values, 2, 0, bytes);
+        ssbo_bind_range(fromA ? keys : b.keysTmp, 3, 0, bytes);
+        ssbo_bind_range(fromA ? b.keysTmp : keys, 4, 0, bytes);
+        uint32_t shift = (uint32_t)pass * 8;
+
+        glUseProgram(g_histProgram);
+        glUniform1ui(g_histCountLoc, (GLuint)count);
+        glUniform1ui(g_histShiftLoc, shift);
+        glUniform1ui(g_histBlocksLoc, blocks);
+        glUniform1ui(g_histIndirectLoc, indirect);
+        dispatch(blocks, args);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        scan_passes((size_t)256 * blocks, indirect);
+
+        glUseProgram(g_scatterProgram);
+        glUniform1ui(g_scatterCountLoc, (GLuint)count);
+        glUniform1ui(g_scatterShiftLoc, shift);
+        glUniform1ui(g_scatterBlocksLoc, blocks);
+        glUniform1ui(g_scatterIndirectLoc, indirect);
+        dispatch(blocks, args);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+    glUseProgram(0);
+}
+
+void gpu_sort_pairs(const GpuSortBuffers &b, SsboHandle keys, SsboHandle values, size_t count, int passes)
+{
+    if (!g_histProgram || count == 0 || count > b.count || passes <= 0 || passes > 4 || (passes & 1)) return;
+    sort_passes(b, keys, values, count, passes, 0);
+}
+
+// `count` entries, or with `args` set, its instance count of at most `count`.
+static void sort_run(const GpuSortBuffers &b, SsboHandle splats, SsboHandle order, size_t count, bool gather,
+                     SsboHandle args, const float view[16])
+{
+    if (!g_keysProgram || count == 0 || count > b.count) return;
+
+    size_t bytes = count * sizeof(uint32_t);
+    if (args) {
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, ssbo_buffer(args));
+        ssbo_bind_range(args, 7, 0, sizeof(GpuIndirectArgs));
+    }
+
+    // keys (and identity indices unless gathering), then a full 32-bit sort in place
+    glUseProgram(g_keysProgram);
+    glUniform4f(g_keysViewZLoc, view[2], view[6], view[10], view[14]);
+    glUniform1ui(g_keysCountLoc, (GLuint)count);
+    glUniform1ui(g_keysGatherLoc, gather ? 1u : 0u);
+    glUniform1ui(g_keysIndirectLoc, args ? 1u : 0u);
+    ssbo_bind(splats, 0);
+    ssbo_bind_range(order, 2, 0, bytes);
+    ssbo_bind_range(b.keys, 4, 0, bytes);
+    // the keys loop over the count, so the sort's block dispatch covers them too
+    uint32_t keyGroups = std::min<uint32_t>((uint32_t)((count + k_groupSize - 1) / k_groupSize), 65535u);
+    dispatch(keyGroups, args);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    sort_passes(b, b.keys, order, count, 4, args);
+    if (args) glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+}
+
+void gpu_sort_run(const GpuSortBuffers &b, SsboHandle splats, SsboHandle order, const float view[16])
+{
+    sort_run(b, splats, order, b.count, false, 0, view);
+}
+
+void gpu_sort_run_indices(const GpuSortBuffers &b, SsboHandle splats, SsboHandle order, size_t count,
+                          const float view[16])
+{
+    sort_run(b, splats, order, count, true, 0, view);
+}
+
+void gpu_sort_run_indirect(const GpuSortBuffers &b, SsboHandle splats, SsboHandle order, SsboHandle args,
+                           const float view[16])
+{
+    if (!args) return;
+    sort_run(b, splats, order, b.count, true, args, view);
+}
+
+static double ms_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+bool gpu_sort_selftest(size_t count, int iterations)
+{
+    if (count == 0 || count > 0xFFFFFFFFu || iterations < 1) return false;
+    if (!g_keysProgram && !gpu_sort_init()) return false;
+
+    // random centers in a box, viewed from outside it
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> u(-10.0f, 10.0f);
+    std::vector<float> x(count), y(count), z(count);
+    for (size_t i = 0; i < count; ++i) {
+        x[i] = u(rng);
+        y[i] = u(rng);
+        z[i] = u(rng);
+    }
+
+    // a slightly rotated camera 30 units out, so keys use every matrix term
+    float view[16] = {0.8f, 0.36f, -0.48f, 0.0f,
+                      0.0f, 0.8f, 0.6f, 0.0f,
+                      0.6f, -0.48f, 0.64f, 0.0f,
+                      0.3f, -0.2f, -30.0f, 1.0f};
+
+    // CPU reference: full radix sort every time (a new sorter per run so
+    // the coherent fast path never kicks in)
+    const uint32_t *cpuOrder = nullptr;
+    double cpuMs = 0.0;
+    DepthSorter sorter;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; ++it) {
+        depth_sort_reset(&sorter);
+        t0 = std::chrono::steady_clock::now();
+        cpuOrder = depth_sort(&sorter, x.data(), y.data(), z.data(), count, view);
+        cpuMs += ms_since(t0);
+    }
+    cpuMs /= iterations;
+
+    SsboHandle splatBuffer = ssbo_alloc(count * sizeof(GpuSplat));
+    SsboHandle orderBuffer = ssbo_alloc(count * sizeof(uint32_t));
+    GpuSortBuffers scratch;
+    GpuSplat *splats = splatBuffer ? (GpuSplat *)ssbo_map(splatBuffer) : nullptr;
+    if (splats) {
+        for (size_t i = 0; i < count; ++i) {
+            GpuSplat s = {};
+            s.position[0] = x[i];
+            s.position[1] = y[i];
+            s.position[2] = z[i];
+            splats[i] = s;
+        }
+    }
+    if (!splats || !ssbo_unmap(splatBuffer) || !orderBuffer || !gpu_sort_alloc(&scratch, count)) {
+        ssbo_free(splatBuffer);
+        ssbo_free(orderBuffer);
+        return false;
+    }
+
+    // the timer query is what the GPU spent; wall time also covers
+    // submission and is the only number on drivers (llvmpipe) that don't
+    // time compute work. Those report no counter bits, no result, or one
+    // that can't be the sort: llvmpipe returns 1 ns, or garbage far beyond
+    // the wall time around it. Any such result prints as n/a; a real GPU
+    // time falls between 1% and 100% of the wall time.
+    GLint timerBits = 0;
+    glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &timerBits);
+    bool timerValid = timerBits > 0;
+    GLuint query = 0;
+    if (timerValid) glGenQueries(1, &query);
+    double gpuMs = 0.0, wallMs = 0.0;
+    glFinish();
+    for (int it = 0; it < iterations; ++it) {
+        t0 = std::chrono::steady_clock::now();
+        if (query) glBeginQuery(GL_TIME_ELAPSED, query);
+        gpu_sort_run(scratch, splatBuffer, orderBuffer, view);
+        if (query) glEndQuery(GL_TIME_ELAPSED);
+        glFinish();
+        double iterationMs = ms_since(t0);
+        wallMs += iterationMs;
+        if (!timerValid) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        GLuint64 ns = 0;
+        if (available) glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+        double timerMs = ns / 1e6;
+        timerValid = available && timerMs >= iterationMs * 0.01 && timerMs <= iterationMs;
+        gpuMs += timerMs;
+    }
+    gpuMs /= iterations;
+    wallMs /= iterations;
+    if (query) glDeleteQueries(1, &query);
+
+    // what the CPU path pays on top of its sort: pushing the order to the GPU
+    t0 = std::chrono::steady_clock::now();
+    ssbo_update(scratch.orderTmp, 0, cpuOrder, count * sizeof(uint32_t));
+    glFinish();
+    double uploadMs = ms_since(t0);
+
+    std::vector<uint32_t> gpuOrder(count), gpuKeys(count);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    ssbo_read(orderBuffer, 0, gpuOrder.data(), count * sizeof(uint32_t));
+    ssbo_read(scratch.keys, 0, gpuKeys.data(), count * sizeof(uint32_t));
+    gpu_sort_free(&scratch);
+    ssbo_free(splatBuffer);
+    ssbo_free(orderBuffer);
+
+    std::vector<uint32_t> cpuKeys(count);
+    depth_sort_keys(x.data(), y.data(), z.data(), count, view, cpuKeys.data());
+
+    // the GPU result must be a permutation, sorted by the CPU's keys, and
+    // (both sorts being stable) identical to the CPU order
+    std::vector<uint8_t> seen(count, 0);
+    size_t notPermutation = 0, keyMismatch = 0, unsorted = 0, orderMismatch = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t v = gpuOrder[i];
+        if (v >= count || seen[v]) {
+            ++notPermutation;
+            continue;
+        }
+        seen[v] = 1;
+        if (gpuKeys[i] != cpuKeys[v]) ++keyMismatch;
+        if (i > 0 && gpuOrder[i - 1] < count && cpuKeys[gpuOrder[i - 1]] > cpuKeys[v]) ++unsorted;
+        if (v != cpuOrder[i]) ++orderMismatch;
+    }
+    bool ok = notPermutation == 0 && keyMismatch == 0 && unsorted == 0 && orderMismatch == 0;
+
+    printf("gpu_sort: %zu splats, %d iterations\n", count, iterations);
+    if (timerValid) printf("  gpu radix      %8.2f ms wall, %.2f ms timer query\n", wallMs, gpuMs);
+    else printf("  gpu radix      %8.2f ms wall, n/a timer query\n", wallMs);
+    printf("  cpu radix      %8.2f ms (%u threads) + %.2f ms index upload\n", cpuMs,
+           parallel_thread_count(), uploadMs);
+    printf("  check          %s (bad indices %zu, key mismatches %zu, out of order %zu, differs from cpu %zu)\n",
+           ok ? "PASS" : "FAIL", notPermutation, keyMismatch, unsorted, orderMismatch);
+    return ok;
+}
+
+void gpu_sort_shutdown()
+{
+    if (g_keysProgram) { glDeleteProgram(g_keysProgram); g_keysProgram = 0; }
+    if (g_histProgram) { glDeleteProgram(g_histProgram); g_histProgram = 0; }
+    if (g_scanProgram) { glDeleteProgram(g_scanProgram); g_scanProgram = 0; }
+    if (g_scatterProgram) { glDeleteProgram(g_scatterProgram); g_scatterProgram = 0; }
+    ssbo_free(g_scanSums);
+    g_scanSums = 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ssbo.h"
+
+// Back-to-front splat ordering entirely on the GPU.
+//
+// A compute pipeline over storage buffers: one pass writes
+// sortable view-depth keys (same mapping as depth_sort) and identity
+// indices, then four 8-bit LSD radix passes each run a per-block digit
+// histogram, a global exclusive scan (two-level, see gpu_sort_scan) and a
+// stable scatter. After the fourth pass the sorted indices are back in the
+// draw order buffer, so the draw consumes them without any CPU round trip.
+
+// Scratch buffers for sorting `count` splats.
+struct GpuSortBuffers {
+    size_t count = 0;
+    SsboHandle orderTmp = 0; // uint32[count], ping-pong with the draw order
+    SsboHandle keys = 0;     // uint32[count]
+    SsboHandle keysTmp = 0;  // uint32[count]
+    SsboHandle hist = 0;     // uint32[256 * blocks + 1]
+};
+
+// Arguments the GPU writes for itself (gpu_cull.h): a
+// DrawArraysIndirectCommand for the splat quads, followed by the
+// DispatchIndirectCommand of the sort passes (one group per 2048 keys).
+struct GpuIndirectArgs {
+    uint32_t vertexCount = 4;
+    uint32_t instanceCount = 0; // splats to sort and draw
+    uint32_t firstVertex = 0;
+    uint32_t baseInstance = 0;
+    uint32_t groups[3] = {0, 1, 1};
+};
+
+// Allocate (or resize) scratch for sorting up to `count` elements.
+bool gpu_sort_alloc(GpuSortBuffers *buffers, size_t count);
+void gpu_sort_free(GpuSortBuffers *buffers);
+
+// Compile the sort programs. Returns false if compute shaders fail to build.
+bool gpu_sort_init();
+
+// Write the back-to-front order of `splats` (GpuSplat[count]) into `order`
+// (uint32[count]) for a column-major view matrix. Issues the barrier needed
+// before the draw reads `order`.
+void gpu_sort_run(const GpuSortBuffers &buffers, SsboHandle splats, SsboHandle order, const float view[16]);
+
+// Like gpu_sort_run, but sorts the `count` splat indices already in `order`
+// (a subset such as an LOD cut) instead of all splats.
+void gpu_sort_run_indices(const GpuSortBuffers &buffers, SsboHandle splats, SsboHandle order, size_t count,
+                          const float view[16]);
+
+// Like gpu_sort_run_indices for a count only the GPU knows: the instance
+// count of the GpuIndirectArgs in `args`, at most the scratch size. Every
+// pass is dispatched indirectly, so the CPU never waits for the count.
+void gpu_sort_run_indirect(const GpuSortBuffers &buffers, SsboHandle splats, SsboHandle order, SsboHandle args,
+                           const float view[16]);
+
+// Stable sort of `count` (key, value) uint32 pairs in place by the low
+// 8 * `passes` bits of the key. `passes` must be 2 or 4 so the result ends
+// back in `keys`/`values`; `count` must not exceed the scratch size.
+void gpu_sort_pairs(const GpuSortBuffers &buffers, SsboHandle keys, SsboHandle values, size_t count, int passes);
+
+// Exclusive prefix sum of uint32[count] in place, with the total written
+// to element [count] (the buffer holds count + 1 values). Reduces spans of
+// 2048 values per workgroup, scans the span sums, then adds them back.
+void gpu_sort_scan(SsboHandle values, size_t count);
+
+// Sort `count` random splats on the GPU and with the CPU reference
+// (depth_sort), compare the results and print both timings.
+bool gpu_sort_selftest(size_t count, int iterations);
+
+void gpu_sort_shutdown();
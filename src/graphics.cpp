@@ -4,88 +4,212 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 #include <string>
 #include <vector>
-#include <fstream>
-#include <sstream>
+#include <chrono>
+#include <future>
+#include <algorithm>
 #include "graphics.h"
 #include "ssbo.h"
+#include "gpu_sort.h"
+#include "gpu_cull.h"
+#include "tile_raster.h"
+#include "cpu_raster.h"
+#include "splat_lod.h"
+#include "splat_edit.h"
+#include "splat_sh.h"
+#include "profiler.h"
+#include "shader.h"
+#include "ply_loader.h"
+#include "gsb.h"
+#include "scene_stream.h"
+#include "sort_pipeline.h"
+#include "math3d.h"
+#include "parallel.h"
 
 static GLuint g_triVAO = 0, g_triVBO = 0, g_triProgram = 0;
+static SsboHandle g_colorBuffer = 0;
 
-static std::string read_file(const char *path)
+// loaded scene, drawn as instanced splat quads
+static GLuint g_splatProgram = 0, g_packProgram = 0, g_emptyVAO = 0;
+static GLint g_splatViewLoc = -1, g_splatProjLoc = -1, g_splatViewportLoc = -1;
+static GLint g_splatFocalLoc = -1, g_splatScaleLoc = -1, g_packFirstLoc = -1, g_packCountLoc = -1;
+static size_t g_splatCount = 0;
+static Camera g_camera;
+static GraphicsOptions g_options;
+static GraphicsStats g_stats;
+
+// GpuSplat[count], its PackedSplat[count] render copy and the uint32[count]
+// back-to-front draw order
+static SsboHandle g_splatBuffer = 0, g_packedBuffer = 0, g_orderBuffer = 0;
+
+// host-side centers (SoA) for the CPU depth sort
+static std::vector<float> g_centers[3];
+static DepthSorter g_sorter;
+
+static bool g_gpuSortReady = false;
+static GpuSortBuffers g_gpuSortBuffers;
+static float g_gpuSortView[16];
+static bool g_gpuSorted = false;
+static int g_lastSortMode = SORT_NONE;
+
+// GPU culling ahead of the GPU sort (GraphicsOptions::gpuCull): the sort and
+// the indirect draw then use the visible list instead of the order buffer
+static bool g_gpuCullReady = false;
+static GpuCullBuffers g_cullBuffers;
+static bool g_gpuCulled = false;   // the last GPU sort ran over the visible list
+static float g_cullState[18];      // projection, splat scale and minimum radius it was culled for
+
+static bool g_tileEngineReady = false;
+
+// Host copy of the original splats, read back from the GPU the first time
+// the CPU engine or an edit needs it; edits apply here and upload from here
+static std::vector<GpuSplat> g_hostSplats;
+
+// CPU engine image and the texture it is uploaded to
+static std::vector<uint8_t> g_cpuImage;
+static GLuint g_cpuTexture = 0;
+static int g_cpuWidth = 0, g_cpuHeight = 0;
+
+// Editing (splat_edit.h): the selection pass, its output, and undo/redo
+// steps holding the fields each edit overwrote
+static GLuint g_selectProgram = 0;
+static GLint g_selectViewLoc = -1, g_selectProjLoc = -1, g_selectViewportLoc = -1, g_selectFocalLoc = -1;
+static GLint g_selectScaleLoc = -1, g_selectRectMinLoc = -1, g_selectRectMaxLoc = -1, g_selectAlphaLoc = -1;
+static GLint g_selectCountLoc = -1;
+static SsboHandle g_selectList = 0, g_selectCount = 0;
+static std::vector<SplatEditStep> g_undo, g_redo;
+static bool g_orderStale = false; // edits moved or hid splats since the last sort
+// Edited splats lying at most this many splats apart go up in one upload
+static const uint32_t k_editMergeGap = 64;
+
+// view-dependent color (splat_sh.h), over the originals only: LOD nodes
+// keep their band-0 color
+static bool g_shReady = false;
+static SplatShBuffers g_sh;
+static int g_shDegree = 0;        // bands the colors were last evaluated with
+static bool g_shDirty = false;    // packed colors rewritten since the last pass
+static float g_shView[32];        // view and projection of the last pass
+
+// Level of detail for large scenes. The splat buffers then hold the
+// originals followed by one coarse Gaussian per octree node, and the order
+// buffer holds the current cut instead of every original.
+static SplatLod g_lod;
+static bool g_hasLod = false, g_lodActive = false;
+static std::vector<uint32_t> g_cut, g_cutOrder;
+static std::vector<float> g_cutCenters[3];
+static size_t g_cutCentersReady = 0; // leading g_cut entries gathered into g_cutCenters
+static float g_cutView[16], g_cutPixelSize = 0.0f, g_cutFocal = 0.0f;
+static size_t g_drawCount = 0; // entries of g_orderBuffer that are sorted and drawn
+
+// Streamed scenes (graphics_load_scene_async). Chunk c lands in slot s of
+// the splat buffers, at splats [s * STREAM_CHUNK_SPLATS, ...); in memory
+// slot s is chunk s, out of core slots are a pool assigned by g_cache.
+// While chunks arrive (and for good out of core) the draw set is the list
+// of resident splats, kept in g_cut like an LOD cut.
+static bool g_streaming = false, g_streamCut = false, g_outOfCore = false;
+static StreamInfo g_streamInfo;
+static StreamCache g_cache;
+static std::vector<float> g_chunkBounds;     // min xyz, max xyz per chunk
+static std::vector<uint8_t> g_chunkSeen;     // decoded at least once
+static std::vector<uint8_t> g_chunkRequested;
+static std::vector<uint32_t> g_slotSplats;   // splats held by each slot
+static size_t g_chunksSeen = 0, g_requestsInFlight = 0;
+static uint64_t g_streamFrame = 0;
+static std::chrono::steady_clock::time_point g_streamStart;
+static std::string g_streamPath;
+// .ply scenes carry no bounds: the camera is refitted as chunks arrive
+// until the user moves it
+static bool g_autoFit = false;
+static Camera g_fitCamera;
+static float g_fitMin[3], g_fitMax[3];
+// hierarchy of a streamed scene, built in the background from its file once
+// every chunk is in
+static std::future<bool> g_lodBuild;
+static SplatLod g_lodNext;               // built here while g_lod stays in use
+static std::vector<SplatRange> g_lodEdits; // edited since the build in flight started
+
+// Pipelined CPU sort (GraphicsOptions::pipelineSort): the worker prepares
+// the order for the newest camera while this thread draws the newest order
+// it finished, with the camera that order was made for.
+static bool g_hasPipeResult = false;
+static float g_pipeView[16], g_pipeProj[16];
+static uint64_t g_frameCounter = 0;
+
+static double ms_since(std::chrono::steady_clock::time_point t0)
 {
-    std::ifstream ifs(path, std::ios::in | std::ios::binary);
-    if (!ifs) return std::string();
-    std::ostringstream ss;
-    ss << ifs.rdbuf();
-    return ss.str();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
 }
 
-static GLuint compile_shader_from_source(GLenum type, const std::string &src)
+static void locate_splat_uniforms()
 {
-    const char *s = src.c_str();
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &s, NULL);
-    glCompileShader(shader);
-
-    GLint ok = 0;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
-    if (!ok) {
-        GLint len = 0;
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &len);
-        std::vector<char> log(len ? len : 1);
-        glGetShaderInfoLog(shader, (GLsizei)log.size(), NULL, log.data());
-        fprintf(stderr, "Shader compile error: %s\n", log.data());
-        glDeleteShader(shader);
-        return 0;
-    }
-    return shader;
+    g_splatViewLoc = glGetUniformLocation(g_splatProgram, "uView");
+    g_splatProjLoc = glGetUniformLocation(g_splatProgram, "uProj");
+    g_splatViewportLoc = glGetUniformLocation(g_splatProgram, "uViewport");
+    g_splatFocalLoc = glGetUniformLocation(g_splatProgram, "uFocal");
+    g_splatScaleLoc = glGetUniformLocation(g_splatProgram, "uSplatScale");
+    g_packFirstLoc = glGetUniformLocation(g_packProgram, "uFirst");
+    g_packCountLoc = glGetUniformLocation(g_packProgram, "uCount");
 }
 
-static GLuint link_program(GLuint vs, GLuint fs)
+static void locate_select_uniforms()
 {
-    GLuint p = glCreateProgram();
-    glAttachShader(p, vs);
-    glAttachShader(p, fs);
-    glLinkProgram(p);
-
-    GLint ok = 0;
-    glGetProgramiv(p, GL_LINK_STATUS, &ok);
-    if (!ok) {
-        GLint len = 0;
-        glGetProgramiv(p, GL_INFO_LOG_LENGTH, &len);
-        std::vector<char> log(len ? len : 1);
-        glGetProgramInfoLog(p, (GLsizei)log.size(), NULL, log.data());
-        fprintf(stderr, "Program link error: %s\n", log.data());
-        glDeleteProgram(p);
-        return 0;
-    }
-    return p;
+    g_selectViewLoc = glGetUniformLocation(g_selectProgram, "uView");
+    g_selectProjLoc = glGetUniformLocation(g_selectProgram, "uProj");
+    g_selectViewportLoc = glGetUniformLocation(g_selectProgram, "uViewport");
+    g_selectFocalLoc = glGetUniformLocation(g_selectProgram, "uFocal");
+    g_selectScaleLoc = glGetUniformLocation(g_selectProgram, "uSplatScale");
+    g_selectRectMinLoc = glGetUniformLocation(g_selectProgram, "uRectMin");
+    g_selectRectMaxLoc = glGetUniformLocation(g_selectProgram, "uRectMax");
+    g_selectAlphaLoc = glGetUniformLocation(g_selectProgram, "uMinAlpha");
+    g_selectCountLoc = glGetUniformLocation(g_selectProgram, "uCount");
 }
 
 bool graphics_init(const float* initial_colors, size_t byteSize)
 {
-    // read shaders
-    std::string vs_src = read_file("shaders/gaussian.vert");
-    std::string fs_src = read_file("shaders/gaussian.frag");
-    if (vs_src.empty() || fs_src.empty()) {
-        fprintf(stderr, "graphics: Failed to read shader files\n");
-        return false;
-    }
+    auto t0 = std::chrono::steady_clock::now();
+    shader_init("shader_cache");
 
-    GLuint vs = compile_shader_from_source(GL_VERTEX_SHADER, vs_src);
-    GLuint fs = compile_shader_from_source(GL_FRAGMENT_SHADER, fs_src);
-    if (!vs || !fs) {
-        if (vs) glDeleteShader(vs);
-        if (fs) glDeleteShader(fs);
-        return false;
+    // these build in the background while the sort and tile programs are
+    // compiled below
+    g_triProgram = shader_begin_program("shaders/gaussian.vert", "shaders/gaussian.frag");
+    g_splatProgram = shader_begin_program("shaders/splat.vert", "shaders/splat.frag");
+    g_packProgram = shader_begin_compute("shaders/splat_pack.comp");
+    g_selectProgram = shader_begin_compute("shaders/splat_select.comp");
+
+    // the GPU sort is optional: the CPU sort still works without compute shaders
+    g_gpuSortReady = gpu_sort_init();
+    if (!g_gpuSortReady) fprintf(stderr, "graphics: GPU sort unavailable, using the CPU sort only\n");
+    // the tile engine reuses the GPU sort's passes
+    g_tileEngineReady = g_gpuSortReady && tile_raster_init();
+    if (!g_tileEngineReady) fprintf(stderr, "graphics: tile engine unavailable, using the raster engine only\n");
+    // culling feeds the GPU sort, so it is only useful with it
+    g_gpuCullReady = g_gpuSortReady && gpu_cull_init();
+    g_shReady = splat_sh_init();
+    if (!g_shReady) fprintf(stderr, "graphics: SH pass unavailable, drawing band-0 colors\n");
+
+    bool triOk = shader_finish(&g_triProgram);
+    bool splatOk = shader_finish(&g_splatProgram);
+    bool packOk = shader_finish(&g_packProgram);
+    if (!triOk || !splatOk || !packOk) return false;
+    locate_splat_uniforms();
+    // edits still apply without it; only selecting on screen is lost
+    if (shader_finish(&g_selectProgram)) {
+        locate_select_uniforms();
+        shader_watch(&g_selectProgram, locate_select_uniforms);
+    } else {
+        fprintf(stderr, "graphics: selection pass unavailable\n");
     }
+    shader_watch(&g_triProgram, nullptr);
+    shader_watch(&g_splatProgram, locate_splat_uniforms);
+    shader_watch(&g_packProgram, locate_splat_uniforms);
+    glGenVertexArrays(1, &g_emptyVAO);
 
-    g_triProgram = link_program(vs, fs);
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-    if (!g_triProgram) return false;
+    const ShaderStats &ss = shader_stats();
+    printf("graphics: programs ready in %.1f ms (%zu cached, %zu compiled%s)\n", ms_since(t0), ss.cacheHits,
+           ss.compiled, ss.parallelCompile ? ", parallel" : "");
 
     // simple triangle positions
     float vertices[] = {
@@ -109,27 +233,1330 @@ bool graphics_init(const float* initial_colors, size_t byteSize)
 
     // create SSBO if initial colors supplied
     if (initial_colors && byteSize > 0) {
-        if (!ssbo_create_from_data(initial_colors, byteSize)) {
-            fprintf(stderr, "graphics: ssbo creation failed\n");
+        g_colorBuffer = ssbo_alloc(byteSize, initial_colors);
+        if (!g_colorBuffer) fprintf(stderr, "graphics: ssbo creation failed\n");
+    }
+
+    return true;
+}
+
+static bool has_extension(const char *path, const char *ext)
+{
+    size_t n = strlen(path), e = strlen(ext);
+    if (n < e) return false;
+    for (size_t i = 0; i < e; ++i) {
+        char c = path[n - e + i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != ext[i]) return false;
+    }
+    return true;
+}
+
+static void unload_scene()
+{
+    sort_pipeline_stop();
+    scene_stream_cancel();
+    // the hierarchy is built into g_lodNext
+    if (g_lodBuild.valid()) g_lodBuild.get();
+    g_lodNext = SplatLod();
+    std::vector<SplatRange>().swap(g_lodEdits);
+    g_streaming = g_streamCut = g_outOfCore = false;
+    g_cache = StreamCache();
+    std::vector<float>().swap(g_chunkBounds);
+    std::vector<uint8_t>().swap(g_chunkSeen);
+    std::vector<uint8_t>().swap(g_chunkRequested);
+    std::vector<uint32_t>().swap(g_slotSplats);
+    g_chunksSeen = g_requestsInFlight = 0;
+    g_autoFit = false;
+
+    ssbo_free(g_splatBuffer);
+    ssbo_free(g_packedBuffer);
+    ssbo_free(g_orderBuffer);
+    gpu_sort_free(&g_gpuSortBuffers);
+    gpu_cull_free(&g_cullBuffers);
+    splat_sh_free(&g_sh);
+    g_shDegree = 0;
+    tile_raster_release();
+    std::vector<GpuSplat>().swap(g_hostSplats);
+    cpu_raster_release();
+    ssbo_free(g_selectList);
+    ssbo_free(g_selectCount);
+    g_selectList = g_selectCount = 0;
+    std::vector<SplatEditStep>().swap(g_undo);
+    std::vector<SplatEditStep>().swap(g_redo);
+    g_orderStale = false;
+    g_splatBuffer = g_packedBuffer = g_orderBuffer = 0;
+    g_splatCount = g_drawCount = 0;
+    g_gpuSorted = g_gpuCulled = false;
+    for (int k = 0; k < 3; ++k) std::vector<float>().swap(g_centers[k]);
+    depth_sort_reset(&g_sorter);
+    g_lod = SplatLod();
+    g_hasLod = g_lodActive = false;
+    std::vector<uint32_t>().swap(g_cut);
+    std::vector<uint32_t>().swap(g_cutOrder);
+    for (int k = 0; k < 3; ++k) std::vector<float>().swap(g_cutCenters[k]);
+    g_cutCentersReady = 0;
+}
+
+// Refresh the packed render copy of splats [first, first + count) on the
+// GPU. Their colors go back to band 0 until the SH pass runs again.
+static void pack_splats(size_t first, size_t count)
+{
+    glUseProgram(g_packProgram);
+    glUniform1ui(g_packFirstLoc, (GLuint)first);
+    glUniform1ui(g_packCountLoc, (GLuint)count);
+    ssbo_bind(g_splatBuffer, 0);
+    ssbo_bind(g_packedBuffer, 6);
+    glDispatchCompute((GLuint)std::min<size_t>((count + 255) / 256, 65535), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUseProgram(0);
+    splat_sh_invalidate(g_sh, first, count);
+    g_shDirty = true;
+}
+
+// Splat, packed and order buffers for `total` entries.
+static bool alloc_scene_buffers(size_t total)
+{
+    g_splatBuffer = ssbo_alloc(total * sizeof(GpuSplat));
+    g_packedBuffer = ssbo_alloc(total * sizeof(PackedSplat));
+    g_orderBuffer = ssbo_alloc(total * sizeof(uint32_t));
+    return g_splatBuffer && g_packedBuffer && g_orderBuffer;
+}
+
+// Draw every original splat, in file order until the first sort runs.
+static bool set_full_order()
+{
+    uint32_t *order = (uint32_t *)ssbo_map(g_orderBuffer);
+    if (!order) return false;
+    parallel_for(g_splatCount, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) order[i] = (uint32_t)i;
+    });
+    g_drawCount = g_splatCount;
+    return ssbo_unmap(g_orderBuffer);
+}
+
+// Build the hierarchy over host-side splats and upload the originals plus
+// the coarse Gaussians, with centers for both.
+static bool upload_with_lod(const GpuSplat *splats, size_t count)
+{
+    if (!splat_lod_build(splats, count, &g_lod)) return false;
+    size_t total = count + g_lod.coarse.size();
+    if (!alloc_scene_buffers(total)) return false;
+
+    GpuSplat *mapped = (GpuSplat *)ssbo_map(g_splatBuffer);
+    if (!mapped) return false;
+    for (int k = 0; k < 3; ++k) g_centers[k].resize(total);
+    parallel_for(total, 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const GpuSplat &src = i < count ? splats[i] : g_lod.coarse[i - count];
+            mapped[i] = src;
+            for (int k = 0; k < 3; ++k) g_centers[k][i] = src.position[k];
+        }
+    });
+    if (!ssbo_unmap(g_splatBuffer)) return false;
+
+    g_hasLod = true;
+    printf("graphics: LOD over %zu splats: %zu nodes, depth %d, built in %.1f ms\n", count, g_lod.nodes.size(),
+           g_lod.depth, g_lod.buildMs);
+    return true;
+}
+
+static void fit_camera(const float boundsMin[3], const float boundsMax[3])
+{
+    camera_fit_bounds(&g_camera, boundsMin, boundsMax);
+
+    // let the sort's fast path tolerate camera steps of ~0.5% of the scene size
+    float extent = 0.0f;
+    for (int k = 0; k < 3; ++k) extent = std::max(extent, boundsMax[k] - boundsMin[k]);
+    g_sorter.maxTranslationDelta = extent * 0.005f;
+}
+
+// Common tail of a load once the splat buffer is filled.
+static bool finish_load(size_t count, const float boundsMin[3], const float boundsMax[3])
+{
+    g_splatCount = count;
+    if (!set_full_order()) return false;
+    pack_splats(0, count + g_lod.coarse.size());
+
+    // the GPU sort is optional: without scratch the scene still draws.
+    // A cut never has more entries than the scene has splats.
+    if (g_gpuSortReady && !gpu_sort_alloc(&g_gpuSortBuffers, count))
+        fprintf(stderr, "graphics: no memory for the GPU sort, using the CPU sort only\n");
+    if (g_gpuCullReady && g_gpuSortBuffers.count > 0 && !gpu_cull_alloc(&g_cullBuffers, count))
+        fprintf(stderr, "graphics: no memory for GPU culling, sorting every splat\n");
+
+    g_stats = GraphicsStats();
+    g_stats.splatCount = count;
+    g_stats.gpuSortAvailable = g_gpuSortBuffers.count > 0;
+    g_stats.gpuCullAvailable = g_cullBuffers.count > 0;
+    g_stats.tileEngineAvailable = g_tileEngineReady;
+    g_stats.lodAvailable = g_hasLod;
+    g_stats.lodNodes = g_lod.nodes.size();
+    depth_sort_reset(&g_sorter);
+    fit_camera(boundsMin, boundsMax);
+    return true;
+}
+
+// SH bands to keep of a scene storing `fileDegree`.
+static int load_sh_degree(int fileDegree)
+{
+    return g_shReady ? std::max(0, std::min(g_options.shDegree, fileDegree)) : 0;
+}
+
+// Decode the SH of every splat in slices, packed to halves at `degree`,
+// straight into the mapped coefficient buffer.
+static bool load_sh(bool isGsb, const PlyFile &ply, const GsbFile &gsb, size_t count, int degree)
+{
+    if (!splat_sh_alloc(&g_sh, count, degree)) return false;
+    uint32_t *mapped = (uint32_t *)ssbo_map(g_sh.coeffs);
+    if (!mapped) return false;
+    uint32_t words = splat_sh_words(degree);
+    parallel_for(count, 4096, [&](size_t begin, size_t end) {
+        std::vector<float> shRest((end - begin) * SPLAT_SH_REST_FLOATS);
+        SplatSink sink;
+        sink.shRest = shRest.data();
+        sink.first = begin;
+        if (isGsb) gsb_decode(gsb, begin, end - begin, sink);
+        else ply_decode(ply, begin, end - begin, sink, nullptr, nullptr);
+        splat_sh_pack(shRest.data(), end - begin, degree, mapped + begin * words);
+    });
+    return ssbo_unmap(g_sh.coeffs);
+}
+
+// Decode splats from a mapped scene file on demand, for an LOD build.
+static SplatLodFetch file_fetch(bool isGsb, const PlyFile &ply, const GsbFile &gsb)
+{
+    return [isGsb, &ply, &gsb](size_t first, size_t count, GpuSplat *out) {
+        SplatSink sink;
+        sink.splats = out;
+        sink.first = first;
+        if (isGsb) gsb_decode(gsb, first, count, sink);
+        else ply_decode(ply, first, count, sink, nullptr, nullptr);
+    };
+}
+
+bool graphics_load_scene(const char* path)
+{
+    // the previous scene's buffers go back to the arenas before the new
+    // ones are carved out, so reloading reuses the same space
+    unload_scene();
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    bool isGsb = has_extension(path, ".gsb");
+    PlyFile ply;
+    GsbFile gsb;
+    size_t count = 0;
+    int shDegree = 0;
+    if (isGsb) {
+        if (!gsb_open(path, &gsb)) return false;
+        count = (size_t)gsb.header.count;
+        shDegree = (int)gsb.header.shDegree;
+    } else {
+        if (!ply_open(path, &ply)) return false;
+        count = ply.vertexCount;
+        shDegree = ply.shDegree;
+    }
+
+    // scenes large enough get an LOD hierarchy, built first from the mapped
+    // file so its coarse Gaussians can follow the originals in the buffers
+    bool buildLod = count > 0 && count >= (size_t)g_options.lodMinSplats;
+    g_hasLod = buildLod && splat_lod_build_from(file_fetch(isGsb, ply, gsb), count, &g_lod);
+    size_t total = count + g_lod.coarse.size();
+
+    // both formats decode straight into the mapped SSBO: no host-side splat
+    // array
+    GpuSplat *dst = alloc_scene_buffers(total) ? (GpuSplat *)ssbo_map(g_splatBuffer) : nullptr;
+    float boundsMin[3], boundsMax[3];
+    if (dst) {
+        for (int k = 0; k < 3; ++k) g_centers[k].resize(total);
+        SplatSink sink;
+        sink.splats = dst;
+        for (int k = 0; k < 3; ++k) sink.centers[k] = g_centers[k].data();
+
+        if (isGsb) {
+            gsb_load(gsb, sink);
+            memcpy(boundsMin, gsb.header.boundsMin, sizeof(boundsMin));
+            memcpy(boundsMax, gsb.header.boundsMax, sizeof(boundsMax));
         } else {
-            ssbo_bind_base(0);
+            ply_load(ply, sink, boundsMin, boundsMax);
+        }
+        parallel_for(total - count, 1 << 14, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                dst[count + i] = g_lod.coarse[i];
+                for (int k = 0; k < 3; ++k) g_centers[k][count + i] = g_lod.coarse[i].position[k];
+            }
+        });
+    }
+    bool ok = dst && ssbo_unmap(g_splatBuffer);
+    if (ok && g_hasLod)
+        printf("graphics: LOD over %zu splats: %zu nodes, depth %d, built in %.1f ms\n", count, g_lod.nodes.size(),
+               g_lod.depth, g_lod.buildMs);
+
+    // SH maps its own buffer, so it comes after the splat buffer is
+    // unmapped: small scenes share an arena with it (ssbo_map). Without
+    // room for it the scene still draws, in band-0 colors.
+    int keepSh = load_sh_degree(shDegree);
+    if (ok && keepSh > 0 && !load_sh(isGsb, ply, gsb, count, keepSh)) splat_sh_free(&g_sh);
+    if (isGsb) gsb_close(&gsb);
+    else ply_close(&ply);
+    ok = ok && finish_load(count, boundsMin, boundsMax);
+    if (!ok) {
+        unload_scene();
+        return false;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    g_stats.shDegreeLoaded = g_sh.degree;
+    g_stats.shBytes = count * splat_sh_bytes(g_sh.degree);
+    printf("graphics: loaded %zu splats (SH degree %d, %d kept) from %s in %.1f ms\n", count, shDegree, g_sh.degree,
+           path, ms);
+    return true;
+}
+
+bool graphics_load_splats(const GpuSplat* splats, size_t count)
+{
+    unload_scene();
+    if (!splats || count == 0) return false;
+
+    float boundsMin[3] = {INFINITY, INFINITY, INFINITY}, boundsMax[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (size_t i = 0; i < count; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            boundsMin[k] = std::min(boundsMin[k], splats[i].position[k]);
+            boundsMax[k] = std::max(boundsMax[k], splats[i].position[k]);
+        }
+    }
+
+    bool ok;
+    if (count >= (size_t)g_options.lodMinSplats) {
+        ok = upload_with_lod(splats, count);
+    } else {
+        ok = alloc_scene_buffers(count);
+        if (ok) {
+            ssbo_update(g_splatBuffer, 0, splats, count * sizeof(GpuSplat));
+            for (int k = 0; k < 3; ++k) g_centers[k].resize(count);
+            for (size_t i = 0; i < count; ++i)
+                for (int k = 0; k < 3; ++k) g_centers[k][i] = splats[i].position[k];
+        }
+    }
+    ok = ok && finish_load(count, boundsMin, boundsMax);
+    if (!ok) unload_scene();
+    return ok;
+}
+
+// GPU bytes per streamed splat slot: the splat, its packed copy, the draw
+// order, the GPU sort's scratch and the visible list, plus its SH
+static const size_t k_slotSplatBytes = sizeof(GpuSplat) + sizeof(PackedSplat) + 5 * sizeof(uint32_t);
+
+bool graphics_load_scene_async(const char* path)
+{
+    unload_scene();
+    g_streamStart = std::chrono::steady_clock::now();
+
+    StreamInfo info;
+    if (!scene_stream_open(path, load_sh_degree(SPLAT_MAX_SH_DEGREE), &info)) return false;
+    if (info.count == 0) {
+        scene_stream_cancel();
+        fprintf(stderr, "graphics: %s holds no splats\n", path);
+        return false;
+    }
+
+    int shDegree = load_sh_degree(info.shDegree);
+    size_t slots = info.chunkCount;
+    if (g_options.gpuBudgetMB > 0) {
+        size_t budget = (size_t)g_options.gpuBudgetMB << 20;
+        size_t slotBytes = (k_slotSplatBytes + splat_sh_bytes(shDegree)) * STREAM_CHUNK_SPLATS;
+        size_t fit = std::max<size_t>(budget / slotBytes, 1);
+        if (fit < slots) {
+            slots = fit;
+            g_outOfCore = true;
+        }
+    }
+    size_t capacity = g_outOfCore ? slots * STREAM_CHUNK_SPLATS : info.count;
+    if (!alloc_scene_buffers(capacity)) {
+        fprintf(stderr, "graphics: no GPU memory for %zu splats\n", capacity);
+        unload_scene();
+        return false;
+    }
+    for (int k = 0; k < 3; ++k) g_centers[k].resize(capacity);
+    if (g_gpuSortReady && !gpu_sort_alloc(&g_gpuSortBuffers, capacity))
+        fprintf(stderr, "graphics: no memory for the GPU sort, using the CPU sort only\n");
+    if (g_gpuCullReady && g_gpuSortBuffers.count > 0 && !gpu_cull_alloc(&g_cullBuffers, capacity))
+        fprintf(stderr, "graphics: no memory for GPU culling, sorting every splat\n");
+    if (shDegree > 0 && !splat_sh_alloc(&g_sh, capacity, shDegree))
+        fprintf(stderr, "graphics: no memory for SH, drawing band-0 colors\n");
+
+    stream_cache_init(&g_cache, info.chunkCount, slots);
+    g_chunkBounds.assign(info.chunkCount * 6, 0.0f);
+    g_chunkSeen.assign(info.chunkCount, 0);
+    g_chunkRequested.assign(info.chunkCount, 0);
+    g_slotSplats.assign(slots, 0);
+    g_streamInfo = info;
+    g_streamPath = path;
+    g_streaming = g_streamCut = true;
+    g_streamFrame = 0;
+    g_splatCount = info.count;
+    g_drawCount = 0;
+
+    g_stats = GraphicsStats();
+    g_stats.splatCount = info.count;
+    g_stats.gpuSortAvailable = g_gpuSortBuffers.count > 0;
+    g_stats.gpuCullAvailable = g_cullBuffers.count > 0;
+    g_stats.tileEngineAvailable = g_tileEngineReady;
+    g_stats.streaming = true;
+    g_stats.outOfCore = g_outOfCore;
+    g_stats.chunkCount = info.chunkCount;
+    g_stats.chunkSlots = slots;
+    g_stats.shDegreeLoaded = g_sh.degree;
+    g_stats.shBytes = capacity * splat_sh_bytes(g_sh.degree);
+    depth_sort_reset(&g_sorter);
+    if (info.hasBounds) {
+        fit_camera(info.boundsMin, info.boundsMax);
+    } else {
+        g_autoFit = true;
+        g_fitCamera = g_camera;
+        for (int k = 0; k < 3; ++k) {
+            g_fitMin[k] = INFINITY;
+            g_fitMax[k] = -INFINITY;
         }
     }
 
+    if (g_outOfCore)
+        printf("graphics: streaming %zu splats from %s out of core (%zu of %zu chunks fit in %d MB)\n", info.count,
+               path, slots, info.chunkCount, g_options.gpuBudgetMB);
+    else
+        printf("graphics: streaming %zu splats from %s\n", info.count, path);
     return true;
 }
 
-void graphics_update_colors(const float* colors, size_t byteSize)
+void graphics_cancel_load()
+{
+    if (!g_streaming) return;
+    scene_stream_cancel();
+    g_streaming = false;
+    g_stats.streaming = false;
+    printf("graphics: stopped streaming %s at %zu of %zu chunks\n", g_streamPath.c_str(), g_chunksSeen,
+           g_streamInfo.chunkCount);
+}
+
+size_t graphics_splat_count()
+{
+    return g_splatCount;
+}
+
+GraphicsOptions* graphics_options()
+{
+    return &g_options;
+}
+
+const GraphicsStats& graphics_stats()
+{
+    return g_stats;
+}
+
+Camera* graphics_camera()
+{
+    return &g_camera;
+}
+
+void graphics_update_colors(const float* colors, size_t byteSize, size_t byteOffset)
 {
     if (!colors || byteSize == 0) return;
-    ssbo_update(colors, byteSize);
+    ssbo_update(g_colorBuffer, byteOffset, colors, byteSize);
+}
+
+// Whether every original splat sits at its own index of g_splatBuffer, as
+// the CPU engine and editing need: not while a scene streams in, whose
+// splats live in pool slots and may not all be resident.
+static bool scene_in_memory()
+{
+    return g_splatCount > 0 && !g_streaming && g_splatBuffer;
+}
+
+static bool use_cpu_engine()
+{
+    return g_options.engine == ENGINE_CPU && scene_in_memory();
+}
+
+// Read the original splats back into g_hostSplats, once per scene.
+static void ensure_host_copy()
+{
+    if (g_hostSplats.size() == g_splatCount) return;
+    // LOD nodes follow the originals in the buffer
+    g_hostSplats.resize(g_splatCount);
+    ssbo_read(g_splatBuffer, 0, g_hostSplats.data(), g_splatCount * sizeof(GpuSplat));
+}
+
+static GLuint cpu_target(int width, int height)
+{
+    if (width <= 0 || height <= 0) return 0;
+    if (g_cpuTexture && width == g_cpuWidth && height == g_cpuHeight) return g_cpuTexture;
+
+    if (g_cpuTexture) glDeleteTextures(1, &g_cpuTexture);
+    glGenTextures(1, &g_cpuTexture);
+    glBindTexture(GL_TEXTURE_2D, g_cpuTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    g_cpuWidth = width;
+    g_cpuHeight = height;
+    return g_cpuTexture;
+}
+
+uint32_t graphics_scene_texture(int width, int height)
+{
+    if (g_splatCount == 0) return 0;
+    if (use_cpu_engine()) return cpu_target(width, height);
+    if (!g_tileEngineReady || g_options.engine != ENGINE_TILES) return 0;
+    return tile_raster_target(width, height);
+}
+
+// Sort mode in effect: the GPU sort needs its scratch buffers.
+static int sort_mode()
+{
+    int mode = g_options.sortMode;
+    return mode == SORT_GPU && g_gpuSortBuffers.count == 0 ? SORT_CPU : mode;
+}
+
+// Choose the LOD cut for this view and make it the set of splats to draw.
+// Returns true when the order buffer now holds a new set.
+static bool update_cut(const float view[16], const float proj[16], int height)
+{
+    bool active = g_hasLod && g_options.lod;
+    if (!active) {
+        if (!g_lodActive) return false;
+        g_lodActive = false;
+        set_full_order();
+        return true;
+    }
+
+    SplatLodParams params;
+    params.focal = proj[5] * height * 0.5f;
+    params.tanHalfFov[0] = 1.0f / proj[0];
+    params.tanHalfFov[1] = 1.0f / proj[5];
+    params.pixelSize = g_options.lodPixelSize;
+    if (g_lodActive && memcmp(view, g_cutView, sizeof(g_cutView)) == 0 && params.pixelSize == g_cutPixelSize &&
+        params.focal == g_cutFocal)
+        return false;
+
+    PROFILE_ZONE("lod_cut");
+    splat_lod_select(g_lod, view, params, &g_cut, &g_stats.lod);
+    memcpy(g_cutView, view, sizeof(g_cutView));
+    g_cutPixelSize = params.pixelSize;
+    g_cutFocal = params.focal;
+    g_lodActive = true;
+    g_cutCentersReady = 0;
+    g_drawCount = g_cut.size();
+    // the sorts overwrite the order buffer in place; CPU sorting uploads
+    // its own result
+    if (sort_mode() != SORT_CPU && g_drawCount > 0) {
+        PROFILE_ZONE("upload");
+        PROFILE_GPU("upload");
+        ssbo_update(g_orderBuffer, 0, g_cut.data(), g_drawCount * sizeof(uint32_t));
+    }
+    return true;
+}
+
+// Whether the order buffer holds a subset of the splats listed in g_cut
+// (an LOD cut or the resident part of a streamed scene).
+static bool cut_active()
+{
+    return g_lodActive || g_streamCut;
+}
+
+// Whether a chunk's bounding box reaches into the view frustum: it is
+// culled when all eight corners lie outside one plane. File order often
+// makes chunks long slabs, so a bounding sphere would keep too many.
+// *depth gets the nearest corner's distance along the view axis.
+static bool chunk_visible(const float bounds[6], const float view[16], const float tanHalfFov[2], float *depth)
+{
+    int outside[5] = {0, 0, 0, 0, 0}; // behind, left, right, bottom, top
+    float nearest = INFINITY;
+    for (int i = 0; i < 8; ++i) {
+        float p[3] = {bounds[(i & 1) ? 3 : 0], bounds[(i & 2) ? 4 : 1], bounds[(i & 4) ? 5 : 2]};
+        float x = view[0] * p[0] + view[4] * p[1] + view[8] * p[2] + view[12];
+        float y = view[1] * p[0] + view[5] * p[1] + view[9] * p[2] + view[13];
+        float d = -(view[2] * p[0] + view[6] * p[1] + view[10] * p[2] + view[14]);
+        outside[0] += d <= 0.0f;
+        outside[1] += x < -d * tanHalfFov[0];
+        outside[2] += x > d * tanHalfFov[0];
+        outside[3] += y < -d * tanHalfFov[1];
+        outside[4] += y > d * tanHalfFov[1];
+        nearest = std::min(nearest, d);
+    }
+    for (int k = 0; k < 5; ++k)
+        if (outside[k] == 8) return false;
+    *depth = std::max(nearest, 0.0f);
+    return true;
+}
+
+// Out of core: keep the chunks in view from being evicted and ask the
+// loaders for missing ones, nearest first, as many as can get a slot.
+static void request_visible(const float view[16], const float proj[16])
+{
+    static std::vector<std::pair<float, uint32_t>> missing;
+    missing.clear();
+    float tanHalfFov[2] = {1.0f / proj[0], 1.0f / proj[5]};
+    size_t visibleResident = 0;
+    for (uint32_t c = 0; c < (uint32_t)g_streamInfo.chunkCount; ++c) {
+        float depth;
+        if (!g_chunkSeen[c] || !chunk_visible(&g_chunkBounds[(size_t)c * 6], view, tanHalfFov, &depth)) continue;
+        if (g_cache.slotOf[c] >= 0) {
+            stream_cache_touch(&g_cache, c, g_streamFrame);
+            visibleResident++;
+        } else if (!g_chunkRequested[c]) {
+            missing.push_back(std::make_pair(depth, c));
+        }
+    }
+
+    size_t room = g_cache.chunkIn.size() - visibleResident;
+    room = room > g_requestsInFlight ? room - g_requestsInFlight : 0;
+    if (missing.size() > room) {
+        std::partial_sort(missing.begin(), missing.begin() + room, missing.end());
+        missing.resize(room);
+    }
+    for (const auto &m : missing) {
+        if (!scene_stream_request(m.second)) break;
+        g_chunkRequested[m.second] = 1;
+        g_requestsInFlight++;
+    }
+}
+
+// Copy a decoded chunk into its slot. Appends its splats to the draw set,
+// or sets *rebuild when another chunk had to be evicted for it.
+static void place_chunk(const StreamChunk &chunk, bool *rebuild)
+{
+    uint32_t c = chunk.index;
+    if (!g_chunkSeen[c]) {
+        g_chunkSeen[c] = 1;
+        g_chunksSeen++;
+        float *b = &g_chunkBounds[(size_t)c * 6];
+        for (int k = 0; k < 3; ++k) {
+            b[k] = chunk.boundsMin[k];
+            b[3 + k] = chunk.boundsMax[k];
+            g_fitMin[k] = std::min(g_fitMin[k], b[k]);
+            g_fitMax[k] = std::max(g_fitMax[k], b[3 + k]);
+        }
+    }
+    if (g_chunkRequested[c]) {
+        g_chunkRequested[c] = 0;
+        g_requestsInFlight--;
+    }
+    if (g_cache.slotOf[c] >= 0) return; // already resident
+
+    int evicted;
+    int slot = stream_cache_acquire(&g_cache, c, g_streamFrame, &evicted);
+    if (slot < 0) return; // every slot is in view; requested again while it is
+    if (evicted >= 0) *rebuild = true;
+
+    size_t base = (size_t)slot * STREAM_CHUNK_SPLATS;
+    ssbo_update(g_splatBuffer, base * sizeof(GpuSplat), chunk.splats.data(), chunk.count * sizeof(GpuSplat));
+    pack_splats(base, chunk.count);
+    if (g_sh.coeffs && chunk.shDegree == g_sh.degree) splat_sh_upload(g_sh, base, chunk.count, chunk.sh.data());
+    for (int k = 0; k < 3; ++k) memcpy(&g_centers[k][base], chunk.centers[k].data(), chunk.count * sizeof(float));
+    g_slotSplats[slot] = (uint32_t)chunk.count;
+    if (!*rebuild)
+        for (size_t i = 0; i < chunk.count; ++i) g_cut.push_back((uint32_t)(base + i));
+}
+
+// Build a hierarchy over the streamed scene in the background, into
+// g_lodNext, decoding its file again rather than keeping a copy of the
+// chunks as they went up.
+static void start_lod_build()
+{
+    std::string path = g_streamPath;
+    size_t count = g_splatCount;
+    g_lodBuild = std::async(std::launch::async, [path, count] {
+        bool isGsb = has_extension(path.c_str(), ".gsb");
+        PlyFile ply;
+        GsbFile gsb;
+        if (isGsb ? !gsb_open(path.c_str(), &gsb) : !ply_open(path.c_str(), &ply)) return false;
+        // the file must still hold the scene that streamed in
+        bool ok = (isGsb ? (size_t)gsb.header.count : ply.vertexCount) == count &&
+                  splat_lod_build_from(file_fetch(isGsb, ply, gsb), count, &g_lodNext);
+        if (isGsb) gsb_close(&gsb);
+        else ply_close(&ply);
+        return ok;
+    });
+    g_stats.lodBuilding = true;
+}
+
+// Every chunk of an in-memory scene is in: draw all splats in file order
+// and build the hierarchy in the background if the scene is large enough.
+static void finish_stream()
+{
+    scene_stream_cancel(); // the loaders let go of the file
+    g_streaming = g_streamCut = false;
+    std::vector<uint32_t>().swap(g_cut);
+    for (int k = 0; k < 3; ++k) std::vector<float>().swap(g_cutCenters[k]);
+    g_cutCentersReady = 0;
+    set_full_order();
+    printf("graphics: streamed %zu splats (SH degree %d) from %s in %.1f ms\n", g_splatCount,
+           g_streamInfo.shDegree, g_streamPath.c_str(), ms_since(g_streamStart));
+    if (g_splatCount >= (size_t)g_options.lodMinSplats) start_lod_build();
+}
+
+// Upload decoded chunks within the frame budget and, out of core, page in
+// the chunks in view. Returns true when the set of splats to draw changed.
+static bool stream_update(const float view[16], const float proj[16])
+{
+    g_streamFrame++;
+    if (g_outOfCore) request_visible(view, proj);
+
+    size_t before = g_cut.size();
+    bool rebuild = false;
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        PROFILE_ZONE("stream_upload");
+        PROFILE_GPU("stream_upload");
+        // at least one chunk per frame, so a tiny budget still makes progress
+        for (size_t n = 0; n == 0 || ms_since(t0) < g_options.streamBudgetMs; ++n) {
+            StreamChunk *chunk = scene_stream_pop();
+            if (!chunk) break;
+            place_chunk(*chunk, &rebuild);
+            scene_stream_release(chunk);
+        }
+    }
+    g_stats.streamUploadMs = (float)ms_since(t0);
+
+    if (rebuild) {
+        // an evicted chunk's splats are listed somewhere in the draw set
+        g_cut.clear();
+        for (size_t s = 0; s < g_slotSplats.size(); ++s) {
+            if (g_cache.chunkIn[s] < 0) continue;
+            size_t base = s * STREAM_CHUNK_SPLATS;
+            for (size_t i = 0; i < g_slotSplats[s]; ++i) g_cut.push_back((uint32_t)(base + i));
+        }
+        g_cutCentersReady = 0;
+        before = 0;
+    }
+    bool changed = rebuild || g_cut.size() != before;
+    if (changed) {
+        g_drawCount = g_cut.size();
+        // the new entries in draw-set order until a sort runs; CPU sorting
+        // uploads its own result
+        if (sort_mode() != SORT_CPU && g_drawCount > before) {
+            PROFILE_ZONE("upload");
+            ssbo_update(g_orderBuffer, before * sizeof(uint32_t), g_cut.data() + before,
+                        (g_drawCount - before) * sizeof(uint32_t));
+        }
+        if (g_autoFit) {
+            if (memcmp(&g_camera, &g_fitCamera, sizeof(Camera)) != 0) {
+                g_autoFit = false; // the user took over
+            } else {
+                fit_camera(g_fitMin, g_fitMax);
+                g_fitCamera = g_camera;
+            }
+        }
+    }
+
+    g_stats.streaming = true;
+    g_stats.outOfCore = g_outOfCore;
+    g_stats.chunkCount = g_streamInfo.chunkCount;
+    g_stats.chunksLoaded = g_chunksSeen;
+    g_stats.chunkSlots = g_cache.chunkIn.size();
+    g_stats.chunksResident = 0;
+    for (int c : g_cache.chunkIn) g_stats.chunksResident += c >= 0;
+    g_stats.evictions = g_cache.evictions;
+
+    if (!g_outOfCore && g_chunksSeen == g_streamInfo.chunkCount) {
+        finish_stream();
+        g_stats.streaming = false;
+        changed = true;
+    }
+    return changed;
+}
+
+// Refit the LOD nodes above edited splats (from g_hostSplats) and upload
+// the coarse Gaussians that changed, in merged runs like the edits.
+static void refit_lod(const std::vector<SplatRange> &edited)
+{
+    PROFILE_ZONE("lod_refit");
+    // the sort worker reads the hierarchy and the centers
+    sort_pipeline_stop();
+    std::vector<uint32_t> nodes;
+    if (!splat_lod_refit(&g_lod, g_hostSplats.data(), edited.data(), edited.size(), &nodes)) return;
+
+    std::vector<SplatRange> runs;
+    for (uint32_t n : nodes) {
+        if (!runs.empty() && runs.back().end == n) runs.back().end = n + 1;
+        else runs.push_back(SplatRange{n, n + 1});
+    }
+    splat_ranges_coalesce(&runs, k_editMergeGap);
+    size_t count = g_splatCount;
+    for (const SplatRange &r : runs) {
+        size_t n = r.end - r.begin;
+        ssbo_update(g_splatBuffer, (count + r.begin) * sizeof(GpuSplat), &g_lod.coarse[r.begin], n * sizeof(GpuSplat));
+        pack_splats(count + r.begin, n);
+        g_stats.editUploadBytes += n * sizeof(GpuSplat);
+        for (size_t i = r.begin; i < r.end; ++i)
+            for (int k = 0; k < 3; ++k) g_centers[k][count + i] = g_lod.coarse[i].position[k];
+    }
+    g_stats.editUploads += runs.size();
+    // node bounds moved: choose the cut again and re-sort it
+    g_cutPixelSize = -1.0f;
+    g_cutCentersReady = 0;
+    g_orderStale = true;
+}
+
+// Attach a hierarchy built in the background once it is ready: the first
+// one of a streamed scene, or one rebuilt after edits. The coarse Gaussians
+// go after the originals, as in upload_with_lod.
+static void poll_lod_build()
+{
+    g_stats.lodBuilding = g_lodBuild.valid();
+    if (!g_lodBuild.valid() || g_lodBuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+    bool ok = g_lodBuild.get();
+    g_stats.lodBuilding = false;
+    // the sort worker reads the centers and the hierarchy; it restarts with
+    // the new one
+    sort_pipeline_stop();
+    // a cut of the previous hierarchy may list coarse splats that change
+    if (g_lodActive) {
+        g_lodActive = false;
+        set_full_order();
+        g_orderStale = true;
+    }
+    g_lod = ok ? std::move(g_lodNext) : SplatLod();
+    g_lodNext = SplatLod();
+
+    size_t count = g_splatCount, coarse = g_lod.coarse.size(), total = count + coarse;
+    ok = ok && ssbo_resize(g_splatBuffer, total * sizeof(GpuSplat)) &&
+         ssbo_resize(g_packedBuffer, total * sizeof(PackedSplat)) &&
+         ssbo_resize(g_orderBuffer, total * sizeof(uint32_t));
+    if (!ok) {
+        fprintf(stderr, "graphics: no LOD hierarchy, drawing every splat\n");
+        g_lod = SplatLod();
+        g_hasLod = g_stats.lodAvailable = false;
+        g_lodEdits.clear();
+        return;
+    }
+    ssbo_update(g_splatBuffer, count * sizeof(GpuSplat), g_lod.coarse.data(), coarse * sizeof(GpuSplat));
+    pack_splats(count, coarse);
+    for (int k = 0; k < 3; ++k) {
+        g_centers[k].resize(total);
+        for (size_t i = 0; i < coarse; ++i) g_centers[k][count + i] = g_lod.coarse[i].position[k];
+    }
+    g_hasLod = true;
+    g_stats.lodAvailable = true;
+    g_stats.lodNodes = g_lod.nodes.size();
+    printf("graphics: LOD over %zu splats: %zu nodes, depth %d, built in %.1f ms\n", count, g_lod.nodes.size(),
+           g_lod.depth, g_lod.buildMs);
+
+    // built from the splats as streamed: bring in the edits made since
+    if (!g_lodEdits.empty()) {
+        refit_lod(g_lodEdits);
+        std::vector<SplatRange>().swap(g_lodEdits);
+    }
+}
+
+// Whether the GPU sort runs over a visible list culled on the GPU and the
+// raster engine draws it indirectly. The tile engine sizes its buffers
+// from the CPU's splat count, so it keeps sorting every splat.
+static bool use_gpu_cull()
+{
+    return g_options.gpuCull && sort_mode() == SORT_GPU && g_options.engine == ENGINE_RASTER &&
+           g_cullBuffers.count > 0;
+}
+
+// Bring the first g_drawCount entries of g_orderBuffer into back-to-front
+// order for `view`, or with GPU culling, the visible ones into the visible
+// list.
+static void sort_splats(const float view[16], const float proj[16], int height, bool drawSetChanged)
+{
+    int mode = sort_mode();
+    // both sorts write the same order buffer, so each must start over after
+    // the other one ran, or after the set of splats changed
+    if (mode != g_lastSortMode || drawSetChanged) {
+        depth_sort_reset(&g_sorter);
+        g_gpuSorted = g_gpuCulled = false;
+        g_lastSortMode = mode;
+    }
+
+    g_stats.sort = DepthSortStats();
+    if (g_drawCount == 0) return;
+    PROFILE_ZONE("sort");
+    if (mode == SORT_CPU) {
+        const float *centers[3] = {g_centers[0].data(), g_centers[1].data(), g_centers[2].data()};
+        if (cut_active()) {
+            // a streamed draw set only grows between rebuilds: gather the new entries
+            if (g_cutCentersReady < g_drawCount) {
+                size_t ready = g_cutCentersReady;
+                for (int k = 0; k < 3; ++k) g_cutCenters[k].resize(g_drawCount);
+                parallel_for(g_drawCount - ready, 1 << 15, [&](size_t begin, size_t end) {
+                    for (size_t i = ready + begin; i < ready + end; ++i)
+                        for (int k = 0; k < 3; ++k) g_cutCenters[k][i] = g_centers[k][g_cut[i]];
+                });
+                g_cutCentersReady = g_drawCount;
+            }
+            for (int k = 0; k < 3; ++k) centers[k] = g_cutCenters[k].data();
+        }
+        const uint32_t *order = depth_sort(&g_sorter, centers[0], centers[1], centers[2], g_drawCount, view);
+        // an unchanged order is already in the buffer
+        if (order && !g_sorter.stats.unchanged) {
+            if (cut_active()) {
+                // the sort ran over the cut's entries; map back to splats
+                g_cutOrder.resize(g_drawCount);
+                parallel_for(g_drawCount, 1 << 16, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) g_cutOrder[i] = g_cut[order[i]];
+                });
+                order = g_cutOrder.data();
+            }
+            PROFILE_ZONE("upload");
+            PROFILE_GPU("upload");
+            ssbo_update(g_orderBuffer, 0, order, g_drawCount * sizeof(uint32_t));
+        }
+        g_stats.sort = g_sorter.stats;
+    } else if (mode == SORT_GPU) {
+        bool cull = use_gpu_cull();
+        float cullState[18];
+        memcpy(cullState, proj, 16 * sizeof(float));
+        cullState[16] = g_options.splatScale;
+        cullState[17] = g_options.cullPixelRadius;
+        // culling depends on the projection too; the sort only on the view
+        bool recull = cull && (!g_gpuCulled || memcmp(cullState, g_cullState, sizeof(cullState)) != 0);
+        if (!g_gpuSorted || recull || cull != g_gpuCulled || memcmp(view, g_gpuSortView, sizeof(g_gpuSortView)) != 0) {
+            if (cull) {
+                // cut entries sorted in place by earlier frames are still the cut
+                GpuCullParams params;
+                memcpy(params.view, view, sizeof(params.view));
+                memcpy(params.proj, proj, sizeof(params.proj));
+                params.focal = proj[5] * height * 0.5f;
+                params.splatScale = g_options.splatScale;
+                params.minPixelRadius = g_options.cullPixelRadius;
+                {
+                    PROFILE_GPU("gpu_cull");
+                    gpu_cull_run(g_cullBuffers, g_packedBuffer, cut_active() ? g_orderBuffer : 0, g_drawCount,
+                                 params);
+                }
+                PROFILE_GPU("gpu_sort");
+                gpu_sort_run_indirect(g_gpuSortBuffers, g_splatBuffer, g_cullBuffers.visible, g_cullBuffers.args,
+                                      view);
+                memcpy(g_cullState, cullState, sizeof(g_cullState));
+            } else {
+                PROFILE_GPU("gpu_sort");
+                if (cut_active())
+                    gpu_sort_run_indices(g_gpuSortBuffers, g_splatBuffer, g_orderBuffer, g_drawCount, view);
+                else
+                    gpu_sort_run(g_gpuSortBuffers, g_splatBuffer, g_orderBuffer, view);
+            }
+            memcpy(g_gpuSortView, view, sizeof(g_gpuSortView));
+            g_gpuSorted = true;
+            g_gpuCulled = cull;
+        }
+    }
+}
+
+static bool use_pipeline()
+{
+    return g_options.pipelineSort && sort_mode() == SORT_CPU && !g_streaming && !g_streamCut;
+}
+
+// Post this frame's camera to the sort worker and upload the newest order
+// it finished. view/proj become the camera that order was made for.
+static void pipeline_frame(float view[16], float proj[16], int height)
+{
+    if (!sort_pipeline_active()) {
+        SortPipelineScene scene;
+        for (int k = 0; k < 3; ++k) scene.centers[k] = g_centers[k].data();
+        scene.count = g_splatCount;
+        scene.lod = g_hasLod ? &g_lod : nullptr;
+        scene.maxTranslationDelta = g_sorter.maxTranslationDelta;
+        sort_pipeline_start(scene);
+        g_hasPipeResult = false;
+        g_lodActive = false;
+    }
+
+    SortRequest req;
+    req.frame = ++g_frameCounter;
+    req.sampleNs = sort_pipeline_now_ns();
+    memcpy(req.view, view, sizeof(req.view));
+    memcpy(req.proj, proj, sizeof(req.proj));
+    req.height = height;
+    req.lod = g_options.lod;
+    req.lodPixelSize = g_options.lodPixelSize;
+    sort_pipeline_submit(req);
+
+    const SortResult *r = sort_pipeline_acquire();
+    if (r) {
+        g_drawCount = r->order.size();
+        if (g_drawCount > 0) {
+            PROFILE_ZONE("upload");
+            PROFILE_GPU("upload");
+            ssbo_update(g_orderBuffer, 0, r->order.data(), g_drawCount * sizeof(uint32_t));
+        }
+        memcpy(g_pipeView, r->request.view, sizeof(g_pipeView));
+        memcpy(g_pipeProj, r->request.proj, sizeof(g_pipeProj));
+        g_hasPipeResult = true;
+        g_stats.sort = r->sort;
+        g_stats.lod = r->lodActive ? r->lod : SplatLodCutStats();
+        g_stats.culled = r->culled;
+        g_stats.pipelineWorkMs = (float)r->workMs;
+        g_stats.pipelineLatencyMs = (float)((sort_pipeline_now_ns() - r->request.sampleNs) * 1e-6);
+        g_stats.pipelineLagFrames = (int)(g_frameCounter - r->request.frame);
+    }
+    // until the first result the buffer still holds a valid order
+    if (g_hasPipeResult) {
+        memcpy(view, g_pipeView, sizeof(g_pipeView));
+        memcpy(proj, g_pipeProj, sizeof(g_pipeProj));
+    }
+}
+
+// Render every original splat on the CPU (cpu_raster.h) and upload the
+// image to the scene texture. No sort, cut or cull: it bins and sorts
+// per tile itself.
+static void render_cpu(const float view[16], const float proj[16], int width, int height)
+{
+    PROFILE_ZONE("cpu raster");
+    ensure_host_copy();
+    if (!cpu_target(width, height)) return;
+
+    CpuRasterScene scene;
+    scene.splats = g_hostSplats.data();
+    scene.count = g_hostSplats.size();
+    CpuRasterParams params;
+    memcpy(params.view, view, sizeof(params.view));
+    memcpy(params.proj, proj, sizeof(params.proj));
+    params.width = width;
+    params.height = height;
+    params.splatScale = g_options.splatScale;
+    params.threads = (unsigned)std::max(0, g_options.cpuThreads);
+    g_cpuImage.resize((size_t)width * height * 4);
+    if (!cpu_raster_render(scene, params, g_cpuImage.data(), &g_stats.cpu)) return;
+
+    glBindTexture(GL_TEXTURE_2D, g_cpuTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, g_cpuImage.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    g_stats.drawCount = g_stats.cpu.visible;
+    g_stats.culled = g_splatCount - g_stats.cpu.visible;
+}
+
+// Evaluate view-dependent colors into the packed splats when the view or
+// the packed colors changed since the last pass: a still camera costs
+// nothing, a moving one only the splats whose view direction turned past
+// GraphicsOptions::shAngleDeg.
+static void update_sh(const float view[16], const float proj[16])
+{
+    g_stats.shEvaluating = false;
+    size_t evaluated;
+    if (splat_sh_poll_evaluated(&evaluated)) g_stats.shEvaluated = evaluated;
+    int degree = std::max(0, std::min(g_options.shDegree, g_sh.degree));
+    if (degree != g_shDegree) {
+        // without SH the band-0 colors come back from the splats; with
+        // another number of bands every color is evaluated again
+        if (degree == 0) pack_splats(0, g_sh.count);
+        else splat_sh_invalidate(g_sh, 0, g_sh.count);
+        g_shDegree = degree;
+        g_shDirty = true;
+    }
+    g_stats.shDegree = degree;
+    if (degree == 0) return;
+    if (!g_shDirty && memcmp(g_shView, view, 16 * sizeof(float)) == 0 &&
+        memcmp(g_shView + 16, proj, 16 * sizeof(float)) == 0)
+        return;
+
+    PROFILE_ZONE("sh");
+    PROFILE_GPU("sh");
+    SplatShParams params;
+    memcpy(params.view, view, sizeof(params.view));
+    memcpy(params.proj, proj, sizeof(params.proj));
+    params.degree = degree;
+    params.angleDeg = g_options.shAngleDeg;
+    splat_sh_run(g_sh, g_splatBuffer, g_packedBuffer, g_sh.count, params);
+    memcpy(g_shView, view, 16 * sizeof(float));
+    memcpy(g_shView + 16, proj, 16 * sizeof(float));
+    g_shDirty = false;
+    g_stats.shEvaluating = true;
+}
+
+static void render_splats()
+{
+    GLint vp[4];
+    glGetIntegerv(GL_VIEWPORT, vp);
+    float aspect = vp[3] > 0 ? (float)vp[2] / (float)vp[3] : 1.0f;
+
+    float view[16], proj[16];
+    camera_view_matrix(g_camera, view);
+    camera_proj_matrix(g_camera, aspect, proj);
+
+    g_stats.editable = scene_in_memory();
+    g_stats.cpu = CpuRasterStats();
+    if (use_cpu_engine()) {
+        // the image is composited by the UI (graphics_scene_texture)
+        g_stats.lod = SplatLodCutStats();
+        g_stats.gpuCulled = g_stats.pipelined = false;
+        render_cpu(view, proj, vp[2], vp[3]);
+        g_stats.buffers = ssbo_stats();
+        return;
+    }
+
+    if (!g_hasLod || !g_options.lod) g_stats.lod = SplatLodCutStats();
+    poll_lod_build();
+    g_stats.streamUploadMs = 0.0f;
+    g_stats.pipelined = use_pipeline();
+    if (g_stats.pipelined) {
+        pipeline_frame(view, proj, vp[3]);
+    } else {
+        bool drawSetChanged = g_orderStale;
+        if (sort_pipeline_active()) {
+            // the buffer holds the worker's culled order
+            sort_pipeline_stop();
+            g_lodActive = false;
+            set_full_order();
+            drawSetChanged = true;
+        }
+        if (g_streaming) drawSetChanged = stream_update(view, proj) || drawSetChanged;
+        else drawSetChanged = update_cut(view, proj, vp[3]) || drawSetChanged;
+        sort_splats(view, proj, vp[3], drawSetChanged);
+    }
+    g_orderStale = false;
+    g_stats.drawCount = g_drawCount;
+    // the GPU's visible count arrives a few frames late
+    g_stats.gpuCulled = use_gpu_cull() && g_gpuCulled;
+    if (g_stats.gpuCulled) {
+        size_t visible;
+        if (gpu_cull_poll_visible(&visible)) g_stats.culled = g_drawCount > visible ? g_drawCount - visible : 0;
+    } else if (!g_stats.pipelined) {
+        g_stats.culled = 0;
+    }
+    update_sh(view, proj);
+
+    g_stats.tiles = TileRasterStats();
+    if (g_options.engine == ENGINE_TILES && g_tileEngineReady) {
+        // the image is composited by the UI (graphics_scene_texture)
+        PROFILE_ZONE("tiles");
+        PROFILE_GPU("tiles");
+        if (tile_raster_target(vp[2], vp[3])) {
+            tile_raster_render(g_packedBuffer, g_orderBuffer, g_drawCount, view, proj, g_options.splatScale);
+            g_stats.tiles = tile_raster_stats();
+        }
+        g_stats.buffers = ssbo_stats();
+        return;
+    }
+
+    // back-to-front "over" with premultiplied colors; sorted, so no depth test
+    PROFILE_ZONE("raster");
+    PROFILE_GPU("raster");
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    glUseProgram(g_splatProgram);
+    glUniformMatrix4fv(g_splatViewLoc, 1, GL_FALSE, view);
+    glUniformMatrix4fv(g_splatProjLoc, 1, GL_FALSE, proj);
+    glUniform2f(g_splatViewportLoc, (float)vp[2], (float)vp[3]);
+    glUniform2f(g_splatFocalLoc, proj[0] * vp[2] * 0.5f, proj[5] * vp[3] * 0.5f);
+    glUniform1f(g_splatScaleLoc, g_options.splatScale);
+    ssbo_bind(g_packedBuffer, 0);
+    glBindVertexArray(g_emptyVAO);
+    if (g_stats.gpuCulled) {
+        // as many instances as survived culling, straight from the GPU
+        ssbo_bind(g_cullBuffers.visible, 1);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ssbo_buffer(g_cullBuffers.args));
+        glDrawArraysIndirect(GL_TRIANGLE_STRIP, (const void *)(uintptr_t)ssbo_offset(g_cullBuffers.args));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else {
+        ssbo_bind(g_orderBuffer, 1);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)g_drawCount);
+    }
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    glDisable(GL_BLEND);
+    g_stats.buffers = ssbo_stats();
+}
+
+// ---------------------------------------------------------------------------
+// Editing
+
+// Undo steps are dropped oldest first beyond this much memory
+static const size_t k_undoBudgetBytes = (size_t)256 << 20;
+// Smallest estimated coverage of a splat at the picked pixel
+static const float k_pickMinAlpha = 0.2f;
+
+static void update_edit_stats()
+{
+    g_stats.undoSteps = g_undo.size();
+    g_stats.redoSteps = g_redo.size();
+    g_stats.undoBytes = 0;
+    for (const SplatEditStep &step : g_undo) g_stats.undoBytes += step.bytes();
+    for (const SplatEditStep &step : g_redo) g_stats.undoBytes += step.bytes();
+}
+
+// Upload the splats an edit wrote to g_hostSplats, in merged runs, and
+// bring everything derived from them up to date.
+static void flush_edits(std::vector<SplatRange> *dirty, uint16_t fields)
+{
+    PROFILE_ZONE("edit_upload");
+    PROFILE_GPU("edit_upload");
+    bool moved = (fields & SPLAT_FIELD_POSITION) != 0;
+    // the sort worker reads the centers
+    if (moved) sort_pipeline_stop();
+
+    splat_ranges_coalesce(dirty, k_editMergeGap);
+    g_stats.editUploadBytes = 0;
+    g_stats.editUploads = dirty->size();
+    for (const SplatRange &r : *dirty) {
+        size_t n = r.end - r.begin;
+        ssbo_update(g_splatBuffer, r.begin * sizeof(GpuSplat), &g_hostSplats[r.begin], n * sizeof(GpuSplat));
+        pack_splats(r.begin, n);
+        g_stats.editUploadBytes += n * sizeof(GpuSplat);
+        if (moved) {
+            for (size_t i = r.begin; i < r.end; ++i)
+                for (int k = 0; k < 3; ++k) g_centers[k][i] = g_hostSplats[i].position[k];
+        }
+    }
+    if (moved) g_cutCentersReady = 0;
+    // positions change the order, opacity what the GPU culls; colors neither
+    if (fields & (SPLAT_FIELD_POSITION | SPLAT_FIELD_OPACITY)) g_orderStale = true;
+
+    // coarse LOD splats stand in for the edited ones: refit them now, or
+    // once the build in flight lands
+    if (g_lodBuild.valid()) g_lodEdits.insert(g_lodEdits.end(), dirty->begin(), dirty->end());
+    else if (g_hasLod) refit_lod(*dirty);
+}
+
+bool graphics_edit(const SplatEdit *edits, size_t count)
+{
+    if (!scene_in_memory()) return false;
+    auto t0 = std::chrono::steady_clock::now();
+    ensure_host_copy();
+    SplatEditStep step;
+    std::vector<SplatRange> dirty;
+    if (!splat_edit_apply(g_hostSplats.data(), g_splatCount, edits, count, &step, &dirty)) {
+        fprintf(stderr, "graphics: invalid splat edit\n");
+        return false;
+    }
+    if (step.deltas.empty()) return true;
+    flush_edits(&dirty, step.fields);
+
+    g_undo.push_back(std::move(step));
+    g_redo.clear();
+    size_t bytes = 0;
+    for (const SplatEditStep &s : g_undo) bytes += s.bytes();
+    size_t drop = 0;
+    while (bytes > k_undoBudgetBytes && drop + 1 < g_undo.size()) bytes -= g_undo[drop++].bytes();
+    g_undo.erase(g_undo.begin(), g_undo.begin() + drop);
+    update_edit_stats();
+    g_stats.editMs = (float)ms_since(t0);
+    return true;
+}
+
+// Revert the newest step of `from` and move it, now its inverse, to `to`.
+static bool revert_step(std::vector<SplatEditStep> *from, std::vector<SplatEditStep> *to)
+{
+    if (!scene_in_memory() || from->empty()) return false;
+    auto t0 = std::chrono::steady_clock::now();
+    ensure_host_copy();
+    SplatEditStep step = std::move(from->back());
+    from->pop_back();
+    std::vector<SplatRange> dirty;
+    splat_edit_revert(g_hostSplats.data(), &step, &dirty);
+    flush_edits(&dirty, step.fields);
+    to->push_back(std::move(step));
+    update_edit_stats();
+    g_stats.editMs = (float)ms_since(t0);
+    return true;
+}
+
+bool graphics_undo()
+{
+    return revert_step(&g_undo, &g_redo);
+}
+
+bool graphics_redo()
+{
+    return revert_step(&g_redo, &g_undo);
+}
+
+// Run the selection pass for the current camera over a width x height view
+// and read the selected indices back, ascending. rect is in pixels, y up.
+static bool run_select(const float rectMin[2], const float rectMax[2], float minAlpha, int width, int height,
+                       std::vector<uint32_t> *selection)
+{
+    if (!selection || !scene_in_memory() || !g_selectProgram || width <= 0 || height <= 0) return false;
+    PROFILE_ZONE("select");
+    auto t0 = std::chrono::steady_clock::now();
+    size_t listBytes = g_splatCount * sizeof(uint32_t);
+    bool ok = g_selectList ? ssbo_size(g_selectList) >= listBytes || ssbo_resize(g_selectList, listBytes)
+                           : (g_selectList = ssbo_alloc(listBytes)) != 0;
+    uint32_t zero = 0;
+    if (ok && !g_selectCount) ok = (g_selectCount = ssbo_alloc(sizeof(zero))) != 0;
+    if (!ok) {
+        fprintf(stderr, "graphics: no memory for the selection pass\n");
+        return false;
+    }
+    ssbo_update(g_selectCount, 0, &zero, sizeof(zero));
+
+    float view[16], proj[16];
+    camera_view_matrix(g_camera, view);
+    camera_proj_matrix(g_camera, (float)width / (float)height, proj);
+    glUseProgram(g_selectProgram);
+    glUniformMatrix4fv(g_selectViewLoc, 1, GL_FALSE, view);
+    glUniformMatrix4fv(g_selectProjLoc, 1, GL_FALSE, proj);
+    glUniform2f(g_selectViewportLoc, (float)width, (float)height);
+    glUniform1f(g_selectFocalLoc, proj[5] * height * 0.5f);
+    glUniform1f(g_selectScaleLoc, g_options.splatScale);
+    glUniform2f(g_selectRectMinLoc, rectMin[0], rectMin[1]);
+    glUniform2f(g_selectRectMaxLoc, rectMax[0], rectMax[1]);
+    glUniform1f(g_selectAlphaLoc, minAlpha);
+    glUniform1ui(g_selectCountLoc, (GLuint)g_splatCount);
+    ssbo_bind(g_packedBuffer, 0);
+    ssbo_bind(g_selectList, 2);
+    ssbo_bind(g_selectCount, 7);
+    glDispatchCompute((GLuint)std::min<size_t>((g_splatCount + 255) / 256, 65535), 1, 1);
+    glUseProgram(0);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    uint32_t n = 0;
+    ssbo_read(g_selectCount, 0, &n, sizeof(n));
+    selection->resize(std::min<size_t>(n, g_splatCount));
+    if (!selection->empty()) ssbo_read(g_selectList, 0, selection->data(), selection->size() * sizeof(uint32_t));
+    std::sort(selection->begin(), selection->end());
+    g_stats.selectMs = (float)ms_since(t0);
+    return true;
+}
+
+bool graphics_select(float x0, float y0, float x1, float y1, int width, int height,
+                     std::vector<uint32_t> *selection)
+{
+    float rectMin[2] = {std::min(x0, x1), (float)height - std::max(y0, y1)};
+    float rectMax[2] = {std::max(x0, x1), (float)height - std::min(y0, y1)};
+    return run_select(rectMin, rectMax, 0.0f, width, height, selection);
+}
+
+bool graphics_pick(float x, float y, int width, int height, uint32_t *index)
+{
+    float pixel[2] = {x, (float)height - y};
+    std::vector<uint32_t> hits;
+    if (!index || !run_select(pixel, pixel, k_pickMinAlpha, width, height, &hits)) return false;
+
+    // the front-most of the splats covering the pixel
+    float view[16];
+    camera_view_matrix(g_camera, view);
+    float nearest = INFINITY;
+    for (uint32_t i : hits) {
+        float px = g_centers[0][i], py = g_centers[1][i], pz = g_centers[2][i];
+        float depth = -(view[2] * px + view[6] * py + view[10] * pz + view[14]);
+        if (depth < nearest) {
+            nearest = depth;
+            *index = i;
+        }
+    }
+    return !hits.empty();
 }
 
 void graphics_render()
 {
+    if (g_splatCount > 0 && g_splatProgram) {
+        render_splats();
+        return;
+    }
+
     if (g_triProgram == 0 || g_triVAO == 0) return;
     glUseProgram(g_triProgram);
-    ssbo_bind_base(0);
+    ssbo_bind(g_colorBuffer, 0);
     glBindVertexArray(g_triVAO);
     glDrawArrays(GL_TRIANGLES, 0, 3);
     glBindVertexArray(0);
@@ -139,7 +1566,29 @@ void graphics_render()
 void graphics_shutdown()
 {
     if (g_triProgram) { glDeleteProgram(g_triProgram); g_triProgram = 0; }
+    if (g_splatProgram) { glDeleteProgram(g_splatProgram); g_splatProgram = 0; }
+    if (g_packProgram) { glDeleteProgram(g_packProgram); g_packProgram = 0; }
+    if (g_selectProgram) { glDeleteProgram(g_selectProgram); g_selectProgram = 0; }
+    if (g_emptyVAO) { glDeleteVertexArrays(1, &g_emptyVAO); g_emptyVAO = 0; }
+    unload_scene();
+    scene_stream_shutdown();
+    sort_pipeline_shutdown();
+    ssbo_free(g_colorBuffer);
+    g_colorBuffer = 0;
+    tile_raster_shutdown();
+    g_tileEngineReady = false;
+    if (g_cpuTexture) { glDeleteTextures(1, &g_cpuTexture); g_cpuTexture = 0; }
+    g_cpuWidth = g_cpuHeight = 0;
+    std::vector<uint8_t>().swap(g_cpuImage);
+    gpu_cull_shutdown();
+    g_gpuCullReady = false;
+    splat_sh_shutdown();
+    g_shReady = false;
+    gpu_sort_shutdown();
+    g_gpuSortReady = false;
+    g_lastSortMode = SORT_NONE;
     if (g_triVBO) { glDeleteBuffers(1, &g_triVBO); g_triVBO = 0; }
     if (g_triVAO) { glDeleteVertexArrays(1, &g_triVAO); g_triVAO = 0; }
-    ssbo_destroy();
+    shader_shutdown();
+    ssbo_shutdown();
 }
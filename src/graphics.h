@@ -1,13 +1,176 @@
 #pragma once
 
 #include <cstddef>
+#include <vector>
+#include "camera.h"
+#include "depth_sort.h"
+#include "ssbo.h"
+#include "tile_raster.h"
+#include "cpu_raster.h"
+#include "splat_lod.h"
+#include "splat_edit.h"
+
+// How splats are put in back-to-front order each frame.
+enum SortMode {
+    SORT_NONE = 0, // keep the current order
+    SORT_CPU,      // depth_sort on the host, order uploaded every frame
+    SORT_GPU,      // compute-shader radix sort, order never leaves the GPU
+};
+
+// How sorted splats become pixels.
+enum RenderEngine {
+    ENGINE_RASTER = 0, // instanced quads blended by the raster pipeline
+    ENGINE_TILES,      // tile-binned compute rasterizer (tile_raster.h)
+    ENGINE_CPU,        // reference renderer on the CPU (cpu_raster.h), uploaded as an image
+};
+
+// Runtime switches, edited by the UI.
+struct GraphicsOptions {
+    int sortMode = SORT_CPU;
+    int engine = ENGINE_RASTER;
+    bool lod = true;            // draw an LOD cut when the scene has a hierarchy
+    float lodPixelSize = 2.0f;  // octree nodes below this many pixels draw merged
+    int lodMinSplats = 1 << 20; // scenes this large get a hierarchy at load
+    float splatScale = 1.0f; // multiplies every splat's scale
+    float streamBudgetMs = 4.0f; // chunk uploads per frame while a scene streams in
+    int gpuBudgetMB = 0;     // streamed scenes above this render out of core (0: no limit)
+    bool pipelineSort = false; // CPU cut/sort/cull on a worker, drawn a frame later (sort_pipeline.h)
+    bool gpuCull = true;       // GPU sort: cull on the GPU, sort and draw only the visible splats (gpu_cull.h)
+    float cullPixelRadius = 0.0f; // GPU cull: also drop splats smaller than this on screen (0: off)
+    int cpuThreads = 0;        // CPU engine: threads to render with (0: all)
+    int shDegree = 3;          // SH bands loaded with the next scene (up to the file's) and evaluated (splat_sh.h)
+    float shAngleDeg = 1.0f;   // keep a splat's SH color until its view direction turns this far (0: any change)
+};
+
+// Per-frame numbers for the UI.
+struct GraphicsStats {
+    size_t splatCount = 0;
+    size_t drawCount = 0; // splats sorted and drawn this frame
+    bool gpuSortAvailable = false;
+    bool gpuCullAvailable = false;
+    bool tileEngineAvailable = false;
+    DepthSortStats sort; // CPU sort only
+    TileRasterStats tiles; // tile engine only
+    CpuRasterStats cpu;    // CPU engine only
+    bool lodAvailable = false;
+    size_t lodNodes = 0;
+    SplatLodCutStats lod; // while drawing an LOD cut
+    SsboStats buffers;
+
+    // streamed scenes (graphics_load_scene_async)
+    bool streaming = false;      // chunks still arriving, or paged out of core
+    bool outOfCore = false;
+    bool lodBuilding = false;    // hierarchy being built after the last chunk
+    size_t chunkCount = 0;
+    size_t chunksLoaded = 0;     // decoded at least once
+    size_t chunksResident = 0;
+    size_t chunkSlots = 0;       // GPU pool size, in chunks
+    size_t evictions = 0;
+    float streamUploadMs = 0.0f; // spent uploading chunks this frame
+
+    // splats outside the view dropped before the sort, by the sort worker
+    // or the GPU cull (whose count arrives a few frames late)
+    size_t culled = 0;
+    bool gpuCulled = false;         // drawn indirectly from the GPU's visible list
+
+    // pipelined CPU sort; the numbers are for the order drawn, taken when
+    // it arrived from the worker
+    bool pipelined = false;
+    float pipelineWorkMs = 0.0f;    // worker time (cut, sort, cull)
+    float pipelineLatencyMs = 0.0f; // from sampling the camera to drawing with it
+    int pipelineLagFrames = 0;      // frames between the two
+
+    // editing (graphics_edit); uploads are for the last edit, undo or redo
+    bool editable = false;        // the whole scene is in memory
+    size_t editUploadBytes = 0;
+    size_t editUploads = 0;       // merged ranges
+    float editMs = 0.0f;          // applying and uploading it
+    float selectMs = 0.0f;        // last selection pass, with its readback
+    size_t undoSteps = 0, redoSteps = 0;
+    size_t undoBytes = 0;         // both stacks
+
+    // view-dependent color (splat_sh.h)
+    int shDegreeLoaded = 0;       // SH bands held on the GPU
+    int shDegree = 0;             // bands evaluated
+    size_t shBytes = 0;           // GPU memory of the coefficients and directions
+    bool shEvaluating = false;    // the pass ran this frame
+    size_t shEvaluated = 0;       // splats its newest finished run evaluated (a few frames late)
+};
 
 // Initialize graphics resources (shaders, VAO/VBO, SSBO) using initial color data.
 // `initial_colors` should point to an array of vec4 (rgba) for each vertex.
 bool graphics_init(const float* initial_colors, size_t byteSize);
 
-// Update colors stored in the SSBO (must match size used in graphics_init).
-void graphics_update_colors(const float* colors, size_t byteSize);
+// Load a 3D Gaussian Splatting .ply scene (or a .gsb cache written by
+// gsb_convert), replacing any scene loaded before. Scenes of at least
+// GraphicsOptions::lodMinSplats splats also get an LOD hierarchy (splat_lod.h).
+// SH bands up to GraphicsOptions::shDegree are kept for view-dependent
+// color. Must be called after graphics_init.
+bool graphics_load_scene(const char* path);
+
+// Start streaming a .ply or .gsb scene in the background, replacing any
+// scene loaded or still streaming, and return at once (false only if the
+// file can't be opened). Decoded chunks are uploaded by graphics_render
+// within GraphicsOptions::streamBudgetMs per frame, so the scene fills in
+// progressively. When the scene needs more GPU memory than
+// GraphicsOptions::gpuBudgetMB it is rendered out of core: only chunks in
+// view are kept, least recently used ones are evicted, and there is no LOD.
+// Otherwise large scenes get their hierarchy once every chunk is in.
+bool graphics_load_scene_async(const char* path);
+
+// Stop streaming; chunks already uploaded stay and are drawn.
+void graphics_cancel_load();
+
+// Load splats from memory (e.g. a generated scene), replacing any loaded
+// scene. Like graphics_load_scene, builds an LOD hierarchy when the scene
+// has at least GraphicsOptions::lodMinSplats splats.
+bool graphics_load_splats(const GpuSplat* splats, size_t count);
+
+// Number of splats in the loaded scene (0 if none).
+size_t graphics_splat_count();
+
+GraphicsOptions* graphics_options();
+const GraphicsStats& graphics_stats();
+
+// Camera used to view the loaded scene.
+Camera* graphics_camera();
+
+// Update byteSize bytes of the color SSBO from byteOffset on (within the
+// size used in graphics_init), e.g. just the vertex that changed.
+void graphics_update_colors(const float* colors, size_t byteSize, size_t byteOffset = 0);
+
+// Splat editing, for scenes held whole (not while one streams in or renders
+// out of core). Edits apply on all cores to a host copy of the splats, read
+// back on first use, and upload only the splats they changed, nearby ones
+// merged into one upload. Each graphics_edit call is one undo step, which
+// stores just the overwritten fields of the splats it touched. Scenes with
+// an LOD hierarchy get the nodes above the edited splats refitted.
+
+// Apply `count` edits in order. Returns false, changing nothing, when the
+// scene can't be edited or an edit is invalid.
+bool graphics_edit(const SplatEdit* edits, size_t count);
+
+// Undo the newest edit, or redo the newest undone one. Returns false when
+// there is none. A new edit clears the redo steps.
+bool graphics_undo();
+bool graphics_redo();
+
+// Select, on the GPU, the splats whose centers fall in the rectangle between
+// (x0, y0) and (x1, y1) of a width x height view of the current camera
+// (pixels, origin at the top left). `selection` gets their indices,
+// ascending; deleted splats are never selected.
+bool graphics_select(float x0, float y0, float x1, float y1, int width, int height,
+                     std::vector<uint32_t>* selection);
+
+// The front-most splat visibly covering pixel (x, y). Returns false when
+// there is none.
+bool graphics_pick(float x, float y, int width, int height, uint32_t* index);
+
+// Image the tile or CPU engine renders the scene into, sized for a width x height
+// framebuffer, or 0 when the scene is drawn straight into the framebuffer.
+// Call before ImGui::Render and draw it behind the UI (e.g. on ImGui's
+// background draw list); graphics_render fills it later in the frame.
+uint32_t graphics_scene_texture(int width, int height);
 
 // Render the graphics (triangle, etc.). Call before ImGui render so UI draws on top.
 void graphics_render();
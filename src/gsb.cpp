@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+#include "gsb.h"
+#include "half.h"
+#include "parallel.h"
+
+static_assert(sizeof(GsbHeader) == 112, "GsbHeader layout is part of the file format");
+
+static const size_t k_sectionAlign = 64;
+
+static size_t align_up(size_t v, size_t a)
+{
+    return (v + a - 1) / a * a;
+}
+
+static inline float clamp01(float v)
+{
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+static inline uint8_t to_unorm8(float v)
+{
+    return (uint8_t)lrintf(clamp01(v) * 255.0f);
+}
+
+static inline int8_t to_snorm8(float v)
+{
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    return (int8_t)lrintf(v * 127.0f);
+}
+
+static GsbQuantSplat quantize_splat(const GpuSplat &s, const float origin[3])
+{
+    GsbQuantSplat q;
+    for (int k = 0; k < 3; ++k) {
+        q.position[k] = half_from_float(s.position[k] - origin[k]);
+        q.scale[k] = half_from_float(s.scale[k]);
+    }
+    for (int k = 0; k < 4; ++k) q.rotation[k] = to_snorm8(s.rotation[k]);
+    for (int k = 0; k < 3; ++k) q.color[k] = to_unorm8(s.color[k]);
+    q.color[3] = to_unorm8(s.opacity);
+    return q;
+}
+
+static GpuSplat dequantize_splat(const GsbQuantSplat &q, const float origin[3])
+{
+    GpuSplat s;
+    for (int k = 0; k < 3; ++k) {
+        s.position[k] = half_to_float(q.position[k]) + origin[k];
+        s.scale[k] = half_to_float(q.scale[k]);
+    }
+    s._pad0 = 0.0f;
+
+    float r[4], len2 = 0.0f;
+    for (int k = 0; k < 4; ++k) {
+        r[k] = (float)q.rotation[k] / 127.0f;
+        len2 += r[k] * r[k];
+    }
+    if (len2 > 0.0f) {
+        float inv = 1.0f / sqrtf(len2);
+        for (int k = 0; k < 4; ++k) s.rotation[k] = r[k] * inv;
+    } else {
+        s.rotation[0] = 1.0f;
+        s.rotation[1] = s.rotation[2] = s.rotation[3] = 0.0f;
+    }
+
+    for (int k = 0; k < 3; ++k) s.color[k] = q.color[k] / 255.0f;
+    s.opacity = q.color[3] / 255.0f;
+    s.color[3] = s.opacity;
+    return s;
+}
+
+// ---------------------------------------------------------------------------
+// SH codebook (k-means over 45-float SH vectors)
+// ---------------------------------------------------------------------------
+
+static inline float sh_dist2(const float *a, const float *b)
+{
+    // fixed trip count with independent lanes so the compiler vectorizes it
+    float acc[8] = {};
+    int i = 0;
+    for (; i + 8 <= SPLAT_SH_REST_FLOATS; i += 8) {
+        for (int l = 0; l < 8; ++l) {
+            float t = a[i + l] - b[i + l];
+            acc[l] += t * t;
+        }
+    }
+    for (; i < SPLAT_SH_REST_FLOATS; ++i) {
+        float t = a[i] - b[i];
+        acc[0] += t * t;
+    }
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+static uint32_t nearest_entry(const float *v, const float *codebook, int k)
+{
+    uint32_t best = 0;
+    float bestD = FLT_MAX;
+    for (int c = 0; c < k; ++c) {
+        float d = sh_dist2(v, codebook + (size_t)c * SPLAT_SH_REST_FLOATS);
+        if (d < bestD) {
+            bestD = d;
+            best = (uint32_t)c;
+        }
+    }
+    return best;
+}
+
+static void build_sh_codebook(const float *shRest, size_t count, const GsbWriteOptions &opt,
+                              std::vector<float> &codebook, std::vector<uint16_t> &indices)
+{
+    const int F = SPLAT_SH_REST_FLOATS;
+    int k = opt.shCodebookSize;
+    if ((size_t)k > count) k = (int)count;
+
+    // train on a deterministic subsample, then assign every splat
+    size_t samples = count < opt.kmeansSamples ? count : opt.kmeansSamples;
+    std::vector<size_t> sampleIdx(samples);
+    for (size_t i = 0; i < samples; ++i) sampleIdx[i] = i * count / samples;
+
+    codebook.assign((size_t)k * F, 0.0f);
+    for (int c = 0; c < k; ++c) {
+        size_t src = sampleIdx[(size_t)c * samples / (size_t)k];
+        memcpy(&codebook[(size_t)c * F], shRest + src * F, F * sizeof(float));
+    }
+
+    std::vector<uint32_t> assign(samples);
+    for (int it = 0; it < opt.kmeansIterations; ++it) {
+        parallel_for(samples, 1024, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                assign[i] = nearest_entry(shRest + sampleIdx[i] * F, codebook.data(), k);
+        });
+
+        std::vector<double> sums((size_t)k * F, 0.0);
+        std::vector<uint32_t> counts(k, 0);
+        for (size_t i = 0; i < samples; ++i) {
+            const float *v = shRest + sampleIdx[i] * F;
+            double *sum = &sums[(size_t)assign[i] * F];
+            for (int f = 0; f < F; ++f) sum[f] += v[f];
+            ++counts[assign[i]];
+        }
+        for (int c = 0; c < k; ++c) {
+            // empty clusters keep their previous centroid
+            if (counts[c] == 0) continue;
+            for (int f = 0; f < F; ++f)
+                codebook[(size_t)c * F + f] = (float)(sums[(size_t)c * F + f] / counts[c]);
+        }
+    }
+
+    indices.resize(count);
+    parallel_for(count, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            indices[i] = (uint16_t)nearest_entry(shRest + i * F, codebook.data(), k);
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Writing
+// ---------------------------------------------------------------------------
+
+// Append `bytes` at `offset`, zero-padding from the current end (`*written`).
+static bool write_at(FILE *f, uint64_t *written, uint64_t offset, const void *data, size_t bytes)
+{
+    static const uint8_t zeros[k_sectionAlign] = {};
+    while (*written < offset) {
+        size_t n = (size_t)(offset - *written);
+        if (n > sizeof(zeros)) n = sizeof(zeros);
+        if (fwrite(zeros, 1, n, f) != n) return false;
+        *written += n;
+    }
+    if (bytes > 0 && fwrite(data, 1, bytes, f) != bytes) return false;
+    *written += bytes;
+    return true;
+}
+
+bool gsb_write(const char *path, const GpuSplat *splats, const float *shRest, size_t count,
+               int shDegree, const float boundsMin[3], const float boundsMax[3],
+               const GsbWriteOptions &options)
+{
+    if (!path || !splats || count == 0) return false;
+    // a one-entry codebook would flatten every splat's SH to the same value
+    if (options.shCodebookSize < 0 || options.shCodebookSize == 1 || options.shCodebookSize > 65536) {
+        fprintf(stderr, "gsb: codebook size must be 0 (raw SH) or 2..65536, not %d\n", options.shCodebookSize);
+        return false;
+    }
+
+    GsbHeader h = {};
+    h.magic = GSB_MAGIC;
+    h.version = GSB_VERSION;
+    h.count = count;
+    for (int k = 0; k < 3; ++k) {
+        h.boundsMin[k] = boundsMin[k];
+        h.boundsMax[k] = boundsMax[k];
+        h.origin[k] = 0.5f * (boundsMin[k] + boundsMax[k]);
+    }
+
+    bool withSh = options.includeSh && shRest && shDegree > 0;
+    bool codebook = withSh && options.shCodebookSize > 0;
+    h.shDegree = withSh ? (uint32_t)shDegree : 0;
+    if (options.quantize) h.flags |= GSB_QUANTIZED;
+    if (withSh) h.flags |= GSB_HAS_SH;
+    if (codebook) h.flags |= GSB_SH_CODEBOOK;
+
+    // encode sections up front so the header can carry their sizes
+    std::vector<GsbQuantSplat> quant;
+    if (options.quantize) {
+        quant.resize(count);
+        parallel_for(count, 1 << 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) quant[i] = quantize_splat(splats[i], h.origin);
+        });
+    }
+
+    std::vector<float> book;
+    std::vector<uint16_t> indices;
+    if (codebook) build_sh_codebook(shRest, count, options, book, indices);
+
+    h.splatBytes = count * (options.quantize ? sizeof(GsbQuantSplat) : sizeof(GpuSplat));
+    h.splatOffset = align_up(sizeof(GsbHeader), k_sectionAlign);
+    uint64_t cursor = h.splatOffset + h.splatBytes;
+    if (withSh) {
+        h.shBytes = codebook ? count * sizeof(uint16_t) : count * SPLAT_SH_REST_FLOATS * sizeof(float);
+        h.shOffset = align_up((size_t)cursor, k_sectionAlign);
+        cursor = h.shOffset + h.shBytes;
+    }
+    if (codebook) {
+        h.codebookSize = (uint32_t)(book.size() / SPLAT_SH_REST_FLOATS);
+        h.codebookBytes = book.size() * sizeof(float);
+        h.codebookOffset = align_up((size_t)cursor, k_sectionAlign);
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "gsb: cannot write %s\n", path);
+        return false;
+    }
+
+    uint64_t written = 0;
+    bool ok = write_at(f, &written, 0, &h, sizeof(h));
+    const void *splatData = options.quantize ? (const void *)quant.data() : (const void *)splats;
+    ok = ok && write_at(f, &written, h.splatOffset, splatData, (size_t)h.splatBytes);
+    if (withSh) {
+        const void *shData = codebook ? (const void *)indices.data() : (const void *)shRest;
+        ok = ok && write_at(f, &written, h.shOffset, shData, (size_t)h.shBytes);
+    }
+    if (codebook) ok = ok && write_at(f, &written, h.codebookOffset, book.data(), (size_t)h.codebookBytes);
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok) fprintf(stderr, "gsb: write failed for %s\n", path);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Reading
+// ---------------------------------------------------------------------------
+
+static bool section_ok(const GsbFile &g, uint64_t offset, uint64_t bytes)
+{
+    return offset <= g.file.size && bytes <= g.file.size - offset && offset % k_sectionAlign == 0;
+}
+
+bool gsb_open(const char *path, GsbFile *out)
+{
+    if (!path || !out) return false;
+    *out = GsbFile();
+    if (!mapped_file_open(path, &out->file)) return false;
+
+    if (out->file.size < sizeof(GsbHeader)) {
+        fprintf(stderr, "gsb: %s is too small\n", path);
+        gsb_close(out);
+        return false;
+    }
+    memcpy(&out->header, out->file.data, sizeof(GsbHeader));
+    const GsbHeader &h = out->header;
+
+    if (h.magic != GSB_MAGIC || h.version != GSB_VERSION) {
+        fprintf(stderr, "gsb: %s is not a version %u .gsb file\n", path, GSB_VERSION);
+        gsb_close(out);
+        return false;
+    }
+
+    size_t recordBytes = (h.flags & GSB_QUANTIZED) ? sizeof(GsbQuantSplat) : sizeof(GpuSplat);
+    bool ok = h.count > 0 && h.splatBytes == h.count * recordBytes &&
+              section_ok(*out, h.splatOffset, h.splatBytes);
+    if (ok && (h.flags & GSB_HAS_SH)) {
+        size_t shRecord = (h.flags & GSB_SH_CODEBOOK) ? sizeof(uint16_t) : SPLAT_SH_REST_FLOATS * sizeof(float);
+        ok = h.shBytes == h.count * shRecord && section_ok(*out, h.shOffset, h.shBytes);
+    }
+    if (ok && (h.flags & GSB_SH_CODEBOOK)) {
+        ok = h.codebookSize > 0 && h.codebookSize <= 65536 &&
+             h.codebookBytes == (uint64_t)h.codebookSize * SPLAT_SH_REST_FLOATS * sizeof(float) &&
+             section_ok(*out, h.codebookOffset, h.codebookBytes);
+    }
+    if (!ok) {
+        fprintf(stderr, "gsb: %s has corrupt section table\n", path);
+        gsb_close(out);
+        return false;
+    }
+
+    out->splats = out->file.data + h.splatOffset;
+    if (h.flags & GSB_HAS_SH) out->sh = out->file.data + h.shOffset;
+    if (h.flags & GSB_SH_CODEBOOK) out->codebook = (const float *)(out->file.data + h.codebookOffset);
+    return true;
+}
+
+void gsb_decode(const GsbFile &gsb, size_t first, size_t count, const SplatSink &out)
+{
+    const GsbHeader &h = gsb.header;
+
+    if (out.splats || out.centers[0]) {
+        if (h.flags & GSB_QUANTIZED) {
+            const GsbQuantSplat *src = (const GsbQuantSplat *)gsb.splats;
+            for (size_t i = first; i < first + count; ++i) {
+                GsbQuantSplat q;
+                memcpy(&q, &src[i], sizeof(q));
+                GpuSplat s = dequantize_splat(q, h.origin);
+                size_t o = i - out.first;
+                if (out.splats) out.splats[o] = s;
+                if (out.centers[0]) {
+                    for (int k = 0; k < 3; ++k) out.centers[k][o] = s.position[k];
+                }
+            }
+        } else {
+            const uint8_t *src = gsb.splats + first * sizeof(GpuSplat);
+            if (out.splats) memcpy(out.splats + (first - out.first), src, count * sizeof(GpuSplat));
+            if (out.centers[0]) {
+                for (size_t i = 0; i < count; ++i) {
+                    float p[3];
+                    memcpy(p, src + i * sizeof(GpuSplat) + offsetof(GpuSplat, position), sizeof(p));
+                    for (int k = 0; k < 3; ++k) out.centers[k][first - out.first + i] = p[k];
+                }
+            }
+        }
+    }
+
+    if (!out.shRest) return;
+    const size_t F = SPLAT_SH_REST_FLOATS;
+    float *shRest = out.shRest + (first - out.first) * F;
+    if (!(h.flags & GSB_HAS_SH)) {
+        memset(shRest, 0, count * F * sizeof(float));
+    } else if (h.flags & GSB_SH_CODEBOOK) {
+        const uint8_t *idx = gsb.sh + first * sizeof(uint16_t);
+        for (size_t i = 0; i < count; ++i) {
+            uint16_t e;
+            memcpy(&e, idx + i * sizeof(uint16_t), sizeof(e));
+            if (e >= h.codebookSize) e = 0;
+            memcpy(shRest + i * F, gsb.codebook + (size_t)e * F, F * sizeof(float));
+        }
+    } else {
+        memcpy(shRest, gsb.sh + first * F * sizeof(float), count * F * sizeof(float));
+    }
+}
+
+void gsb_load(const GsbFile &gsb, const SplatSink &out)
+{
+    size_t count = (size_t)gsb.header.count;
+    parallel_for(count, 1 << 16, [&](size_t begin, size_t end) {
+        gsb_decode(gsb, begin, end - begin, out);
+    });
+}
+
+void gsb_close(GsbFile *gsb)
+{
+    if (!gsb) return;
+    mapped_file_close(&gsb->file);
+    *gsb = GsbFile();
+}
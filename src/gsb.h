@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "mapped_file.h"
+#include "splat.h"
+
+// .gsb: preprocessed splat cache. A fixed header followed by 64-byte aligned
+// sections, all little-endian:
+//   splats   GpuSplat[count]            (raw), or
+//            GsbQuantSplat[count]       (GSB_QUANTIZED)
+//   sh       float[count][45]           (GSB_HAS_SH, raw), or
+//            uint16_t[count] indices    (GSB_HAS_SH | GSB_SH_CODEBOOK)
+//   codebook float[codebookSize][45]    (GSB_SH_CODEBOOK)
+// Raw splat sections are byte-identical to the SSBO contents, so loading is
+// a map plus one copy into the buffer.
+
+constexpr uint32_t GSB_MAGIC = 0x31425347u; // "GSB1"
+constexpr uint32_t GSB_VERSION = 1;
+
+enum GsbFlags : uint32_t {
+    GSB_QUANTIZED = 1u << 0,   // half positions/scales, snorm8 rotation, unorm8 color+opacity
+    GSB_HAS_SH = 1u << 1,      // higher-band SH present
+    GSB_SH_CODEBOOK = 1u << 2, // SH stored as codebook indices
+};
+
+struct GsbHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t shDegree;
+    uint64_t count;
+    float boundsMin[3];
+    float boundsMax[3];
+    float origin[3];           // quantized positions are relative to this point
+    uint32_t codebookSize;
+    uint64_t splatOffset, splatBytes;
+    uint64_t shOffset, shBytes;
+    uint64_t codebookOffset, codebookBytes;
+};
+
+// 20-byte quantized splat record.
+struct GsbQuantSplat {
+    uint16_t position[3]; // half, relative to GsbHeader::origin
+    uint16_t scale[3];    // half
+    int8_t rotation[4];   // snorm8 quaternion (w, x, y, z)
+    uint8_t color[4];     // unorm8 RGB + opacity
+};
+
+static_assert(sizeof(GsbQuantSplat) == 20, "GsbQuantSplat must stay packed");
+
+struct GsbWriteOptions {
+    bool quantize = false;
+    bool includeSh = true;
+    int shCodebookSize = 0;    // 0 keeps raw SH; otherwise 2..65536 entries
+    int kmeansIterations = 10;
+    size_t kmeansSamples = 1 << 16;
+};
+
+// Write `count` splats (and optional SH rest, SPLAT_SH_REST_FLOATS per splat)
+// to `path`. Returns false (and logs) on I/O failure.
+bool gsb_write(const char *path, const GpuSplat *splats, const float *shRest, size_t count,
+               int shDegree, const float boundsMin[3], const float boundsMax[3],
+               const GsbWriteOptions &options);
+
+// A memory-mapped .gsb file.
+struct GsbFile {
+    MappedFile file;
+    GsbHeader header = {};
+    const uint8_t *splats = nullptr;
+    const uint8_t *sh = nullptr;
+    const float *codebook = nullptr;
+};
+
+// Map `path` and validate its header and section bounds.
+bool gsb_open(const char *path, GsbFile *out);
+
+// Expand splats [first, first + count) into the sink's arrays (at the same
+// indices, less SplatSink::first). SH is zero-filled when the file has none.
+void gsb_decode(const GsbFile &gsb, size_t first, size_t count, const SplatSink &out);
+
+// Decode the whole file into the sink across all cores.
+void gsb_load(const GsbFile &gsb, const SplatSink &out);
+
+void gsb_close(GsbFile *gsb);
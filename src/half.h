@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 binary16 conversion (round to nearest even, no FP16 hardware needed).
+
+inline uint16_t half_from_float(float value)
+{
+    uint32_t f;
+    memcpy(&f, &value, 4);
+    uint32_t sign = (f >> 16) & 0x8000u;
+    uint32_t exp = (f >> 23) & 0xFFu;
+    uint32_t mant = f & 0x7FFFFFu;
+
+    if (exp == 0xFFu) // inf / nan
+        return (uint16_t)(sign | 0x7C00u | (mant ? 0x200u : 0u));
+
+    int e = (int)exp - 127 + 15;
+    if (e >= 31) return (uint16_t)(sign | 0x7C00u); // overflow -> inf
+    if (e <= 0) {
+        if (e < -10) return (uint16_t)sign; // underflow -> signed zero
+        // subnormal half
+        mant |= 0x800000u;
+        uint32_t shift = (uint32_t)(14 - e);
+        uint32_t h = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (h & 1u))) ++h;
+        return (uint16_t)(sign | h);
+    }
+
+    uint32_t h = ((uint32_t)e << 10) | (mant >> 13);
+    uint32_t rem = mant & 0x1FFFu;
+    if (rem > 0x1000u || (rem == 0x1000u && (h & 1u))) ++h; // may carry into exponent, which is correct
+    return (uint16_t)(sign | h);
+}
+
+inline float half_to_float(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    uint32_t exp = (h >> 10) & 0x1Fu;
+    uint32_t mant = h & 0x3FFu;
+    uint32_t f;
+
+    if (exp == 0) {
+        if (mant == 0) {
+            f = sign;
+        } else {
+            // normalize the subnormal
+            int e = -1;
+            do {
+                ++e;
+                mant <<= 1;
+            } while ((mant & 0x400u) == 0);
+            f = sign | ((uint32_t)(127 - 15 - e) << 23) | ((mant & 0x3FFu) << 13);
+        }
+    } else if (exp == 31) {
+        f = sign | 0x7F800000u | (mant << 13);
+    } else {
+        f = sign | ((exp - 15 + 127) << 23) | (mant << 13);
+    }
+
+    float value;
+    memcpy(&value, &f, 4);
+    return value;
+}
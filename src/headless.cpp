@@ -0,0 +1,175 @@
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include "headless.h"
+
+#ifdef GSGL_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+static GLFWwindow *g_window = nullptr;
+static GLuint g_fbo = 0, g_color = 0;
+static int g_width = 0, g_height = 0;
+
+#ifdef GSGL_HAS_EGL
+static EGLDisplay g_eglDisplay = EGL_NO_DISPLAY;
+static EGLContext g_eglContext = EGL_NO_CONTEXT;
+
+// Surfaceless Mesa display (no X11/Wayland needed), or the default one.
+static bool egl_init()
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) g_eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (g_eglDisplay == EGL_NO_DISPLAY) g_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major = 0, minor = 0;
+    if (g_eglDisplay == EGL_NO_DISPLAY || !eglInitialize(g_eglDisplay, &major, &minor)) {
+        g_eglDisplay = EGL_NO_DISPLAY;
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) return false;
+
+    // 4.6 if offered, else 4.5 (llvmpipe); no config or surface needed
+    static const int k_minors[2] = {6, 5};
+    for (int minorVersion : k_minors) {
+        EGLint attribs[] = {EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, minorVersion,
+                            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE};
+        g_eglContext = eglCreateContext(g_eglDisplay, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+        if (g_eglContext != EGL_NO_CONTEXT) break;
+    }
+    if (g_eglContext == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(g_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, g_eglContext)) {
+        return false;
+    }
+    return gladLoadGLLoader((GLADloadproc)eglGetProcAddress) != 0;
+}
+
+static void egl_shutdown()
+{
+    if (g_eglDisplay == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(g_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (g_eglContext != EGL_NO_CONTEXT) eglDestroyContext(g_eglDisplay, g_eglContext);
+    eglTerminate(g_eglDisplay);
+    g_eglContext = EGL_NO_CONTEXT;
+    g_eglDisplay = EGL_NO_DISPLAY;
+}
+#endif
+
+static bool glfw_init()
+{
+    if (!glfwInit()) return false;
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    g_window = glfwCreateWindow(64, 64, "gsgl (headless)", NULL, NULL);
+    if (!g_window) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        g_window = glfwCreateWindow(64, 64, "gsgl (headless)", NULL, NULL);
+    }
+    if (!g_window) {
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(g_window);
+    glfwSwapInterval(0);
+    return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0;
+}
+
+bool headless_init(int width, int height)
+{
+    if (width <= 0 || height <= 0) return false;
+
+    bool ok = false;
+#ifdef GSGL_HAS_EGL
+    ok = egl_init();
+    if (!ok) {
+        egl_shutdown();
+        fprintf(stderr, "headless: no EGL context, trying a hidden window\n");
+    }
+#endif
+    if (!ok) ok = glfw_init();
+    if (!ok) {
+        fprintf(stderr, "headless: failed to create an OpenGL 4.5 context\n");
+        headless_shutdown();
+        return false;
+    }
+
+    glGenRenderbuffers(1, &g_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, g_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &g_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, g_color);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "headless: framebuffer incomplete\n");
+        headless_shutdown();
+        return false;
+    }
+    glViewport(0, 0, width, height);
+    g_width = width;
+    g_height = height;
+    printf("headless: %s, %dx%d\n", (const char *)glGetString(GL_RENDERER), width, height);
+    return true;
+}
+
+int headless_width()
+{
+    return g_width;
+}
+
+int headless_height()
+{
+    return g_height;
+}
+
+void headless_read_pixels(unsigned char *rgba)
+{
+    if (!g_fbo || !rgba) return;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, g_fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, g_width, g_height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+}
+
+bool headless_write_ppm(const char *path, const unsigned char *rgba, int width, int height)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "headless: cannot write %s\n", path);
+        return false;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+    unsigned char *row = new unsigned char[(size_t)width * 3];
+    for (int y = height - 1; y >= 0; --y) {
+        const unsigned char *src = rgba + (size_t)y * width * 4;
+        for (int x = 0; x < width; ++x) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        fwrite(row, 1, (size_t)width * 3, f);
+    }
+    delete[] row;
+    bool ok = ferror(f) == 0;
+    fclose(f);
+    return ok;
+}
+
+void headless_shutdown()
+{
+    if (g_fbo) { glDeleteFramebuffers(1, &g_fbo); g_fbo = 0; }
+    if (g_color) { glDeleteRenderbuffers(1, &g_color); g_color = 0; }
+    g_width = g_height = 0;
+#ifdef GSGL_HAS_EGL
+    egl_shutdown();
+#endif
+    if (g_window) {
+        glfwDestroyWindow(g_window);
+        g_window = nullptr;
+        glfwTerminate();
+    }
+}
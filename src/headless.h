@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+// Offscreen GL 4.5+ context for tools, self-tests and benchmarks, with no
+// visible window and no vsync. Uses an EGL surfaceless context where the
+// build has EGL (Mesa, including llvmpipe on machines without a display),
+// otherwise a hidden GLFW window. Rendering goes to a width x height RGBA8
+// framebuffer object that stays bound.
+
+// Create the context, load GL and bind the framebuffer. Returns false if
+// no context could be created.
+bool headless_init(int width, int height);
+
+int headless_width();
+int headless_height();
+
+// Read the framebuffer into `rgba` (width * height * 4 bytes, bottom row first).
+void headless_read_pixels(unsigned char *rgba);
+
+// Write bottom-up RGBA pixels as a binary PPM (top row first, alpha dropped).
+bool headless_write_ppm(const char *path, const unsigned char *rgba, int width, int height);
+
+void headless_shutdown();
@@ -0,0 +1,117 @@
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "lod_report.h"
+#include "graphics.h"
+#include "scene_gen.h"
+
+static const int k_width = 960, k_height = 540;
+
+static double ms_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static double render_frame(std::vector<unsigned char> *pixels)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    glClearColor(0.1f, 0.12f, 0.15f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    graphics_render();
+    glFinish();
+    double ms = ms_since(t0);
+    pixels->resize((size_t)k_width * k_height * 4);
+    glReadPixels(0, 0, k_width, k_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
+    return ms;
+}
+
+static double psnr(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b)
+{
+    double sum = 0.0;
+    size_t n = 0;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        for (int k = 0; k < 3; ++k) {
+            double d = (double)a[i + k] - (double)b[i + k];
+            sum += d * d;
+        }
+        n += 3;
+    }
+    double mse = sum / (double)n;
+    return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+bool lod_report(size_t count)
+{
+    if (count == 0) return false;
+    printf("lod_report: generating %zu splats\n", count);
+    std::vector<GpuSplat> splats = scene_generate_city(count);
+
+    GraphicsOptions *opt = graphics_options();
+    GraphicsOptions saved = *opt;
+    opt->lodMinSplats = 0;
+    bool ok = graphics_load_splats(splats.data(), splats.size());
+    std::vector<GpuSplat>().swap(splats);
+    if (!ok) {
+        *opt = saved;
+        fprintf(stderr, "lod_report: failed to load the scene\n");
+        return false;
+    }
+
+    GLuint fbo = 0, color = 0;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, k_width, k_height);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glViewport(0, 0, k_width, k_height);
+    opt->engine = ENGINE_RASTER;
+
+    struct View {
+        const char *name;
+        float target[3], distance, yaw, pitch;
+    };
+    const View views[] = {
+        {"street", {0.0f, 2.0f, 0.0f}, 90.0f, 0.0f, 0.02f},
+        {"aerial", {0.0f, 0.0f, 0.0f}, 160.0f, 0.6f, 0.7f},
+    };
+    const float pixelSizes[] = {1.0f, 2.0f, 4.0f, 8.0f, 16.0f};
+
+    Camera *cam = graphics_camera();
+    Camera savedCam = *cam;
+    std::vector<unsigned char> reference, image;
+    for (const View &v : views) {
+        for (int k = 0; k < 3; ++k) cam->target[k] = v.target[k];
+        cam->distance = v.distance;
+        cam->yaw = v.yaw;
+        cam->pitch = v.pitch;
+
+        opt->lod = false;
+        double fullMs = render_frame(&reference);
+        printf("\n%s view, %dx%d\n", v.name, k_width, k_height);
+        printf("  node px    splats   of scene   merged   frame ms   PSNR dB\n");
+        printf("  full   %10zu   %7.1f%%   %6d   %8.1f         -\n", count, 100.0, 0, fullMs);
+
+        opt->lod = true;
+        for (float px : pixelSizes) {
+            opt->lodPixelSize = px;
+            double ms = render_frame(&image);
+            const GraphicsStats &stats = graphics_stats();
+            printf("  %4.0f   %10zu   %7.1f%%   %6zu   %8.1f   %7.2f\n", px, stats.drawCount,
+                   100.0 * stats.drawCount / count, stats.lod.coarse, ms, psnr(reference, image));
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color);
+    *cam = savedCam;
+    *opt = saved;
+    return true;
+}
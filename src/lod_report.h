@@ -0,0 +1,8 @@
+#pragma once
+#include <cstddef>
+
+// Quality vs. splat count of the LOD cut on a generated city-block scene
+// of `count` splats: renders a street-level and an aerial view without LOD
+// and at several node sizes, and prints splats drawn, frame time and PSNR
+// against the full render. Needs a current GL context and graphics_init.
+bool lod_report(size_t count);
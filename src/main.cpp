@@ -2,21 +2,70 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "graphics.h"
 #include "renderer.h"
+#include "gpu_sort.h"
+#include "lod_report.h"
+#include "headless.h"
+#include "profiler.h"
+#include "shader.h"
+
+int main(int argc, char** argv) {
+    // gsgl [--no-vsync] [--gpu-budget MB] [scene.ply | scene.gsb]
+    // gsgl --sort-selftest [count]   compare the GPU sort against the CPU sort
+    // gsgl --lod-report [count]      LOD quality vs. splat count on a generated scene
+    // The self-test and report run offscreen (headless.h), no display needed.
+    const char* scene_path = nullptr;
+    size_t selftest_count = 0, lod_report_count = 0;
+    bool vsync = true;
+    int gpu_budget_mb = 0;
+    if (argc > 1 && strcmp(argv[1], "--sort-selftest") == 0) {
+        selftest_count = argc > 2 ? (size_t)strtoull(argv[2], NULL, 10) : 1000000;
+    } else if (argc > 1 && strcmp(argv[1], "--lod-report") == 0) {
+        lod_report_count = argc > 2 ? (size_t)strtoull(argv[2], NULL, 10) : 2000000;
+    } else {
+        for (int i = 1; i < argc; ++i) {
+            if (strcmp(argv[i], "--no-vsync") == 0) vsync = false;
+            else if (strcmp(argv[i], "--gpu-budget") == 0 && i + 1 < argc) gpu_budget_mb = atoi(argv[++i]);
+            else scene_path = argv[i];
+        }
+    }
+
+    if (selftest_count > 0) {
+        if (!headless_init(64, 64)) return -1;
+        bool passed = gpu_sort_selftest(selftest_count, 5);
+        gpu_sort_shutdown();
+        headless_shutdown();
+        return passed ? 0 : 1;
+    }
+
+    if (lod_report_count > 0) {
+        if (!headless_init(64, 64)) return -1;
+        bool reported = graphics_init(nullptr, 0) && lod_report(lod_report_count);
+        graphics_shutdown();
+        headless_shutdown();
+        return reported ? 0 : 1;
+    }
 
-int main() {
     if (!glfwInit()) {
         fprintf(stderr, "Failed to initialize GLFW\n");
         return -1;
     }
 
-    // Request OpenGL 4.6 core profile
+    // Request OpenGL 4.6 core profile; shaders only need 4.5 (SSBOs + compute),
+    // which is also what Mesa's llvmpipe offers
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     GLFWwindow* window = glfwCreateWindow(1280, 720, "GSOpenGL - ImGui+GLFW+GLAD", NULL, NULL);
+    if (!window) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        window = glfwCreateWindow(1280, 720, "GSOpenGL - ImGui+GLFW+GLAD", NULL, NULL);
+    }
     if (!window) {
         fprintf(stderr, "Failed to create GLFW window\n");
         glfwTerminate();
@@ -24,7 +73,7 @@ int main() {
     }
 
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
+    glfwSwapInterval(vsync ? 1 : 0);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         fprintf(stderr, "Failed to initialize GLAD\n");
@@ -37,13 +86,27 @@ int main() {
         0.0f, 0.0f, 1.0f, 1.0f  // vertex 2
     };
 
-    if (!graphics_init(initial_colors, sizeof(initial_colors))) {
+    // the color demo only runs without a scene
+    bool ok = scene_path ? graphics_init(nullptr, 0) : graphics_init(initial_colors, sizeof(initial_colors));
+    if (!ok) {
         fprintf(stderr, "Failed to initialize graphics\n");
         glfwDestroyWindow(window);
         glfwTerminate();
         return -1;
     }
 
+    // the scene streams in while the first frames are drawn, and the CPU
+    // sort runs beside the render loop instead of inside it
+    graphics_options()->gpuBudgetMB = gpu_budget_mb;
+    graphics_options()->pipelineSort = true;
+    if (scene_path && !graphics_load_scene_async(scene_path)) {
+        fprintf(stderr, "Failed to load scene %s\n", scene_path);
+        graphics_shutdown();
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return -1;
+    }
+
     if (!renderer_init(window, initial_colors, sizeof(initial_colors))) {
         fprintf(stderr, "Failed to initialize renderer\n");
         graphics_shutdown();
@@ -55,7 +118,9 @@ int main() {
     bool show_demo = true;
 
     while (!glfwWindowShouldClose(window)) {
+        profiler_begin_frame();
         glfwPollEvents();
+        shader_poll_reload();
 
         renderer_new_frame();
 
@@ -64,10 +129,15 @@ int main() {
 
         renderer_render(&show_demo);
 
-        glfwSwapBuffers(window);
+        {
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(window);
+        }
+        profiler_end_frame();
     }
 
     renderer_shutdown();
+    profiler_shutdown();
     graphics_shutdown();
 
     glfwDestroyWindow(window);
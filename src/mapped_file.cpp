@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool mapped_file_open(const char *path, MappedFile *out)
+{
+    if (!path || !out) return false;
+    *out = MappedFile();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "mapped_file: cannot open %s\n", path);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        fprintf(stderr, "mapped_file: %s is empty or unreadable\n", path);
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        fprintf(stderr, "mapped_file: CreateFileMapping failed for %s\n", path);
+        CloseHandle(file);
+        return false;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        fprintf(stderr, "mapped_file: MapViewOfFile failed for %s\n", path);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    out->data = (const uint8_t *)view;
+    out->size = (size_t)size.QuadPart;
+    out->fileHandle = file;
+    out->mappingHandle = mapping;
+    return true;
+}
+
+void mapped_file_close(MappedFile *file)
+{
+    if (!file) return;
+    if (file->data) UnmapViewOfFile(file->data);
+    if (file->mappingHandle) CloseHandle((HANDLE)file->mappingHandle);
+    if (file->fileHandle) CloseHandle((HANDLE)file->fileHandle);
+    *file = MappedFile();
+}
+
+#else
+
+bool mapped_file_open(const char *path, MappedFile *out)
+{
+    if (!path || !out) return false;
+    *out = MappedFile();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "mapped_file: cannot open %s\n", path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        fprintf(stderr, "mapped_file: %s is empty or unreadable\n", path);
+        close(fd);
+        return false;
+    }
+
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file referenced
+    if (view == MAP_FAILED) {
+        fprintf(stderr, "mapped_file: mmap failed for %s\n", path);
+        return false;
+    }
+    // splat payloads are read front to back by all worker threads at once;
+    // advice values are not flags, so each takes its own call
+    madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+    madvise(view, (size_t)st.st_size, MADV_WILLNEED);
+
+    out->data = (const uint8_t *)view;
+    out->size = (size_t)st.st_size;
+    return true;
+}
+
+void mapped_file_close(MappedFile *file)
+{
+    if (!file) return;
+    if (file->data) munmap((void *)file->data, file->size);
+    *file = MappedFile();
+}
+
+#endif
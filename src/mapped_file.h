@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file.
+struct MappedFile {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    void *fileHandle = nullptr;    // Win32 file / mapping handles (unused on POSIX)
+    void *mappingHandle = nullptr;
+};
+
+// Map `path` read-only into memory. Returns true on success.
+bool mapped_file_open(const char *path, MappedFile *out);
+
+// Unmap and reset the file. Safe to call on an unopened MappedFile.
+void mapped_file_close(MappedFile *file);
@@ -0,0 +1,84 @@
+#pragma once
+#include <math.h>
+
+// Minimal column-major 4x4 matrix helpers. Matrices are float[16] laid out
+// exactly as glUniformMatrix4fv(..., GL_FALSE, ...) expects.
+
+inline void mat4_identity(float out[16])
+{
+    for (int i = 0; i < 16; ++i) out[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+// out = a * b (out may not alias a or b)
+inline void mat4_mul(const float a[16], const float b[16], float out[16])
+{
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            float s = 0.0f;
+            for (int k = 0; k < 4; ++k) s += a[k * 4 + r] * b[c * 4 + k];
+            out[c * 4 + r] = s;
+        }
+    }
+}
+
+inline void mat4_perspective(float fovy, float aspect, float znear, float zfar, float out[16])
+{
+    float f = 1.0f / tanf(fovy * 0.5f);
+    for (int i = 0; i < 16; ++i) out[i] = 0.0f;
+    out[0] = f / aspect;
+    out[5] = f;
+    out[10] = (zfar + znear) / (znear - zfar);
+    out[11] = -1.0f;
+    out[14] = 2.0f * zfar * znear / (znear - zfar);
+}
+
+inline void vec3_sub(const float a[3], const float b[3], float out[3])
+{
+    out[0] = a[0] - b[0];
+    out[1] = a[1] - b[1];
+    out[2] = a[2] - b[2];
+}
+
+inline float vec3_dot(const float a[3], const float b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+inline void vec3_cross(const float a[3], const float b[3], float out[3])
+{
+    float x = a[1] * b[2] - a[2] * b[1];
+    float y = a[2] * b[0] - a[0] * b[2];
+    float z = a[0] * b[1] - a[1] * b[0];
+    out[0] = x;
+    out[1] = y;
+    out[2] = z;
+}
+
+inline void vec3_normalize(float v[3])
+{
+    float len = sqrtf(vec3_dot(v, v));
+    if (len > 0.0f) {
+        v[0] /= len;
+        v[1] /= len;
+        v[2] /= len;
+    }
+}
+
+// Right-handed view matrix looking from `eye` towards `target`.
+inline void mat4_look_at(const float eye[3], const float target[3], const float up[3], float out[16])
+{
+    float f[3], s[3], u[3];
+    vec3_sub(target, eye, f);
+    vec3_normalize(f);
+    vec3_cross(f, up, s);
+    vec3_normalize(s);
+    vec3_cross(s, f, u);
+
+    mat4_identity(out);
+    out[0] = s[0]; out[4] = s[1]; out[8] = s[2];
+    out[1] = u[0]; out[5] = u[1]; out[9] = u[2];
+    out[2] = -f[0]; out[6] = -f[1]; out[10] = -f[2];
+    out[12] = -vec3_dot(s, eye);
+    out[13] = -vec3_dot(u, eye);
+    out[14] = vec3_dot(f, eye);
+}
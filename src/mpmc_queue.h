@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded lock-free queue for any number of producer and consumer threads
+// (Vyukov's sequence-numbered ring). push and pop never block or allocate;
+// they return false when the queue is full or empty.
+template <typename T>
+struct MpmcQueue {
+    explicit MpmcQueue(size_t minCapacity)
+    {
+        size_t capacity = 2;
+        while (capacity < minCapacity) capacity <<= 1;
+        cells.reset(new Cell[capacity]);
+        mask = capacity - 1;
+        for (size_t i = 0; i < capacity; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const T &value)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &c = cells[pos & mask];
+            size_t seq = c.seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = value;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false; // full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T *out)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &c = cells[pos & mask];
+            size_t seq = c.seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    *out = c.value;
+                    c.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false; // empty
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
@@ -0,0 +1,134 @@
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "parallel.h"
+
+namespace {
+
+struct Job {
+    const std::function<void(size_t, size_t)> *fn = nullptr;
+    size_t count = 0;
+    size_t grain = 0;
+    size_t chunks = 0;
+    std::atomic<size_t> next{0};
+};
+
+struct Pool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    Job *job = nullptr;
+    uint64_t generation = 0;
+    unsigned active = 0;
+    bool quit = false;
+
+    std::mutex dispatch; // one parallel_for in flight at a time
+
+    ~Pool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::thread &t : workers) t.join();
+    }
+};
+
+thread_local bool t_inside_job = false;
+
+void run_chunks(Job &job)
+{
+    t_inside_job = true;
+    for (;;) {
+        size_t c = job.next.fetch_add(1, std::memory_order_relaxed);
+        if (c >= job.chunks) break;
+        size_t begin = c * job.grain;
+        size_t end = begin + job.grain < job.count ? begin + job.grain : job.count;
+        (*job.fn)(begin, end);
+    }
+    t_inside_job = false;
+}
+
+void worker_main(Pool *pool)
+{
+    std::unique_lock<std::mutex> lk(pool->mutex);
+    uint64_t seen = 0;
+    for (;;) {
+        pool->wake.wait(lk, [&] { return pool->quit || pool->generation != seen; });
+        if (pool->quit) return;
+        seen = pool->generation;
+        Job *job = pool->job;
+        if (!job) continue;
+        ++pool->active;
+        lk.unlock();
+        run_chunks(*job);
+        lk.lock();
+        if (--pool->active == 0) pool->idle.notify_all();
+    }
+}
+
+Pool &get_pool()
+{
+    static Pool pool;
+    static std::once_flag started;
+    std::call_once(started, [] {
+        unsigned hw = std::thread::hardware_concurrency();
+        unsigned extra = hw > 1 ? hw - 1 : 0;
+        for (unsigned i = 0; i < extra; ++i)
+            pool.workers.emplace_back(worker_main, &pool);
+    });
+    return pool;
+}
+
+} // namespace
+
+unsigned parallel_thread_count()
+{
+    return (unsigned)get_pool().workers.size() + 1;
+}
+
+void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &fn)
+{
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    size_t chunks = (count + grain - 1) / grain;
+    if (chunks == 1 || t_inside_job) {
+        fn(0, count);
+        return;
+    }
+
+    Pool &pool = get_pool();
+    if (pool.workers.empty()) {
+        fn(0, count);
+        return;
+    }
+
+    std::unique_lock<std::mutex> dispatch(pool.dispatch, std::try_to_lock);
+    if (!dispatch.owns_lock()) {
+        fn(0, count);
+        return;
+    }
+
+    Job job;
+    job.fn = &fn;
+    job.count = count;
+    job.grain = grain;
+    job.chunks = chunks;
+    {
+        std::lock_guard<std::mutex> lk(pool.mutex);
+        pool.job = &job;
+        ++pool.generation;
+    }
+    pool.wake.notify_all();
+
+    run_chunks(job);
+
+    std::unique_lock<std::mutex> lk(pool.mutex);
+    pool.job = nullptr;
+    pool.idle.wait(lk, [&] { return pool.active == 0; });
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// Number of threads parallel_for spreads work across (including the caller).
+unsigned parallel_thread_count();
+
+// Split [0, count) into chunks of at most `grain` items and run fn(begin, end)
+// for each chunk on a persistent worker pool. The calling thread takes part
+// and the call returns once every chunk has finished. Calls made from inside
+// a chunk, or while another thread's call holds the pool (e.g. a background
+// LOD build), run serially on the current thread instead of waiting.
+void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &fn);
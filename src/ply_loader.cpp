@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ply_loader.h"
+#include "parallel.h"
+
+// Scalar types as they appear in "property <type> <name>" lines.
+enum PlyType { PLY_NONE = 0, PLY_I8, PLY_U8, PLY_I16, PLY_U16, PLY_I32, PLY_U32, PLY_F32, PLY_F64 };
+
+static PlyType parse_type(const std::string &t, size_t *size)
+{
+    struct Entry { const char *name; PlyType type; size_t size; };
+    static const Entry table[] = {
+        {"char", PLY_I8, 1},   {"int8", PLY_I8, 1},     {"uchar", PLY_U8, 1},   {"uint8", PLY_U8, 1},
+        {"short", PLY_I16, 2}, {"int16", PLY_I16, 2},   {"ushort", PLY_U16, 2}, {"uint16", PLY_U16, 2},
+        {"int", PLY_I32, 4},   {"int32", PLY_I32, 4},   {"uint", PLY_U32, 4},   {"uint32", PLY_U32, 4},
+        {"float", PLY_F32, 4}, {"float32", PLY_F32, 4}, {"double", PLY_F64, 8}, {"float64", PLY_F64, 8},
+    };
+    for (const Entry &e : table) {
+        if (t == e.name) {
+            *size = e.size;
+            return e.type;
+        }
+    }
+    return PLY_NONE;
+}
+
+static inline float read_scalar(const uint8_t *p, int type)
+{
+    switch (type) {
+    case PLY_F32: { float v; memcpy(&v, p, 4); return v; }
+    case PLY_F64: { double v; memcpy(&v, p, 8); return (float)v; }
+    case PLY_U8:  return (float)p[0];
+    case PLY_I8:  return (float)(int8_t)p[0];
+    case PLY_I16: { int16_t v; memcpy(&v, p, 2); return (float)v; }
+    case PLY_U16: { uint16_t v; memcpy(&v, p, 2); return (float)v; }
+    case PLY_I32: { int32_t v; memcpy(&v, p, 4); return (float)v; }
+    case PLY_U32: { uint32_t v; memcpy(&v, p, 4); return (float)v; }
+    default:      return 0.0f;
+    }
+}
+
+static inline float read_prop(const uint8_t *rec, const PlyFile::Prop &prop, float fallback)
+{
+    return prop.offset >= 0 ? read_scalar(rec + prop.offset, prop.type) : fallback;
+}
+
+static std::vector<std::string> split_words(const std::string &line)
+{
+    std::vector<std::string> words;
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) ++i;
+        size_t start = i;
+        while (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r') ++i;
+        if (i > start) words.push_back(line.substr(start, i - start));
+    }
+    return words;
+}
+
+static bool match_indexed(const std::string &name, const char *prefix, int *index)
+{
+    size_t n = strlen(prefix);
+    if (name.compare(0, n, prefix) != 0 || name.size() == n) return false;
+    int v = 0;
+    for (size_t i = n; i < name.size(); ++i) {
+        if (name[i] < '0' || name[i] > '9') return false;
+        v = v * 10 + (name[i] - '0');
+    }
+    *index = v;
+    return true;
+}
+
+bool ply_open(const char *path, PlyFile *out)
+{
+    if (!path || !out) return false;
+    *out = PlyFile();
+
+    if (!mapped_file_open(path, &out->file)) return false;
+    const char *text = (const char *)out->file.data;
+    size_t size = out->file.size;
+
+    if (size < 4 || memcmp(text, "ply", 3) != 0) {
+        fprintf(stderr, "ply_loader: %s is not a PLY file\n", path);
+        ply_close(out);
+        return false;
+    }
+
+    // walk the ASCII header line by line
+    size_t pos = 0;
+    bool inVertex = false, seenVertex = false, binaryLE = false;
+    size_t skipBytes = 0;     // fixed-size elements preceding "vertex"
+    size_t elementStride = 0; // stride of the element currently being declared
+    size_t elementCount = 0;
+    bool elementHasList = false;
+    int restIndexMax = -1;
+
+    for (;;) {
+        const char *nl = (const char *)memchr(text + pos, '\n', size - pos);
+        if (!nl) {
+            fprintf(stderr, "ply_loader: %s has no end_header\n", path);
+            ply_close(out);
+            return false;
+        }
+        std::string line(text + pos, nl - (text + pos));
+        pos = (size_t)(nl - text) + 1;
+
+        std::vector<std::string> w = split_words(line);
+        if (w.empty()) continue;
+
+        if (w[0] == "format") {
+            binaryLE = w.size() >= 2 && w[1] == "binary_little_endian";
+        } else if (w[0] == "element" && w.size() >= 3) {
+            if (!seenVertex && !inVertex && elementCount > 0) {
+                if (elementHasList) {
+                    fprintf(stderr, "ply_loader: list element before vertex data is unsupported\n");
+                    ply_close(out);
+                    return false;
+                }
+                skipBytes += elementStride * elementCount;
+            }
+            if (inVertex) {
+                seenVertex = true;
+                inVertex = false;
+            }
+            elementStride = 0;
+            elementHasList = false;
+            elementCount = (size_t)strtoull(w[2].c_str(), nullptr, 10);
+            if (w[1] == "vertex" && !seenVertex) {
+                inVertex = true;
+                out->vertexCount = elementCount;
+            }
+        } else if (w[0] == "property" && w.size() >= 3) {
+            if (w[1] == "list") {
+                elementHasList = true;
+                if (inVertex) {
+                    fprintf(stderr, "ply_loader: list properties on vertices are unsupported\n");
+                    ply_close(out);
+                    return false;
+                }
+                continue;
+            }
+            size_t typeSize = 0;
+            PlyType type = parse_type(w[1], &typeSize);
+            if (type == PLY_NONE) {
+                fprintf(stderr, "ply_loader: unknown property type '%s'\n", w[1].c_str());
+                ply_close(out);
+                return false;
+            }
+            if (inVertex) {
+                PlyFile::Prop prop;
+                prop.offset = (int)elementStride;
+                prop.type = type;
+                const std::string &name = w[2];
+                int idx = 0;
+                if (name == "x") out->pos[0] = prop;
+                else if (name == "y") out->pos[1] = prop;
+                else if (name == "z") out->pos[2] = prop;
+                else if (name == "opacity") out->opacity = prop;
+                else if (name == "red") out->rgb[0] = prop;
+                else if (name == "green") out->rgb[1] = prop;
+                else if (name == "blue") out->rgb[2] = prop;
+                else if (match_indexed(name, "scale_", &idx) && idx < 3) out->scale[idx] = prop;
+                else if (match_indexed(name, "rot_", &idx) && idx < 4) out->rot[idx] = prop;
+                else if (match_indexed(name, "f_dc_", &idx) && idx < 3) out->dc[idx] = prop;
+                else if (match_indexed(name, "f_rest_", &idx) && idx < 3 * SPLAT_SH_REST_COEFFS) {
+                    out->rest[idx] = prop;
+                    if (idx > restIndexMax) restIndexMax = idx;
+                }
+            }
+            elementStride += typeSize;
+            if (inVertex) out->stride = elementStride;
+        } else if (w[0] == "end_header") {
+            break;
+        }
+    }
+
+    if (!binaryLE) {
+        fprintf(stderr, "ply_loader: %s is not binary_little_endian\n", path);
+        ply_close(out);
+        return false;
+    }
+    if (out->vertexCount == 0 || out->stride == 0) {
+        fprintf(stderr, "ply_loader: %s has no vertex data\n", path);
+        ply_close(out);
+        return false;
+    }
+    if (out->pos[0].offset < 0 || out->pos[1].offset < 0 || out->pos[2].offset < 0) {
+        fprintf(stderr, "ply_loader: %s lacks x/y/z\n", path);
+        ply_close(out);
+        return false;
+    }
+
+    size_t payloadBytes = out->vertexCount * out->stride;
+    if (pos + skipBytes + payloadBytes > size || payloadBytes / out->stride != out->vertexCount) {
+        fprintf(stderr, "ply_loader: %s is truncated (%zu vertices declared)\n", path, out->vertexCount);
+        ply_close(out);
+        return false;
+    }
+    out->payload = out->file.data + pos + skipBytes;
+
+    // f_rest_* is channel-major: all of R's coefficients, then G's, then B's
+    int restTotal = restIndexMax + 1;
+    out->restPerChannel = restTotal / 3;
+    out->shDegree = 0;
+    if (out->restPerChannel >= 15) out->shDegree = 3;
+    else if (out->restPerChannel >= 8) out->shDegree = 2;
+    else if (out->restPerChannel >= 3) out->shDegree = 1;
+
+    return true;
+}
+
+static inline float sigmoid(float x)
+{
+    return 1.0f / (1.0f + expf(-x));
+}
+
+void ply_decode(const PlyFile &ply, size_t first, size_t count, const SplatSink &out,
+                float boundsMin[3], float boundsMax[3])
+{
+    const bool hasDc = ply.dc[0].offset >= 0;
+    const bool hasRgb = ply.rgb[0].offset >= 0;
+    const int rpc = ply.restPerChannel;
+
+    for (size_t i = first; i < first + count; ++i) {
+        const uint8_t *rec = ply.payload + i * ply.stride;
+        GpuSplat s;
+
+        for (int k = 0; k < 3; ++k) s.position[k] = read_prop(rec, ply.pos[k], 0.0f);
+
+        // splats without opacity/scale attributes render as small opaque blobs
+        s.opacity = ply.opacity.offset >= 0 ? sigmoid(read_prop(rec, ply.opacity, 0.0f)) : 1.0f;
+        for (int k = 0; k < 3; ++k) s.scale[k] = expf(read_prop(rec, ply.scale[k], -4.6f));
+        s._pad0 = 0.0f;
+
+        float q[4];
+        q[0] = read_prop(rec, ply.rot[0], 1.0f);
+        for (int k = 1; k < 4; ++k) q[k] = read_prop(rec, ply.rot[k], 0.0f);
+        float len = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        if (len > 0.0f) {
+            for (int k = 0; k < 4; ++k) s.rotation[k] = q[k] / len;
+        } else {
+            s.rotation[0] = 1.0f;
+            s.rotation[1] = s.rotation[2] = s.rotation[3] = 0.0f;
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            if (hasDc) s.color[k] = 0.5f + SPLAT_SH_C0 * read_prop(rec, ply.dc[k], 0.0f);
+            else if (hasRgb) s.color[k] = read_prop(rec, ply.rgb[k], 255.0f) / 255.0f;
+            else s.color[k] = 1.0f;
+        }
+        s.color[3] = s.opacity;
+
+        // splats may be write-combined GPU memory: store whole records, never read back
+        size_t o = i - out.first;
+        if (out.splats) out.splats[o] = s;
+        if (out.centers[0]) {
+            for (int k = 0; k < 3; ++k) out.centers[k][o] = s.position[k];
+        }
+
+        if (boundsMin && boundsMax) {
+            for (int k = 0; k < 3; ++k) {
+                if (s.position[k] < boundsMin[k]) boundsMin[k] = s.position[k];
+                if (s.position[k] > boundsMax[k]) boundsMax[k] = s.position[k];
+            }
+        }
+
+        if (out.shRest) {
+            float *sh = out.shRest + o * SPLAT_SH_REST_FLOATS;
+            for (int k = 0; k < SPLAT_SH_REST_COEFFS; ++k) {
+                for (int c = 0; c < 3; ++c)
+                    sh[k * 3 + c] = k < rpc ? read_prop(rec, ply.rest[c * rpc + k], 0.0f) : 0.0f;
+            }
+        }
+    }
+}
+
+void ply_load(const PlyFile &ply, const SplatSink &out, float boundsMin[3], float boundsMax[3])
+{
+    if (!ply.payload) return;
+
+    float mn[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float mx[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    std::mutex boundsMutex;
+
+    const size_t grain = 1 << 16;
+    parallel_for(ply.vertexCount, grain, [&](size_t begin, size_t end) {
+        float cmn[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+        float cmx[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        ply_decode(ply, begin, end - begin, out, cmn, cmx);
+
+        std::lock_guard<std::mutex> lk(boundsMutex);
+        for (int k = 0; k < 3; ++k) {
+            if (cmn[k] < mn[k]) mn[k] = cmn[k];
+            if (cmx[k] > mx[k]) mx[k] = cmx[k];
+        }
+    });
+
+    for (int k = 0; k < 3; ++k) {
+        if (boundsMin) boundsMin[k] = mn[k];
+        if (boundsMax) boundsMax[k] = mx[k];
+    }
+}
+
+void ply_close(PlyFile *ply)
+{
+    if (!ply) return;
+    mapped_file_close(&ply->file);
+    *ply = PlyFile();
+}
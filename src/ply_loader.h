@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "mapped_file.h"
+#include "splat.h"
+
+// A memory-mapped 3D Gaussian Splatting .ply file with its parsed header.
+// Only binary_little_endian vertex data is supported.
+struct PlyFile {
+    MappedFile file;
+    const uint8_t *payload = nullptr; // first vertex record
+    size_t vertexCount = 0;
+    size_t stride = 0;                // bytes per vertex record
+    int shDegree = 0;                 // highest complete SH band found (0..3)
+
+    // Byte offset and scalar type of each property used, -1 when absent.
+    struct Prop { int offset = -1; int type = 0; };
+    Prop pos[3], scale[3], rot[4], dc[3], opacity;
+    Prop rgb[3];                      // plain point-cloud colors (uchar), fallback for f_dc
+    Prop rest[3 * SPLAT_SH_REST_COEFFS];
+    int restPerChannel = 0;
+};
+
+// Map `path` and parse its header. Returns false (and logs) on malformed files.
+bool ply_open(const char *path, PlyFile *out);
+
+// Convert vertices [first, first + count) into the sink's arrays (at the same
+// indices, less SplatSink::first). SH bands missing from the file are zero-filled. When
+// boundsMin/boundsMax are non-null they are grown to include the centers.
+void ply_decode(const PlyFile &ply, size_t first, size_t count, const SplatSink &out,
+                float boundsMin[3], float boundsMax[3]);
+
+// Decode the whole file into the sink across all cores. Bounds of the splat
+// centers are written to boundsMin/boundsMax when those are non-null.
+void ply_load(const PlyFile &ply, const SplatSink &out, float boundsMin[3], float boundsMax[3]);
+
+// Unmap the file.
+void ply_close(PlyFile *ply);
@@ -0,0 +1,414 @@
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include "profiler.h"
+
+struct CpuEvent {
+    const char *name;
+    uint64_t startNs, endNs;
+    uint32_t depth, frame;
+};
+
+// One per recording thread; only that thread writes it. `written` counts
+// every event ever recorded, the ring keeps the last k_ringSize.
+static const size_t k_ringSize = 1 << 15;
+struct ThreadRing {
+    CpuEvent events[k_ringSize];
+    std::atomic<uint64_t> written{0};
+    uint32_t index = 0;
+};
+
+static const int k_gpuSets = 2;
+static const int k_maxGpuZones = 64;
+static const size_t k_gpuRingSize = 1 << 14;
+static const size_t k_maxZones = 64;
+
+// Timestamp pairs of one frame's GPU zones.
+struct GpuSet {
+    GLuint queries[k_maxGpuZones * 2];
+    const char *names[k_maxGpuZones];
+    int depth[k_maxGpuZones];
+    int count = 0;
+    bool pending = false;   // recorded, not yet read back
+    int64_t gpuToCpuNs = 0; // add to a GPU timestamp for the CPU clock
+};
+
+struct GpuEvent {
+    const char *name;
+    uint64_t startNs, endNs; // CPU clock
+    uint32_t depth;
+};
+
+static std::atomic<bool> g_enabled{false};
+static std::atomic<uint32_t> g_frame{0};
+
+static std::mutex g_ringsMutex;
+static std::vector<ThreadRing *> g_rings; // never freed: threads may outlive shutdown
+static ThreadRing *g_mainRing = nullptr;
+static thread_local ThreadRing *t_ring = nullptr;
+static thread_local uint32_t t_depth = 0;
+
+static bool g_inFrame = false;
+static uint64_t g_frameStartNs = 0;
+static uint64_t g_frameFirstEvent = 0;
+
+static bool g_gpuReady = false;
+static GpuSet g_gpuSets[k_gpuSets];
+static int g_gpuSet = -1; // set recording this frame
+static int g_gpuDepth = 0;
+static int g_gpuFrameZone = -1;
+static std::vector<GpuEvent> g_gpuEvents; // ring of k_gpuRingSize
+static uint64_t g_gpuWritten = 0;
+
+static std::vector<ProfilerZoneStats> g_zones;
+static float g_accum[k_maxZones];
+static ProfilerStats g_stats;
+
+static uint64_t now_ns()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static ThreadRing *thread_ring()
+{
+    if (!t_ring) {
+        ThreadRing *ring = new ThreadRing();
+        std::lock_guard<std::mutex> lk(g_ringsMutex);
+        ring->index = (uint32_t)g_rings.size();
+        g_rings.push_back(ring);
+        t_ring = ring;
+    }
+    return t_ring;
+}
+
+static void record(const char *name, uint64_t startNs, uint64_t endNs, uint32_t depth)
+{
+    ThreadRing *ring = thread_ring();
+    uint64_t w = ring->written.load(std::memory_order_relaxed);
+    CpuEvent &e = ring->events[w % k_ringSize];
+    e.name = name;
+    e.startNs = startNs;
+    e.endNs = endNs;
+    e.depth = depth;
+    e.frame = g_frame.load(std::memory_order_relaxed);
+    ring->written.store(w + 1, std::memory_order_release);
+}
+
+void profiler_set_enabled(bool enabled)
+{
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool profiler_enabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+ProfileScope::ProfileScope(const char *zoneName)
+{
+    if (!g_enabled.load(std::memory_order_relaxed)) {
+        name = nullptr;
+        return;
+    }
+    name = zoneName;
+    ++t_depth;
+    startNs = now_ns();
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (!name) return;
+    uint64_t endNs = now_ns();
+    --t_depth;
+    record(name, startNs, endNs, t_depth);
+}
+
+static int gpu_begin(const char *name)
+{
+    if (g_gpuSet < 0) return -1;
+    GpuSet &set = g_gpuSets[g_gpuSet];
+    if (set.count == k_maxGpuZones) return -1;
+    int zone = set.count++;
+    set.names[zone] = name;
+    set.depth[zone] = g_gpuDepth++;
+    glQueryCounter(set.queries[zone * 2], GL_TIMESTAMP);
+    return zone;
+}
+
+static void gpu_end(int zone)
+{
+    if (zone < 0 || g_gpuSet < 0) return;
+    --g_gpuDepth;
+    glQueryCounter(g_gpuSets[g_gpuSet].queries[zone * 2 + 1], GL_TIMESTAMP);
+}
+
+GpuProfileScope::GpuProfileScope(const char *name)
+{
+    zone = gpu_begin(name);
+}
+
+GpuProfileScope::~GpuProfileScope()
+{
+    gpu_end(zone);
+}
+
+static int find_zone(const char *name, bool gpu, int depth)
+{
+    for (size_t i = 0; i < g_zones.size(); ++i)
+        if (g_zones[i].gpu == gpu && strncmp(g_zones[i].name, name, sizeof(g_zones[i].name) - 1) == 0) return (int)i;
+    if (g_zones.size() == k_maxZones) return -1;
+    ProfilerZoneStats z;
+    memset(&z, 0, sizeof(z));
+    snprintf(z.name, sizeof(z.name), "%s", name);
+    z.gpu = gpu;
+    z.depth = depth;
+    g_zones.push_back(z);
+    return (int)g_zones.size() - 1;
+}
+
+static void push_history(ProfilerZoneStats &z, float ms)
+{
+    z.history[z.head] = ms;
+    z.head = (z.head + 1) % PROFILER_HISTORY;
+    z.lastMs = ms;
+    float sum = 0.0f, mx = 0.0f;
+    for (float v : z.history) {
+        sum += v;
+        if (v > mx) mx = v;
+    }
+    z.avgMs = sum / PROFILER_HISTORY;
+    z.maxMs = mx;
+}
+
+// Sum this frame's main-thread zones per name into the history.
+static void collect_cpu()
+{
+    for (size_t i = 0; i < g_zones.size(); ++i) g_accum[i] = 0.0f;
+    uint64_t w = g_mainRing->written.load(std::memory_order_relaxed);
+    uint64_t first = g_frameFirstEvent;
+    if (w - first > k_ringSize) first = w - k_ringSize;
+    for (uint64_t i = first; i < w; ++i) {
+        const CpuEvent &e = g_mainRing->events[i % k_ringSize];
+        int zone = find_zone(e.name, false, (int)e.depth);
+        if (zone >= 0) g_accum[zone] += (float)((e.endNs - e.startNs) * 1e-6);
+    }
+    for (size_t i = 0; i < g_zones.size(); ++i)
+        if (!g_zones[i].gpu) push_history(g_zones[i], g_accum[i]);
+}
+
+// Read back a set if the driver has every result; never waits.
+static bool collect_gpu(GpuSet &set)
+{
+    if (!set.pending) return false;
+    if (set.count > 0) {
+        GLint available = 0;
+        glGetQueryObjectiv(set.queries[set.count * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+    }
+    set.pending = false;
+
+    for (size_t i = 0; i < g_zones.size(); ++i) g_accum[i] = 0.0f;
+    for (int z = 0; z < set.count; ++z) {
+        GLuint64 t0 = 0, t1 = 0;
+        glGetQueryObjectui64v(set.queries[z * 2], GL_QUERY_RESULT, &t0);
+        glGetQueryObjectui64v(set.queries[z * 2 + 1], GL_QUERY_RESULT, &t1);
+        if (t1 < t0) t1 = t0;
+        int zone = find_zone(set.names[z], true, set.depth[z]);
+        if (zone >= 0) g_accum[zone] += (float)((t1 - t0) * 1e-6);
+
+        GpuEvent &e = g_gpuEvents[g_gpuWritten++ % k_gpuRingSize];
+        e.name = set.names[z];
+        e.startNs = (uint64_t)((int64_t)t0 + set.gpuToCpuNs);
+        e.endNs = (uint64_t)((int64_t)t1 + set.gpuToCpuNs);
+        e.depth = (uint32_t)set.depth[z];
+    }
+    for (size_t i = 0; i < g_zones.size(); ++i)
+        if (g_zones[i].gpu) push_history(g_zones[i], g_accum[i]);
+    ++g_stats.gpuFramesRead;
+    return true;
+}
+
+void profiler_begin_frame()
+{
+    g_inFrame = g_enabled.load(std::memory_order_relaxed);
+    if (!g_inFrame) return;
+
+    ThreadRing *ring = thread_ring();
+    g_mainRing = ring;
+    g_frameFirstEvent = ring->written.load(std::memory_order_relaxed);
+    ++t_depth;
+    g_frameStartNs = now_ns();
+
+    if (!g_gpuReady) {
+        for (GpuSet &set : g_gpuSets) {
+            glGenQueries(k_maxGpuZones * 2, set.queries);
+            set.count = 0;
+            set.pending = false;
+        }
+        g_gpuEvents.resize(k_gpuRingSize);
+        g_gpuReady = true;
+    }
+    g_gpuSet = (int)(g_frame.load(std::memory_order_relaxed) % k_gpuSets);
+    GpuSet &set = g_gpuSets[g_gpuSet];
+    if (set.pending) {
+        // still not available a whole frame later; reusing the queries drops it
+        set.pending = false;
+        ++g_stats.gpuDropped;
+    }
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    set.gpuToCpuNs = (int64_t)now_ns() - (int64_t)gpuNow;
+    set.count = 0;
+    g_gpuDepth = 0;
+    g_gpuFrameZone = gpu_begin("frame");
+}
+
+void profiler_end_frame()
+{
+    if (!g_inFrame) return;
+    g_inFrame = false;
+
+    gpu_end(g_gpuFrameZone);
+    g_gpuSets[g_gpuSet].pending = true;
+    g_gpuSet = -1;
+
+    uint64_t endNs = now_ns();
+    --t_depth;
+    record("frame", g_frameStartNs, endNs, t_depth);
+    g_stats.cpuFrameMs = (float)((endNs - g_frameStartNs) * 1e-6);
+    collect_cpu();
+
+    uint32_t frame = g_frame.fetch_add(1, std::memory_order_relaxed);
+    collect_gpu(g_gpuSets[(frame + k_gpuSets - 1) % k_gpuSets]);
+    ++g_stats.frames;
+}
+
+size_t profiler_zone_count()
+{
+    return g_zones.size();
+}
+
+const ProfilerZoneStats &profiler_zone(size_t i)
+{
+    return g_zones[i];
+}
+
+const ProfilerStats &profiler_stats()
+{
+    return g_stats;
+}
+
+static void write_event(FILE *f, bool *first, const char *name, const char *cat, uint64_t startNs, uint64_t endNs,
+                        uint64_t baseNs, unsigned tid)
+{
+    fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+            *first ? "" : ",", name, cat, (double)(startNs - baseNs) * 1e-3, (double)(endNs - startNs) * 1e-3, tid);
+    *first = false;
+}
+
+// Copy the events a ring still holds. Its thread may be recording while
+// this runs, so the copy is taken between two reads of `written`, like a
+// seqlock: any slot the writer could have reached since the first read
+// (one past the second read, for the event it may be writing) is dropped
+// rather than exported torn. Returns the number of events lost.
+static uint64_t snapshot_ring(const ThreadRing &ring, std::vector<CpuEvent> *out)
+{
+    uint64_t w = ring.written.load(std::memory_order_acquire);
+    uint64_t first = w > k_ringSize ? w - k_ringSize : 0;
+    out->clear();
+    for (uint64_t i = first; i < w; ++i) out->push_back(ring.events[i % k_ringSize]);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = ring.written.load(std::memory_order_relaxed);
+    uint64_t safeFirst = after + 1 > k_ringSize ? after + 1 - k_ringSize : 0;
+    if (safeFirst > first) {
+        size_t torn = (size_t)std::min<uint64_t>(safeFirst - first, out->size());
+        out->erase(out->begin(), out->begin() + torn);
+        first += torn;
+    }
+    return first;
+}
+
+bool profiler_export_chrome_trace(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "profiler: cannot write %s\n", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lk(g_ringsMutex);
+    std::vector<std::vector<CpuEvent>> snapshots(g_rings.size());
+    size_t events = 0, lost = 0;
+    for (size_t r = 0; r < g_rings.size(); ++r) lost += (size_t)snapshot_ring(*g_rings[r], &snapshots[r]);
+
+    // timestamps relative to the oldest buffered event
+    uint64_t baseNs = UINT64_MAX;
+    for (const std::vector<CpuEvent> &snapshot : snapshots)
+        for (const CpuEvent &e : snapshot)
+            if (e.startNs < baseNs) baseNs = e.startNs;
+    uint64_t gpuFirst = g_gpuWritten > k_gpuRingSize ? g_gpuWritten - k_gpuRingSize : 0;
+    for (uint64_t i = gpuFirst; i < g_gpuWritten; ++i)
+        if (g_gpuEvents[i % k_gpuRingSize].startNs < baseNs) baseNs = g_gpuEvents[i % k_gpuRingSize].startNs;
+    if (baseNs == UINT64_MAX) baseNs = 0;
+
+    const unsigned k_gpuTid = 1000;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool firstEvent = true;
+    for (size_t r = 0; r < g_rings.size(); ++r) {
+        const ThreadRing *ring = g_rings[r];
+        char threadName[32];
+        if (ring == g_mainRing) snprintf(threadName, sizeof(threadName), "main");
+        else snprintf(threadName, sizeof(threadName), "worker %u", ring->index);
+        fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                firstEvent ? "" : ",", ring->index, threadName);
+        firstEvent = false;
+
+        for (const CpuEvent &e : snapshots[r]) {
+            write_event(f, &firstEvent, e.name, "cpu", e.startNs, e.endNs, baseNs, ring->index);
+            ++events;
+        }
+    }
+    fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}",
+            firstEvent ? "" : ",", k_gpuTid);
+    firstEvent = false;
+    for (uint64_t i = gpuFirst; i < g_gpuWritten; ++i) {
+        const GpuEvent &e = g_gpuEvents[i % k_gpuRingSize];
+        write_event(f, &firstEvent, e.name, "gpu", e.startNs, e.endNs, baseNs, k_gpuTid);
+        ++events;
+    }
+    fprintf(f, "\n]}\n");
+    bool ok = ferror(f) == 0;
+    fclose(f);
+    g_stats.cpuEventsLost = lost;
+    if (ok) printf("profiler: wrote %zu zones to %s\n", events, path);
+    else fprintf(stderr, "profiler: failed writing %s\n", path);
+    return ok;
+}
+
+void profiler_shutdown()
+{
+    if (g_gpuReady) {
+        for (GpuSet &set : g_gpuSets) {
+            glDeleteQueries(k_maxGpuZones * 2, set.queries);
+            set.count = 0;
+            set.pending = false;
+        }
+        g_gpuReady = false;
+    }
+    g_gpuSet = -1;
+    g_gpuEvents.clear();
+    g_gpuWritten = 0;
+    g_zones.clear();
+    g_inFrame = false;
+    g_stats = ProfilerStats();
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Frame profiler.
+//
+// CPU zones are timed with a steady nanosecond clock and appended to a
+// ring buffer owned by the recording thread, so recording takes no lock.
+// GPU zones put a timestamp query (glQueryCounter) on each side of the
+// commands issued inside them; unlike GL_TIME_ELAPSED queries these can
+// nest. Query sets are double-buffered per frame and read back one frame
+// later only once the driver reports them available, so the profiler
+// never stalls the pipeline; results that are still pending when their
+// set comes round again are dropped and counted.
+//
+// Main-thread CPU zones and all GPU zones feed a rolling per-zone history
+// for the UI; every recorded zone, on every thread, can be exported as a
+// Chrome trace (chrome://tracing, Perfetto). While disabled, zones cost a
+// flag check and issue no queries.
+
+enum { PROFILER_HISTORY = 240 }; // frames kept per zone
+
+struct ProfilerZoneStats {
+    char name[32];
+    bool gpu;
+    int depth;                       // nesting level when first seen
+    float lastMs;                    // most recent frame that has a result
+    float avgMs;                     // over the history
+    float maxMs;
+    float history[PROFILER_HISTORY]; // ring; the oldest entry is at `head`
+    int head;
+};
+
+struct ProfilerStats {
+    uint64_t frames = 0;
+    float cpuFrameMs = 0.0f;      // begin_frame to end_frame
+    uint64_t gpuDropped = 0;      // GPU query sets never read back
+    uint64_t gpuFramesRead = 0;   // GPU query sets read back (zone lastMs updated)
+    size_t cpuEventsLost = 0;     // zones overwritten before an export
+};
+
+void profiler_set_enabled(bool enabled);
+bool profiler_enabled();
+
+// Frame boundaries, on the thread that owns the GL context. GPU results of
+// the previous frame are collected in profiler_end_frame.
+void profiler_begin_frame();
+void profiler_end_frame();
+
+// Zone that times its own scope. `name` must outlive the profiler (a
+// string literal); zones with the same name are summed per frame.
+struct ProfileScope {
+    explicit ProfileScope(const char *name);
+    ~ProfileScope();
+    const char *name;
+    uint64_t startNs;
+};
+
+// GPU zone around the GL commands issued in its scope. GL thread only,
+// inside a begin_frame / end_frame pair.
+struct GpuProfileScope {
+    explicit GpuProfileScope(const char *name);
+    ~GpuProfileScope();
+    int zone; // -1 when not recording
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_GPU(name) GpuProfileScope PROFILE_CONCAT(profileGpu_, __LINE__)(name)
+
+// Zones seen so far, in order of first appearance.
+size_t profiler_zone_count();
+const ProfilerZoneStats &profiler_zone(size_t i);
+const ProfilerStats &profiler_stats();
+
+// Write every buffered zone as Chrome trace JSON. Call between frames, on
+// the GL thread, ideally while worker threads are idle: zones they record
+// during the export may be left out (those slots are dropped, never
+// written half-updated) and count as lost.
+bool profiler_export_chrome_trace(const char *path);
+
+// Delete the query objects and forget the history (needs the GL context).
+void profiler_shutdown();
@@ -4,17 +4,35 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <iterator>
 #include <fstream>
 #include <sstream>
 #include "renderer.h"
 #include "graphics.h"
+#include "profiler.h"
+#include "parallel.h"
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
 static GLFWwindow *g_window = nullptr;
+static bool g_showProfiler = false;
+static char g_traceStatus[128] = "";
+static char g_openPath[512] = "";
+// splat editing: the selection and the values the edit buttons apply
+static bool g_selectMode = false;
+static std::vector<uint32_t> g_selection;
+static bool g_dragging = false;
+static ImVec2 g_dragStart;
+static float g_editColor[3] = {1.0f, 1.0f, 1.0f};
+static float g_editOpacity = 0.5f;
+static float g_editMove[3] = {0.0f, 0.0f, 0.0f};
 static float g_colors[3 * 4] = {
     1.0f, 0.0f, 0.0f, 1.0f, // vertex 0
     0.0f, 1.0f, 0.0f, 1.0f, // vertex 1
@@ -37,7 +55,7 @@ bool renderer_init(GLFWwindow *window, const float* initial_colors, size_t byteS
     ImGui::StyleColorsDark();
 
     ImGui_ImplGlfw_InitForOpenGL(g_window, true);
-    ImGui_ImplOpenGL3_Init("#version 460 core");
+    ImGui_ImplOpenGL3_Init("#version 450 core");
 
     // copy initial colors into UI state if provided
     if (initial_colors && byteSize >= sizeof(g_colors)) {
@@ -54,12 +72,139 @@ void renderer_new_frame()
     ImGui::NewFrame();
 }
 
+// Rolling per-zone timings and trace export (profiler.h).
+static void profiler_window()
+{
+    ImGui::SetNextWindowPos(ImVec2(10, 420), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(460, 380), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", &g_showProfiler, ImGuiWindowFlags_NoSavedSettings)) {
+        ImGui::End();
+        return;
+    }
+    const ProfilerStats &ps = profiler_stats();
+    ImGui::Text("CPU frame %.2f ms, %llu frames, %llu GPU sets dropped", ps.cpuFrameMs,
+                (unsigned long long)ps.frames, (unsigned long long)ps.gpuDropped);
+    if (ImGui::Button("Export Chrome trace")) {
+        const char *path = "gsgl_trace.json";
+        if (profiler_export_chrome_trace(path)) snprintf(g_traceStatus, sizeof(g_traceStatus), "wrote %s", path);
+        else snprintf(g_traceStatus, sizeof(g_traceStatus), "failed to write %s", path);
+    }
+    ImGui::SameLine();
+    ImGui::TextUnformatted(g_traceStatus);
+
+    // CPU zones first, then GPU; name indented by nesting, then last/avg/max
+    for (int gpu = 0; gpu < 2; ++gpu) {
+        ImGui::Separator();
+        ImGui::TextUnformatted(gpu ? "GPU (one frame behind)" : "CPU (main thread)");
+        for (size_t i = 0; i < profiler_zone_count(); ++i) {
+            const ProfilerZoneStats &z = profiler_zone(i);
+            if (z.gpu != (gpu == 1)) continue;
+            ImGui::PushID((int)i);
+            ImGui::Text("%*s%-16s %6.2f %6.2f %6.2f", z.depth * 2, "", z.name, z.lastMs, z.avgMs, z.maxMs);
+            ImGui::SameLine(300);
+            ImGui::PlotLines("##history", z.history, PROFILER_HISTORY, z.head, nullptr, 0.0f, FLT_MAX,
+                             ImVec2(140, 16));
+            ImGui::PopID();
+        }
+    }
+    ImGui::End();
+}
+
+// Apply one edit to the selection.
+static void edit_selection(SplatEdit edit)
+{
+    if (g_selection.empty()) return;
+    edit.indices = g_selection.data();
+    edit.count = g_selection.size();
+    graphics_edit(&edit, 1);
+}
+
+static void edit_panel(const GraphicsStats &stats)
+{
+    ImGui::Checkbox("Select (LMB click or drag, Shift adds)", &g_selectMode);
+    ImGui::Text("Selected %zu splats", g_selection.size());
+    if (!g_selection.empty()) {
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) g_selection.clear();
+        if (ImGui::Button("Delete")) {
+            SplatEdit e;
+            e.op = SPLAT_EDIT_DELETE;
+            edit_selection(e);
+            g_selection.clear(); // deleted splats can't be selected
+        }
+        ImGui::ColorEdit3("##editColor", g_editColor);
+        ImGui::SameLine();
+        if (ImGui::Button("Recolor")) {
+            SplatEdit e;
+            e.op = SPLAT_EDIT_COLOR;
+            memcpy(e.color, g_editColor, sizeof(e.color));
+            edit_selection(e);
+        }
+        ImGui::SliderFloat("##editOpacity", &g_editOpacity, 0.0f, 1.0f, "%.2f");
+        ImGui::SameLine();
+        if (ImGui::Button("Set opacity")) {
+            SplatEdit e;
+            e.op = SPLAT_EDIT_OPACITY;
+            e.opacity = g_editOpacity;
+            edit_selection(e);
+        }
+        ImGui::DragFloat3("##editMove", g_editMove, 0.01f);
+        ImGui::SameLine();
+        if (ImGui::Button("Move")) {
+            SplatEdit e;
+            e.op = SPLAT_EDIT_TRANSFORM;
+            memcpy(e.translate, g_editMove, sizeof(e.translate));
+            edit_selection(e);
+        }
+    }
+    if (ImGui::Button("Undo")) graphics_undo();
+    ImGui::SameLine();
+    if (ImGui::Button("Redo")) graphics_redo();
+    ImGui::SameLine();
+    ImGui::Text("%zu / %zu steps, %.1f KB", stats.undoSteps, stats.redoSteps, stats.undoBytes / 1024.0);
+    ImGui::Text("Last edit %.2f ms, %.1f KB in %zu uploads; select %.2f ms", stats.editMs,
+                stats.editUploadBytes / 1024.0, stats.editUploads, stats.selectMs);
+}
+
+// Select mode: a click picks the splat under the cursor, a drag selects by
+// box; with Shift both add to the selection.
+static void edit_input(ImGuiIO &io)
+{
+    if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+        g_dragging = true;
+        g_dragStart = io.MousePos;
+    }
+    if (!g_dragging) return;
+    ImVec2 a = g_dragStart, b = io.MousePos;
+    if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        ImGui::GetForegroundDrawList()->AddRect(a, b, IM_COL32(255, 200, 0, 255));
+        return;
+    }
+    g_dragging = false;
+    int w = (int)io.DisplaySize.x, h = (int)io.DisplaySize.y;
+    std::vector<uint32_t> hits;
+    if (fabsf(b.x - a.x) < 3.0f && fabsf(b.y - a.y) < 3.0f) {
+        uint32_t index;
+        if (graphics_pick(b.x, b.y, w, h, &index)) hits.push_back(index);
+    } else {
+        graphics_select(a.x, a.y, b.x, b.y, w, h, &hits);
+    }
+    if (!io.KeyShift) {
+        g_selection.swap(hits);
+        return;
+    }
+    std::vector<uint32_t> merged;
+    std::set_union(g_selection.begin(), g_selection.end(), hits.begin(), hits.end(), std::back_inserter(merged));
+    g_selection.swap(merged);
+}
+
 void renderer_render(bool *show_demo)
 {
     (void)show_demo; // demo window disabled; avoid unused-parameter warning
 
     // Build UI (before ImGui::Render)
-    bool updated = false;
+    PROFILE_ZONE("renderer");
+    int updated = -1; // triangle vertex whose color changed
 
     // force window position/size every frame and ignore saved settings so it's always visible
     ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
@@ -68,35 +213,176 @@ void renderer_render(bool *show_demo)
     // prevent ImGui from loading/saving previous window position (imgui.ini)
     ImGuiWindowFlags winFlags = ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings;
 
-    ImGui::Begin("Triangle Colors", nullptr, winFlags);
-    for (int i = 0; i < 3; ++i) {
-        char label[32];
-        snprintf(label, sizeof(label), "Vertex %d Color", i);
-        if (ImGui::ColorEdit4(label, &g_colors[i * 4])) {
-            updated = true;
+    size_t splatCount = graphics_splat_count();
+    if (splatCount > 0) {
+        GraphicsOptions *opt = graphics_options();
+        const GraphicsStats &stats = graphics_stats();
+        ImGui::Begin("Scene", nullptr, winFlags);
+        ImGui::Text("Splats: %zu", splatCount);
+        if (stats.streaming) {
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "%zu / %zu chunks", stats.chunksLoaded, stats.chunkCount);
+            ImGui::ProgressBar(stats.chunkCount ? (float)stats.chunksLoaded / stats.chunkCount : 0.0f,
+                               ImVec2(240.0f, 0.0f), overlay);
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel")) graphics_cancel_load();
+            ImGui::Text("Upload %.2f ms of %.1f ms budget", stats.streamUploadMs, opt->streamBudgetMs);
+        }
+        if (stats.outOfCore) {
+            ImGui::Text("Out of core: %zu of %zu chunks resident, %zu evictions", stats.chunksResident,
+                        stats.chunkCount, stats.evictions);
+        }
+        if (stats.lodBuilding) ImGui::Text("Building LOD...");
+        ImGui::SliderFloat("Splat scale", &opt->splatScale, 0.1f, 2.0f);
+        if (stats.lodAvailable) {
+            ImGui::Checkbox("LOD", &opt->lod);
+            ImGui::SameLine();
+            ImGui::SliderFloat("Node size (px)", &opt->lodPixelSize, 0.5f, 32.0f, "%.1f");
+            if (opt->lod) {
+                ImGui::Text("Drawing %zu of %zu (%zu merged, %zu octree nodes), cut %.2f ms", stats.drawCount,
+                            splatCount, stats.lod.coarse, stats.lodNodes, stats.lod.selectMs);
+            }
+        }
+        // bands above those loaded take effect with the next open
+        ImGui::SliderInt("SH degree", &opt->shDegree, 0, SPLAT_MAX_SH_DEGREE);
+        if (stats.shDegreeLoaded > 0) {
+            ImGui::SameLine();
+            ImGui::SliderFloat("Reuse angle (deg)", &opt->shAngleDeg, 0.0f, 10.0f, "%.2f");
+            ImGui::Text("SH: degree %d of %d loaded (%.1f MB), %zu splats re-evaluated%s", stats.shDegree,
+                        stats.shDegreeLoaded, stats.shBytes / 1048576.0, stats.shEvaluated,
+                        stats.shEvaluating ? "" : " (still)");
+        }
+        ImGui::Text("Depth sort");
+        ImGui::SameLine();
+        ImGui::RadioButton("Off", &opt->sortMode, SORT_NONE);
+        ImGui::SameLine();
+        ImGui::RadioButton("CPU", &opt->sortMode, SORT_CPU);
+        if (stats.gpuSortAvailable) {
+            ImGui::SameLine();
+            ImGui::RadioButton("GPU", &opt->sortMode, SORT_GPU);
+        }
+        ImGui::Text("Engine");
+        ImGui::SameLine();
+        ImGui::RadioButton("Raster", &opt->engine, ENGINE_RASTER);
+        if (stats.tileEngineAvailable) {
+            ImGui::SameLine();
+            ImGui::RadioButton("Tiles (compute)", &opt->engine, ENGINE_TILES);
+            if (opt->engine == ENGINE_TILES)
+                ImGui::Text("Tiles: %ux%u, %zu splat instances", stats.tiles.tilesX, stats.tiles.tilesY,
+                            stats.tiles.instances);
+        }
+        ImGui::SameLine();
+        ImGui::RadioButton("CPU (reference)", &opt->engine, ENGINE_CPU);
+        if (opt->engine == ENGINE_CPU) {
+            ImGui::SliderInt("Threads (0: all)", &opt->cpuThreads, 0, (int)parallel_thread_count());
+            if (stats.cpu.threads > 0) {
+                ImGui::Text("CPU: %.1f ms on %u threads%s (project %.1f, bin %.1f, sort %.1f, blend %.1f)",
+                            stats.cpu.totalMs, stats.cpu.threads, stats.cpu.simd ? ", AVX2" : "",
+                            stats.cpu.projectMs, stats.cpu.binMs, stats.cpu.sortMs, stats.cpu.blendMs);
+            } else if (stats.streaming) {
+                ImGui::Text("CPU: whole scenes only, drawing with the raster engine meanwhile");
+            }
+        }
+        if (opt->sortMode == SORT_CPU) {
+            ImGui::Checkbox("Sort on a worker thread", &opt->pipelineSort);
+            ImGui::Text("Sort: keys %.2f ms, sort %.2f ms%s", stats.sort.keyMs, stats.sort.sortMs,
+                        stats.sort.unchanged ? " (still)" : (stats.sort.reusedOrder ? " (coherent)" : ""));
+            if (stats.pipelined) {
+                ImGui::Text("Worker %.2f ms, %zu culled, latency %.1f ms (%d frames)", stats.pipelineWorkMs,
+                            stats.culled, stats.pipelineLatencyMs, stats.pipelineLagFrames);
+            }
+        }
+        if (opt->sortMode == SORT_GPU && stats.gpuCullAvailable && opt->engine == ENGINE_RASTER) {
+            ImGui::Checkbox("Cull on the GPU", &opt->gpuCull);
+            if (opt->gpuCull) {
+                ImGui::SameLine();
+                ImGui::SliderFloat("Min radius (px)", &opt->cullPixelRadius, 0.0f, 4.0f, "%.2f");
+                ImGui::Text("Culled %zu of %zu, drawn indirectly", stats.culled, stats.drawCount);
+            }
+        }
+        ImGui::Text("GPU buffers: %.1f / %.1f MB in %zu buffers", stats.buffers.usedBytes / 1048576.0,
+                    stats.buffers.reservedBytes / 1048576.0, stats.buffers.arenas);
+        if (ImGui::Checkbox("Profiler", &g_showProfiler)) profiler_set_enabled(g_showProfiler);
+
+        // switching scenes abandons one still streaming
+        ImGui::InputText("##open", g_openPath, sizeof(g_openPath));
+        ImGui::SameLine();
+        if (ImGui::Button("Open") && g_openPath[0]) graphics_load_scene_async(g_openPath);
+        ImGui::SliderFloat("Upload budget (ms)", &opt->streamBudgetMs, 0.5f, 16.0f, "%.1f");
+        ImGui::InputInt("GPU budget (MB, next open)", &opt->gpuBudgetMB, 64, 1024);
+        if (opt->gpuBudgetMB < 0) opt->gpuBudgetMB = 0;
+        if (stats.editable) {
+            ImGui::Separator();
+            edit_panel(stats);
+        } else {
+            g_selectMode = false;
         }
+        ImGui::Text("%s, RMB pan, wheel zoom", g_selectMode ? "LMB select" : "LMB orbit");
+        ImGui::End();
+    } else {
+        ImGui::Begin("Triangle Colors", nullptr, winFlags);
+        for (int i = 0; i < 3; ++i) {
+            char label[32];
+            snprintf(label, sizeof(label), "Vertex %d Color", i);
+            if (ImGui::ColorEdit4(label, &g_colors[i * 4])) {
+                updated = i;
+            }
+        }
+        ImGui::Text("Shader: shaders/gaussian.vert / gaussian.frag");
+        ImGui::End();
+    }
+
+    // camera navigation when the mouse is not over a UI window
+    ImGuiIO &io = ImGui::GetIO();
+    Camera *cam = graphics_camera();
+    if (splatCount > 0 && cam && (!io.WantCaptureMouse || g_dragging)) {
+        float h = io.DisplaySize.y > 0.0f ? io.DisplaySize.y : 1.0f;
+        if (g_selectMode) edit_input(io);
+        else if (io.MouseDown[0]) camera_orbit(cam, -io.MouseDelta.x * 0.005f, io.MouseDelta.y * 0.005f);
+        if (io.MouseDown[1]) camera_pan(cam, io.MouseDelta.x / h, io.MouseDelta.y / h);
+        if (io.MouseWheel != 0.0f) camera_zoom(cam, io.MouseWheel);
     }
-    ImGui::Text("Shader: shaders/gaussian.vert / gaussian.frag");
-    ImGui::End();
 
-    if (updated) {
-        // push updated colors to graphics SSBO
-        graphics_update_colors(g_colors, sizeof(g_colors));
+    if (splatCount == 0) g_selection.clear();
+    if (splatCount > 0 && !io.WantCaptureKeyboard && io.KeyCtrl) {
+        if (ImGui::IsKeyPressed(ImGuiKey_Z)) graphics_undo();
+        if (ImGui::IsKeyPressed(ImGuiKey_Y)) graphics_redo();
     }
 
-    ImGui::Render();
+    if (g_showProfiler) profiler_window();
+    else if (profiler_enabled()) profiler_set_enabled(false); // window closed
+
+    if (updated >= 0) {
+        // push the changed vertex's color to the graphics SSBO
+        graphics_update_colors(&g_colors[updated * 4], 4 * sizeof(float), updated * 4 * sizeof(float));
+    }
 
     int display_w = 0, display_h = 0;
     if (g_window)
         glfwGetFramebufferSize(g_window, &display_w, &display_h);
 
-    glViewport(0, 0, display_w, display_h);
-    glClearColor(0.1f, 0.12f, 0.15f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    // the compute engine's image goes behind every window; graphics_render
+    // fills it before the draw lists are submitted
+    uint32_t sceneTexture = graphics_scene_texture(display_w, display_h);
+    if (sceneTexture) {
+        ImGui::GetBackgroundDrawList()->AddImage((ImTextureID)(intptr_t)sceneTexture, ImVec2(0, 0), io.DisplaySize,
+                                                 ImVec2(0, 1), ImVec2(1, 0));
+    }
+
+    ImGui::Render();
 
-    // draw scene (triangle) behind ImGui
-    graphics_render();
+    // draw scene (triangle or splats) behind ImGui
+    {
+        PROFILE_ZONE("scene");
+        PROFILE_GPU("scene");
+        glViewport(0, 0, display_w, display_h);
+        glClearColor(0.1f, 0.12f, 0.15f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        graphics_render();
+    }
 
+    PROFILE_ZONE("imgui");
+    PROFILE_GPU("imgui");
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
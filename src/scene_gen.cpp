@@ -0,0 +1,112 @@
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include "scene_gen.h"
+
+// Axis-aligned quad the generator scatters splats over: corner + two edges.
+struct Face {
+    float origin[3], u[3], v[3];
+    float color[3];
+    bool windows; // facade pattern instead of pavement
+    float area;
+};
+
+static void add_face(std::vector<Face> *faces, const float o[3], const float u[3], const float v[3], const float rgb[3],
+                     bool windows)
+{
+    Face f;
+    for (int k = 0; k < 3; ++k) {
+        f.origin[k] = o[k];
+        f.u[k] = u[k];
+        f.v[k] = v[k];
+        f.color[k] = rgb[k];
+    }
+    f.windows = windows;
+    float lu = sqrtf(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+    float lv = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    f.area = lu * lv;
+    faces->push_back(f);
+}
+
+std::vector<GpuSplat> scene_generate_city(size_t count)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+
+    const int blocks = 8;
+    const float pitch = 24.0f, street = 8.0f;
+    const float half = blocks * pitch * 0.5f;
+    std::vector<Face> faces;
+    float ground[3] = {0.32f, 0.32f, 0.34f};
+    float go[3] = {-half, 0.0f, -half}, gu[3] = {2.0f * half, 0.0f, 0.0f}, gv[3] = {0.0f, 0.0f, 2.0f * half};
+    add_face(&faces, go, gu, gv, ground, false);
+    for (int bz = 0; bz < blocks; ++bz) {
+        for (int bx = 0; bx < blocks; ++bx) {
+            float x0 = -half + bx * pitch + street * 0.5f, z0 = -half + bz * pitch + street * 0.5f;
+            float w = pitch - street, h = 6.0f + 40.0f * u01(rng) * u01(rng);
+            float rgb[3] = {0.45f + 0.4f * u01(rng), 0.4f + 0.35f * u01(rng), 0.35f + 0.3f * u01(rng)};
+            float up[3] = {0.0f, h, 0.0f};
+            float ex[3] = {w, 0.0f, 0.0f}, ez[3] = {0.0f, 0.0f, w};
+            float p0[3] = {x0, 0.0f, z0}, p1[3] = {x0 + w, 0.0f, z0}, p2[3] = {x0, 0.0f, z0 + w};
+            add_face(&faces, p0, ex, up, rgb, true); // -z side
+            add_face(&faces, p2, ex, up, rgb, true); // +z side
+            add_face(&faces, p0, ez, up, rgb, true); // -x side
+            add_face(&faces, p1, ez, up, rgb, true); // +x side
+            float roof[3] = {x0, h, z0}, roofRgb[3] = {rgb[0] * 0.5f, rgb[1] * 0.5f, rgb[2] * 0.5f};
+            add_face(&faces, roof, ex, ez, roofRgb, false);
+        }
+    }
+
+    double totalArea = 0.0;
+    for (const Face &f : faces) totalArea += f.area;
+    float spacing = (float)sqrt(totalArea / (double)count);
+
+    std::vector<GpuSplat> splats;
+    splats.reserve(count);
+    for (const Face &f : faces) {
+        size_t n = (size_t)(count * (f.area / totalArea));
+        if (&f == &faces.back()) n = count - splats.size();
+
+        // rotation taking +z to the face normal (u x v)
+        float nx = f.u[1] * f.v[2] - f.u[2] * f.v[1];
+        float ny = f.u[2] * f.v[0] - f.u[0] * f.v[2];
+        float nz = f.u[0] * f.v[1] - f.u[1] * f.v[0];
+        float len = sqrtf(nx * nx + ny * ny + nz * nz);
+        nx /= len, ny /= len, nz /= len;
+        float ax = -ny, ay = nx, s = sqrtf(ax * ax + ay * ay);
+        float q[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+        if (s > 1e-6f) {
+            float angle = acosf(std::max(-1.0f, std::min(1.0f, nz))) * 0.5f;
+            q[0] = cosf(angle);
+            q[1] = ax / s * sinf(angle);
+            q[2] = ay / s * sinf(angle);
+        } else if (nz < 0.0f) {
+            q[0] = 0.0f;
+            q[1] = 1.0f;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            float a = u01(rng), b = u01(rng);
+            GpuSplat sp = GpuSplat();
+            for (int k = 0; k < 3; ++k) sp.position[k] = f.origin[k] + a * f.u[k] + b * f.v[k];
+            float shade = 1.0f;
+            if (f.windows) {
+                // 3 m floors, 2.5 m bays: dark panes inside lighter frames
+                float along = a * sqrtf(f.u[0] * f.u[0] + f.u[2] * f.u[2]), up = sp.position[1];
+                bool glass = fmodf(along, 2.5f) > 0.6f && fmodf(up, 3.0f) > 1.0f;
+                shade = glass ? 0.25f + 0.2f * u01(rng) : 1.0f;
+            } else {
+                float cx = floorf(sp.position[0] * 0.5f), cz = floorf(sp.position[2] * 0.5f);
+                shade = fmodf(fabsf(cx + cz), 2.0f) < 1.0f ? 1.0f : 0.8f;
+                shade *= 0.9f + 0.2f * u01(rng);
+            }
+            for (int k = 0; k < 3; ++k) sp.color[k] = std::min(1.0f, f.color[k] * shade);
+            sp.scale[0] = sp.scale[1] = spacing * (0.6f + 0.3f * u01(rng));
+            sp.scale[2] = spacing * 0.05f;
+            for (int k = 0; k < 4; ++k) sp.rotation[k] = q[k];
+            sp.opacity = sp.color[3] = 0.9f;
+            splats.push_back(sp);
+        }
+    }
+    return splats;
+}
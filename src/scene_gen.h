@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "splat.h"
+
+// Procedural test scenes, identical on every run.
+
+// A city of 8x8 blocks with towers of random height on a street plane,
+// about 190 units across with the ground at y = 0. Splats are flat disks
+// tangent to the faces, sized to the average spacing, with window and
+// pavement patterns so lost detail shows up in image comparisons.
+std::vector<GpuSplat> scene_generate_city(size_t count);
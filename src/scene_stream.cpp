@@ -0,0 +1,318 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "scene_stream.h"
+#include "mpmc_queue.h"
+#include "ply_loader.h"
+#include "gsb.h"
+
+// recycled chunk buffers, STREAM_CHUNK_SPLATS * 76 bytes (~5 MB) each,
+// plus up to 92 bytes per splat of SH
+static const size_t k_chunkBuffers = 12;
+static const size_t k_maxRequests = 1024;
+// splats whose SH a loader decodes as floats at a time before packing it
+static const size_t k_shSlice = 4096;
+
+// One open scene. Loaders hold a reference while decoding, so the file
+// stays mapped until the last of them lets go of an abandoned job.
+struct StreamJob {
+    uint32_t generation = 0;
+    bool isGsb = false;
+    PlyFile ply;
+    GsbFile gsb;
+    size_t count = 0, chunkCount = 0;
+    int shDegree = 0;                   // bands decoded into the chunks
+    std::atomic<size_t> nextChunk{0};   // first pass
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> pendingRequests{0};
+    MpmcQueue<uint32_t> requests{k_maxRequests};
+
+    ~StreamJob()
+    {
+        if (isGsb) gsb_close(&gsb);
+        else ply_close(&ply);
+    }
+};
+
+static std::mutex g_mutex;
+static std::condition_variable g_wake;
+static std::shared_ptr<StreamJob> g_job; // guarded by g_mutex
+static std::vector<std::thread> g_threads;
+static bool g_quit = false;
+static uint32_t g_generation = 0;        // render thread only
+
+static std::vector<std::unique_ptr<StreamChunk>> g_chunks;
+static std::unique_ptr<MpmcQueue<StreamChunk *>> g_free, g_ready;
+
+static bool has_work(const StreamJob *job)
+{
+    return job && !job->cancelled.load(std::memory_order_relaxed) &&
+           (job->nextChunk.load(std::memory_order_relaxed) < job->chunkCount ||
+            job->pendingRequests.load(std::memory_order_relaxed) > 0);
+}
+
+// Requested chunks first: they are on screen.
+static bool take_chunk(StreamJob *job, uint32_t *index)
+{
+    if (job->requests.pop(index)) {
+        job->pendingRequests.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    size_t next = job->nextChunk.load(std::memory_order_relaxed);
+    while (next < job->chunkCount) {
+        if (job->nextChunk.compare_exchange_weak(next, next + 1, std::memory_order_relaxed)) {
+            *index = (uint32_t)next;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void decode_chunk(const StreamJob &job, StreamChunk *chunk)
+{
+    size_t first = (size_t)chunk->index * STREAM_CHUNK_SPLATS;
+    chunk->count = std::min<size_t>(STREAM_CHUNK_SPLATS, job.count - first);
+
+    // SH comes out as 45 floats a splat: decode in slices and keep it packed
+    // to halves at the degree asked for
+    thread_local std::vector<float> shRest;
+    uint32_t words = splat_sh_words(job.shDegree);
+    size_t slice = job.shDegree > 0 ? k_shSlice : chunk->count;
+    chunk->shDegree = job.shDegree;
+    if (job.shDegree > 0) {
+        shRest.resize(k_shSlice * SPLAT_SH_REST_FLOATS);
+        chunk->sh.resize((size_t)STREAM_CHUNK_SPLATS * words);
+    }
+    for (size_t at = 0; at < chunk->count; at += slice) {
+        size_t n = std::min(slice, chunk->count - at);
+        SplatSink sink;
+        sink.splats = chunk->splats.data() + at;
+        for (int k = 0; k < 3; ++k) sink.centers[k] = chunk->centers[k].data() + at;
+        if (job.shDegree > 0) sink.shRest = shRest.data();
+        sink.first = first + at;
+        if (job.isGsb) gsb_decode(job.gsb, first + at, n, sink);
+        else ply_decode(job.ply, first + at, n, sink, nullptr, nullptr);
+        if (job.shDegree > 0) splat_sh_pack(shRest.data(), n, job.shDegree, chunk->sh.data() + at * words);
+    }
+
+    for (int k = 0; k < 3; ++k) {
+        const float *c = chunk->centers[k].data();
+        float lo = INFINITY, hi = -INFINITY;
+        for (size_t i = 0; i < chunk->count; ++i) {
+            lo = std::min(lo, c[i]);
+            hi = std::max(hi, c[i]);
+        }
+        chunk->boundsMin[k] = lo;
+        chunk->boundsMax[k] = hi;
+    }
+}
+
+static void loader_main()
+{
+    for (;;) {
+        std::shared_ptr<StreamJob> job;
+        {
+            // the queues are not guarded by the mutex, so a wake-up can be
+            // missed; the timeout bounds the delay
+            std::unique_lock<std::mutex> lock(g_mutex);
+            g_wake.wait_for(lock, std::chrono::milliseconds(5), [] { return g_quit || has_work(g_job.get()); });
+            if (g_quit) return;
+            if (!has_work(g_job.get())) continue;
+            job = g_job;
+        }
+
+        StreamChunk *chunk = nullptr;
+        if (!g_free->pop(&chunk)) {
+            // every buffer is queued or being uploaded: wait for the render thread
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        uint32_t index;
+        if (!take_chunk(job.get(), &index)) {
+            g_free->push(chunk);
+            continue;
+        }
+        chunk->generation = job->generation;
+        chunk->index = index;
+        decode_chunk(*job, chunk);
+        // the ready queue holds every buffer, so this never fails
+        g_ready->push(chunk);
+    }
+}
+
+static void start_loaders()
+{
+    if (!g_threads.empty()) return;
+    g_free.reset(new MpmcQueue<StreamChunk *>(k_chunkBuffers));
+    g_ready.reset(new MpmcQueue<StreamChunk *>(k_chunkBuffers));
+    for (size_t i = 0; i < k_chunkBuffers; ++i) {
+        StreamChunk *chunk = new StreamChunk();
+        chunk->splats.resize(STREAM_CHUNK_SPLATS);
+        for (int k = 0; k < 3; ++k) chunk->centers[k].resize(STREAM_CHUNK_SPLATS);
+        g_chunks.emplace_back(chunk);
+        g_free->push(chunk);
+    }
+
+    // leave the render thread a core of its own
+    unsigned hw = std::thread::hardware_concurrency();
+    unsigned n = std::max(1u, std::min(4u, hw > 1 ? hw - 1 : 1u));
+    g_quit = false;
+    for (unsigned i = 0; i < n; ++i) g_threads.emplace_back(loader_main);
+}
+
+bool scene_stream_open(const char *path, int shDegree, StreamInfo *info)
+{
+    scene_stream_cancel();
+
+    std::shared_ptr<StreamJob> job = std::make_shared<StreamJob>();
+    size_t n = strlen(path);
+    job->isGsb = n >= 4 && (strcmp(path + n - 4, ".gsb") == 0 || strcmp(path + n - 4, ".GSB") == 0);
+    *info = StreamInfo();
+    if (job->isGsb) {
+        if (!gsb_open(path, &job->gsb)) return false;
+        const GsbHeader &h = job->gsb.header;
+        job->count = (size_t)h.count;
+        info->shDegree = (int)h.shDegree;
+        info->hasBounds = true;
+        memcpy(info->boundsMin, h.boundsMin, sizeof(info->boundsMin));
+        memcpy(info->boundsMax, h.boundsMax, sizeof(info->boundsMax));
+    } else {
+        if (!ply_open(path, &job->ply)) return false;
+        job->count = job->ply.vertexCount;
+        info->shDegree = job->ply.shDegree;
+    }
+    if (job->count > 0xFFFFFFFFu) {
+        fprintf(stderr, "scene_stream: %s has too many splats (%zu)\n", path, job->count);
+        return false;
+    }
+    job->chunkCount = (job->count + STREAM_CHUNK_SPLATS - 1) / STREAM_CHUNK_SPLATS;
+    job->shDegree = std::max(0, std::min(shDegree, info->shDegree));
+    job->generation = ++g_generation;
+    info->count = job->count;
+    info->chunkCount = job->chunkCount;
+
+    start_loaders();
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_job = job;
+    }
+    g_wake.notify_all();
+    return true;
+}
+
+StreamChunk *scene_stream_pop()
+{
+    if (!g_ready) return nullptr;
+    StreamChunk *chunk;
+    while (g_ready->pop(&chunk)) {
+        if (chunk->generation == g_generation && g_job) return chunk;
+        g_free->push(chunk); // from an abandoned job
+    }
+    return nullptr;
+}
+
+void scene_stream_release(StreamChunk *chunk)
+{
+    if (!chunk) return;
+    g_free->push(chunk);
+    g_wake.notify_one();
+}
+
+bool scene_stream_request(uint32_t index)
+{
+    StreamJob *job = g_job.get(); // only the render thread replaces g_job
+    if (!job || index >= job->chunkCount) return false;
+    job->pendingRequests.fetch_add(1, std::memory_order_relaxed);
+    if (!job->requests.push(index)) {
+        job->pendingRequests.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    g_wake.notify_one();
+    return true;
+}
+
+void scene_stream_cancel()
+{
+    std::shared_ptr<StreamJob> old;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        old.swap(g_job);
+    }
+    if (old) old->cancelled = true;
+    ++g_generation;
+    // recycle what the abandoned job already queued
+    scene_stream_pop();
+}
+
+void scene_stream_shutdown()
+{
+    scene_stream_cancel();
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_quit = true;
+    }
+    g_wake.notify_all();
+    for (std::thread &t : g_threads) t.join();
+    g_threads.clear();
+    g_chunks.clear();
+    g_free.reset();
+    g_ready.reset();
+}
+
+// ---------------------------------------------------------------------------
+// Residency
+
+void stream_cache_init(StreamCache *cache, size_t chunkCount, size_t slotCount)
+{
+    cache->slotOf.assign(chunkCount, -1);
+    cache->chunkIn.assign(slotCount, -1);
+    cache->lastUsed.assign(chunkCount, 0);
+    cache->evictions = 0;
+}
+
+void stream_cache_touch(StreamCache *cache, uint32_t chunk, uint64_t frame)
+{
+    cache->lastUsed[chunk] = frame;
+}
+
+int stream_cache_acquire(StreamCache *cache, uint32_t chunk, uint64_t frame, int *evicted)
+{
+    *evicted = -1;
+    int slot = cache->slotOf[chunk];
+    if (slot < 0) {
+        if (cache->chunkIn.size() >= cache->slotOf.size()) {
+            slot = (int)chunk;
+        } else {
+            // a free slot, else the least recently used resident chunk
+            uint64_t oldest = UINT64_MAX;
+            for (size_t s = 0; s < cache->chunkIn.size(); ++s) {
+                int c = cache->chunkIn[s];
+                if (c < 0) {
+                    slot = (int)s;
+                    break;
+                }
+                if (cache->lastUsed[c] < frame && cache->lastUsed[c] < oldest) {
+                    oldest = cache->lastUsed[c];
+                    slot = (int)s;
+                }
+            }
+            if (slot < 0) return -1;
+            if (cache->chunkIn[slot] >= 0) {
+                *evicted = cache->chunkIn[slot];
+                cache->slotOf[*evicted] = -1;
+                cache->evictions++;
+            }
+        }
+        cache->slotOf[chunk] = slot;
+        cache->chunkIn[slot] = (int)chunk;
+    }
+    cache->lastUsed[chunk] = frame;
+    return slot;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "splat.h"
+
+// Background scene streaming.
+//
+// A scene file (.ply or .gsb) is mapped and cut into fixed-size chunks that
+// loader threads decode into a small set of recycled host buffers. Decoded
+// chunks reach the render thread through a lock-free queue and go back
+// through another once uploaded, so host memory stays bounded however large
+// the scene is and the render thread never waits on a loader. Opening a new
+// scene or cancelling abandons the current job: loaders drop it after the
+// chunk in hand, and chunks of an old job still queued are recognised by
+// their generation and recycled unseen.
+//
+// Every chunk is decoded once, in file order. A chunk evicted later (see
+// StreamCache) can be requested again while the scene stays open.
+
+enum { STREAM_CHUNK_SPLATS = 1 << 16 };
+
+// One decoded chunk: splats [index * STREAM_CHUNK_SPLATS, + count).
+struct StreamChunk {
+    uint32_t generation = 0;
+    uint32_t index = 0;
+    size_t count = 0;
+    std::vector<GpuSplat> splats;      // STREAM_CHUNK_SPLATS, first `count` valid
+    std::vector<float> centers[3];     // SoA copy of the positions
+    int shDegree = 0;
+    std::vector<uint32_t> sh;          // splat_sh_words(shDegree) words per splat (splat.h)
+    float boundsMin[3], boundsMax[3];  // of the centers
+};
+
+struct StreamInfo {
+    size_t count = 0;        // splats in the scene
+    size_t chunkCount = 0;
+    int shDegree = 0;        // stored in the file
+    bool hasBounds = false;  // .gsb headers store the scene bounds up front
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+    float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+};
+
+// Open `path` (only its header is read here) and start decoding it in the
+// background, abandoning any scene still streaming. Chunks carry the SH
+// bands up to `shDegree` the file has, packed for the GPU. Returns false
+// (and logs) when the file can't be opened.
+bool scene_stream_open(const char *path, int shDegree, StreamInfo *info);
+
+// Next decoded chunk of the open scene, or nullptr if none is ready. Never
+// blocks. Hand every chunk back with scene_stream_release.
+StreamChunk *scene_stream_pop();
+void scene_stream_release(StreamChunk *chunk);
+
+// Decode chunk `index` of the open scene again, ahead of the first pass.
+// Returns false when the request queue is full (try again next frame).
+bool scene_stream_request(uint32_t index);
+
+// Abandon the open scene. Chunks already handed out may still be released.
+void scene_stream_cancel();
+
+// Stop the loader threads and free the chunk buffers.
+void scene_stream_shutdown();
+
+// Which chunks own a slot of a fixed pool (GPU memory for chunks of a
+// scene too large for its budget). A chunk without a slot takes a free one
+// or evicts the least recently used; chunks used in the current frame are
+// never evicted. With at least as many slots as chunks, chunk i always gets
+// slot i.
+struct StreamCache {
+    std::vector<int32_t> slotOf;   // per chunk, -1 when not resident
+    std::vector<int32_t> chunkIn;  // per slot, -1 when free
+    std::vector<uint64_t> lastUsed; // per chunk, frame number
+    size_t evictions = 0;
+};
+
+void stream_cache_init(StreamCache *cache, size_t chunkCount, size_t slotCount);
+
+// Mark a resident chunk as used in `frame`.
+void stream_cache_touch(StreamCache *cache, uint32_t chunk, uint64_t frame);
+
+// Give `chunk` a slot, used in `frame`. Sets *evicted to the chunk that lost
+// the slot, or -1. Returns -1 when every slot is in use this frame.
+int stream_cache_acquire(StreamCache *cache, uint32_t chunk, uint64_t frame, int *evicted);
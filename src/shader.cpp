@@ -0,0 +1,398 @@
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include "shader.h"
+
+namespace fs = std::filesystem;
+
+struct ShaderStage {
+    GLenum type;
+    std::string path;
+};
+
+// A program begun by this module: its sources (for hot reload) and, until
+// shader_finish, the shaders being compiled.
+struct ProgramEntry {
+    GLuint program = 0;
+    ShaderStage stages[2];
+    int stageCount = 0;
+    GLuint shaders[2] = {0, 0};
+    uint64_t key = 0; // binary cache key, 0 when not cached
+    bool built = false;
+};
+
+struct ShaderWatch {
+    uint32_t *slot = nullptr;
+    ShaderReloadFn onReload = nullptr;
+    GLuint program = 0; // what *slot held when last checked
+    GLuint pending = 0; // rebuild in flight
+    ShaderStage stages[2];
+    int stageCount = 0;
+    fs::file_time_type mtimes[2];
+};
+
+// cache file: header then the driver's binary
+struct BinaryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t length;
+};
+static const uint32_t k_binaryMagic = 0x42505347; // "GSPB"
+static const uint32_t k_binaryVersion = 1;
+static const double k_pollSeconds = 0.25;
+
+static std::vector<ProgramEntry> g_programs;
+static std::vector<ShaderWatch> g_watches;
+static std::string g_cacheDir;
+static std::string g_driver;
+static ShaderStats g_stats;
+static std::chrono::steady_clock::time_point g_lastPoll;
+
+static std::string read_file(const char *path)
+{
+    std::ifstream ifs(path, std::ios::in | std::ios::binary);
+    if (!ifs) return std::string();
+    std::ostringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+static void hash_bytes(uint64_t *h, const void *data, size_t size)
+{
+    // FNV-1a
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < size; ++i) {
+        *h ^= p[i];
+        *h *= 0x100000001b3ull;
+    }
+}
+
+static std::string cache_path(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return (fs::path(g_cacheDir) / name).string();
+}
+
+static ProgramEntry *find_entry(GLuint program)
+{
+    for (ProgramEntry &e : g_programs)
+        if (e.program == program) return &e;
+    return nullptr;
+}
+
+void shader_init(const char *cacheDir)
+{
+    if (GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+    else if (GLAD_GL_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+    g_stats.parallelCompile = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+
+    g_cacheDir.clear();
+    g_stats.cacheEnabled = false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (!cacheDir || formats <= 0) return;
+    std::error_code ec;
+    fs::create_directories(cacheDir, ec);
+    if (ec) {
+        fprintf(stderr, "shader: cannot create cache directory %s (%s), not caching\n", cacheDir, ec.message().c_str());
+        return;
+    }
+    g_cacheDir = cacheDir;
+    g_driver.clear();
+    const GLenum names[4] = {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION};
+    for (GLenum n : names) {
+        const char *s = (const char *)glGetString(n);
+        g_driver += s ? s : "";
+        g_driver += '\n';
+    }
+    g_stats.cacheEnabled = true;
+}
+
+static bool load_binary(GLuint program, uint64_t key)
+{
+    std::string data = read_file(cache_path(key).c_str());
+    BinaryHeader h;
+    if (data.size() < sizeof(h)) return false;
+    memcpy(&h, data.data(), sizeof(h));
+    if (h.magic != k_binaryMagic || h.version != k_binaryVersion || h.length != data.size() - sizeof(h))
+        return false;
+    glProgramBinary(program, h.format, data.data() + sizeof(h), (GLsizei)h.length);
+    GLint ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    return ok != 0;
+}
+
+static void store_binary(GLuint program, uint64_t key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    std::vector<char> data(sizeof(BinaryHeader) + (size_t)length);
+    BinaryHeader h = {k_binaryMagic, k_binaryVersion, 0, 0};
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &h.format, data.data() + sizeof(h));
+    if (written <= 0) return;
+    h.length = (uint32_t)written;
+    memcpy(data.data(), &h, sizeof(h));
+
+    // write aside and rename so a concurrent start never reads half a file
+    std::string path = cache_path(key);
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f) return;
+    bool ok = fwrite(data.data(), 1, sizeof(h) + (size_t)written, f) == sizeof(h) + (size_t)written;
+    ok = fclose(f) == 0 && ok;
+    std::error_code ec;
+    if (ok) fs::rename(tmp, path, ec);
+    if (!ok || ec) {
+        fprintf(stderr, "shader: failed to write %s\n", path.c_str());
+        fs::remove(tmp, ec);
+    }
+}
+
+static GLuint begin_build(const ShaderStage *stages, int count)
+{
+    // forget programs their owners have deleted
+    for (size_t i = 0; i < g_programs.size();) {
+        if (g_programs[i].built && !glIsProgram(g_programs[i].program)) g_programs.erase(g_programs.begin() + i);
+        else ++i;
+    }
+
+    std::string sources[2];
+    for (int i = 0; i < count; ++i) {
+        sources[i] = read_file(stages[i].path.c_str());
+        if (sources[i].empty()) {
+            fprintf(stderr, "shader: Failed to read shader file %s\n", stages[i].path.c_str());
+            return 0;
+        }
+    }
+
+    ProgramEntry entry;
+    entry.stageCount = count;
+    for (int i = 0; i < count; ++i) entry.stages[i] = stages[i];
+    if (g_stats.cacheEnabled) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        hash_bytes(&h, g_driver.data(), g_driver.size());
+        for (int i = 0; i < count; ++i) {
+            hash_bytes(&h, &stages[i].type, sizeof(stages[i].type));
+            hash_bytes(&h, sources[i].data(), sources[i].size());
+        }
+        entry.key = h ? h : 1;
+    }
+
+    entry.program = glCreateProgram();
+    if (entry.key && load_binary(entry.program, entry.key)) {
+        entry.built = true;
+        ++g_stats.cacheHits;
+        g_programs.push_back(entry);
+        return entry.program;
+    }
+    if (entry.key) {
+        // a rejected binary can leave state behind; build into a fresh object
+        glDeleteProgram(entry.program);
+        entry.program = glCreateProgram();
+    }
+
+    // compile and link without querying status, so the driver can overlap
+    // this build with the caller's next ones
+    for (int i = 0; i < count; ++i) {
+        const char *s = sources[i].c_str();
+        entry.shaders[i] = glCreateShader(stages[i].type);
+        glShaderSource(entry.shaders[i], 1, &s, NULL);
+        glCompileShader(entry.shaders[i]);
+        glAttachShader(entry.program, entry.shaders[i]);
+    }
+    if (entry.key) glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(entry.program);
+    ++g_stats.compiled;
+    g_programs.push_back(entry);
+    return entry.program;
+}
+
+uint32_t shader_begin_program(const char *vsPath, const char *fsPath)
+{
+    ShaderStage stages[2] = {{GL_VERTEX_SHADER, vsPath}, {GL_FRAGMENT_SHADER, fsPath}};
+    return begin_build(stages, 2);
+}
+
+uint32_t shader_begin_compute(const char *csPath)
+{
+    ShaderStage stage = {GL_COMPUTE_SHADER, csPath};
+    return begin_build(&stage, 1);
+}
+
+bool shader_ready(uint32_t program)
+{
+    const ProgramEntry *e = find_entry(program);
+    if (!e || e->built || !g_stats.parallelCompile) return true;
+    GLint done = 0;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+    return done != 0;
+}
+
+static void log_shader_errors(const ProgramEntry &e)
+{
+    for (int i = 0; i < e.stageCount; ++i) {
+        GLint ok = 0;
+        glGetShaderiv(e.shaders[i], GL_COMPILE_STATUS, &ok);
+        if (ok) continue;
+        GLint len = 0;
+        glGetShaderiv(e.shaders[i], GL_INFO_LOG_LENGTH, &len);
+        std::vector<char> log(len ? len : 1);
+        glGetShaderInfoLog(e.shaders[i], (GLsizei)log.size(), NULL, log.data());
+        fprintf(stderr, "Shader compile error (%s): %s\n", e.stages[i].path.c_str(), log.data());
+    }
+}
+
+bool shader_finish(uint32_t *program)
+{
+    if (!program || !*program) return false;
+    ProgramEntry *e = find_entry(*program);
+    if (!e || e->built) return true;
+
+    GLint ok = 0;
+    glGetProgramiv(e->program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        log_shader_errors(*e);
+        GLint len = 0;
+        glGetProgramiv(e->program, GL_INFO_LOG_LENGTH, &len);
+        std::vector<char> log(len ? len : 1);
+        glGetProgramInfoLog(e->program, (GLsizei)log.size(), NULL, log.data());
+        fprintf(stderr, "Program link error (%s): %s\n", e->stages[0].path.c_str(), log.data());
+    }
+    for (int i = 0; i < e->stageCount; ++i) {
+        glDetachShader(e->program, e->shaders[i]);
+        glDeleteShader(e->shaders[i]);
+        e->shaders[i] = 0;
+    }
+    if (!ok) {
+        glDeleteProgram(e->program);
+        g_programs.erase(g_programs.begin() + (e - g_programs.data()));
+        *program = 0;
+        return false;
+    }
+    if (e->key) store_binary(e->program, e->key);
+    e->built = true;
+    return true;
+}
+
+uint32_t shader_load_program(const char *vsPath, const char *fsPath)
+{
+    uint32_t p = shader_begin_program(vsPath, fsPath);
+    shader_finish(&p);
+    return p;
+}
+
+uint32_t shader_load_compute(const char *csPath)
+{
+    uint32_t p = shader_begin_compute(csPath);
+    shader_finish(&p);
+    return p;
+}
+
+static bool stage_mtime(const ShaderStage &s, fs::file_time_type *t)
+{
+    std::error_code ec;
+    *t = fs::last_write_time(s.path, ec);
+    return !ec;
+}
+
+void shader_watch(uint32_t *program, ShaderReloadFn onReload)
+{
+    if (!program || !*program) return;
+    const ProgramEntry *e = find_entry(*program);
+    if (!e) return;
+
+    ShaderWatch *w = nullptr;
+    for (ShaderWatch &existing : g_watches)
+        if (existing.slot == program) w = &existing;
+    if (!w) {
+        g_watches.push_back(ShaderWatch());
+        w = &g_watches.back();
+    }
+    if (w->pending) glDeleteProgram(w->pending);
+    w->slot = program;
+    w->onReload = onReload;
+    w->program = *program;
+    w->pending = 0;
+    w->stageCount = e->stageCount;
+    for (int i = 0; i < e->stageCount; ++i) {
+        w->stages[i] = e->stages[i];
+        stage_mtime(w->stages[i], &w->mtimes[i]);
+    }
+}
+
+void shader_poll_reload()
+{
+    if (g_watches.empty()) return;
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - g_lastPoll).count() < k_pollSeconds) return;
+    g_lastPoll = now;
+
+    for (size_t i = 0; i < g_watches.size();) {
+        ShaderWatch &w = g_watches[i];
+        // the owner deleted or replaced the program: stop watching
+        if (*w.slot != w.program) {
+            if (w.pending) glDeleteProgram(w.pending);
+            g_watches.erase(g_watches.begin() + i);
+            continue;
+        }
+        ++i;
+
+        if (w.pending) {
+            if (!shader_ready(w.pending)) continue;
+            if (shader_finish(&w.pending)) {
+                glDeleteProgram(w.program);
+                *w.slot = w.pending;
+                w.program = w.pending;
+                if (w.onReload) w.onReload();
+                ++g_stats.reloads;
+                printf("shader: reloaded %s\n", w.stages[0].path.c_str());
+            } else {
+                fprintf(stderr, "shader: keeping the previous %s\n", w.stages[0].path.c_str());
+            }
+            w.pending = 0;
+            continue;
+        }
+
+        bool changed = false;
+        for (int s = 0; s < w.stageCount; ++s) {
+            fs::file_time_type t;
+            if (stage_mtime(w.stages[s], &t) && t != w.mtimes[s]) {
+                w.mtimes[s] = t;
+                changed = true;
+            }
+        }
+        if (!changed) continue;
+        w.pending = begin_build(w.stages, w.stageCount);
+    }
+}
+
+const ShaderStats &shader_stats()
+{
+    return g_stats;
+}
+
+void shader_shutdown()
+{
+    for (ShaderWatch &w : g_watches)
+        if (w.pending) glDeleteProgram(w.pending);
+    g_watches.clear();
+    for (ProgramEntry &e : g_programs) {
+        if (e.built) continue;
+        for (int i = 0; i < e.stageCount; ++i) glDeleteShader(e.shaders[i]);
+        glDeleteProgram(e.program);
+    }
+    g_programs.clear();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// GLSL programs built from files.
+//
+// Linked programs are cached as driver binaries (glGetProgramBinary) under
+// a key hashed from their sources and the GL vendor, renderer and version
+// strings, so warm starts skip compiling; an edited shader or a new driver
+// simply misses. Builds are issued without waiting on the result: with
+// GL_KHR_parallel_shader_compile the driver compiles a batch of programs on
+// its own threads while the caller goes on. Watched programs are rebuilt
+// when their files change and swapped in once they link.
+
+// Use `cacheDir` for program binaries (created if missing; nullptr turns the
+// cache off) and let the driver use its compiler threads. Optional: without
+// it programs still build, uncached.
+void shader_init(const char *cacheDir);
+
+// Compile and link a vertex + fragment program from files, waiting for the
+// result. Returns 0 on failure (errors are logged with the file name).
+uint32_t shader_load_program(const char *vsPath, const char *fsPath);
+
+// Compile and link a compute program from a file. Returns 0 on failure.
+uint32_t shader_load_compute(const char *csPath);
+
+// Start building a program and return it at once, or 0 if a file can't be
+// read. Use it only after shader_finish has returned true.
+uint32_t shader_begin_program(const char *vsPath, const char *fsPath);
+uint32_t shader_begin_compute(const char *csPath);
+
+// Whether a begun program has finished building (never waits).
+bool shader_ready(uint32_t program);
+
+// Wait for a begun program. On failure logs the errors, deletes the program,
+// sets *program to 0 and returns false.
+bool shader_finish(uint32_t *program);
+
+// Hot reload: when the source files of *program change, a new program is
+// built in the background and, once it links, replaces *program (the old one
+// is deleted) and onReload runs so the owner can look up its uniforms again.
+// A program that fails to build is reported and the old one kept.
+typedef void (*ShaderReloadFn)();
+void shader_watch(uint32_t *program, ShaderReloadFn onReload);
+
+// Check watched files (at most a few times a second) and swap in rebuilt
+// programs. Call once per frame on the GL thread.
+void shader_poll_reload();
+
+struct ShaderStats {
+    size_t cacheHits = 0;   // programs loaded from a cached binary
+    size_t compiled = 0;    // programs compiled from source
+    size_t reloads = 0;     // programs swapped in by hot reload
+    bool parallelCompile = false;
+    bool cacheEnabled = false;
+};
+const ShaderStats &shader_stats();
+
+// Forget watches and abandon rebuilds in flight.
+void shader_shutdown();
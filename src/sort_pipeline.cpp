@@ -0,0 +1,209 @@
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "sort_pipeline.h"
+#include "triple_buffer.h"
+#include "math3d.h"
+#include "parallel.h"
+#include "profiler.h"
+
+// Splats whose centers fall outside this multiple of the clip volume are
+// dropped; splat.vert culls at 1.2, so the margin keeps images identical.
+static const float k_cullGuard = 1.25f;
+static const size_t k_cullGrain = 1 << 16;
+
+static std::thread g_thread;
+static std::mutex g_wakeMutex;
+static std::condition_variable g_wake;
+static std::atomic<bool> g_quit{false};
+
+static TripleBuffer<SortRequest> g_requests;
+static TripleBuffer<SortResult> g_results;
+
+// Held by the worker while it prepares a frame, and by the GL thread while
+// it swaps the scene.
+static std::mutex g_sceneMutex;
+static SortPipelineScene g_scene;
+static uint64_t g_epoch = 0;        // bumped by start/stop
+static bool g_active = false;       // GL thread's view
+
+// worker state
+static DepthSorter g_sorter;
+static std::vector<uint32_t> g_cut;
+static std::vector<float> g_cutCenters[3];
+static SortRequest g_last;
+static uint64_t g_lastEpoch = 0;
+static bool g_hasLast = false, g_lastLod = false;
+
+uint64_t sort_pipeline_now_ns()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Same view and LOD settings as the frame prepared last: nothing to do.
+static bool same_as_last(const SortRequest &req)
+{
+    return g_hasLast && g_lastEpoch == g_epoch && memcmp(req.view, g_last.view, sizeof(req.view)) == 0 &&
+           memcmp(req.proj, g_last.proj, sizeof(req.proj)) == 0 && req.height == g_last.height &&
+           req.lod == g_last.lod && req.lodPixelSize == g_last.lodPixelSize;
+}
+
+static void prepare(const SortRequest &req, SortResult *out)
+{
+    PROFILE_ZONE("sort_prepare");
+    uint64_t t0 = sort_pipeline_now_ns();
+    out->request = req;
+    out->epoch = g_epoch;
+    out->lod = SplatLodCutStats();
+
+    const float *centers[3] = {g_scene.centers[0], g_scene.centers[1], g_scene.centers[2]};
+    size_t count = g_scene.count;
+    bool lod = req.lod && g_scene.lod;
+    if (lod) {
+        SplatLodParams params;
+        params.focal = req.proj[5] * req.height * 0.5f;
+        params.tanHalfFov[0] = 1.0f / req.proj[0];
+        params.tanHalfFov[1] = 1.0f / req.proj[5];
+        params.pixelSize = req.lodPixelSize;
+        splat_lod_select(*g_scene.lod, req.view, params, &g_cut, &out->lod);
+        count = g_cut.size();
+        for (int k = 0; k < 3; ++k) g_cutCenters[k].resize(count);
+        parallel_for(count, 1 << 15, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                for (int k = 0; k < 3; ++k) g_cutCenters[k][i] = g_scene.centers[k][g_cut[i]];
+        });
+        for (int k = 0; k < 3; ++k) centers[k] = g_cutCenters[k].data();
+    }
+    // a new cut is a different set of splats: last frame's order is no help
+    if (lod || lod != g_lastLod) depth_sort_reset(&g_sorter);
+    g_lastLod = lod;
+    out->lodActive = lod;
+
+    const uint32_t *order = depth_sort(&g_sorter, centers[0], centers[1], centers[2], count, req.view);
+    out->sort = g_sorter.stats;
+
+    // map cut entries back to splats and drop those outside the view,
+    // compacting each block in place and then closing the gaps
+    float vp[16];
+    mat4_mul(req.proj, req.view, vp);
+    out->order.resize(count);
+    size_t blocks = (count + k_cullGrain - 1) / k_cullGrain;
+    std::vector<size_t> kept(blocks, 0);
+    uint32_t *dst = out->order.data();
+    if (order) {
+        parallel_for(count, k_cullGrain, [&](size_t begin, size_t end) {
+            size_t n = 0;
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t s = lod ? g_cut[order[i]] : order[i];
+                float x = g_scene.centers[0][s], y = g_scene.centers[1][s], z = g_scene.centers[2][s];
+                float cx = vp[0] * x + vp[4] * y + vp[8] * z + vp[12];
+                float cy = vp[1] * x + vp[5] * y + vp[9] * z + vp[13];
+                float cw = vp[3] * x + vp[7] * y + vp[11] * z + vp[15];
+                float limit = k_cullGuard * cw;
+                if (cw > 0.0f && fabsf(cx) <= limit && fabsf(cy) <= limit) dst[begin + n++] = s;
+            }
+            kept[begin / k_cullGrain] = n;
+        });
+    }
+    size_t total = 0;
+    for (size_t b = 0; b < blocks; ++b) {
+        if (total != b * k_cullGrain) memmove(dst + total, dst + b * k_cullGrain, kept[b] * sizeof(uint32_t));
+        total += kept[b];
+    }
+    out->order.resize(total);
+    out->culled = count - total;
+
+    out->readyNs = sort_pipeline_now_ns();
+    out->workMs = (double)(out->readyNs - t0) * 1e-6;
+}
+
+static void worker_main()
+{
+    for (;;) {
+        {
+            // sort_pipeline_submit publishes and notifies without taking
+            // g_wakeMutex (the render thread never blocks on it), so its
+            // notify can land after pending() reads false but before this
+            // thread waits. The 2 ms timeout caps that lost wake-up at
+            // one extra poll.
+            std::unique_lock<std::mutex> lock(g_wakeMutex);
+            g_wake.wait_for(lock, std::chrono::milliseconds(2),
+                            [] { return g_quit.load() || g_requests.pending(); });
+        }
+        if (g_quit) return;
+        if (!g_requests.update()) continue;
+
+        std::lock_guard<std::mutex> scene(g_sceneMutex);
+        const SortRequest &req = g_requests.front();
+        if (g_scene.count == 0 || same_as_last(req)) continue;
+        prepare(req, &g_results.back());
+        g_last = req;
+        g_lastEpoch = g_epoch;
+        g_hasLast = true;
+        g_results.publish();
+    }
+}
+
+void sort_pipeline_start(const SortPipelineScene &scene)
+{
+    if (!g_thread.joinable()) {
+        g_quit = false;
+        g_thread = std::thread(worker_main);
+    }
+    std::lock_guard<std::mutex> lock(g_sceneMutex);
+    g_scene = scene;
+    g_epoch++;
+    g_hasLast = false;
+    depth_sort_reset(&g_sorter);
+    g_sorter.maxTranslationDelta = scene.maxTranslationDelta;
+    g_active = true;
+}
+
+void sort_pipeline_stop()
+{
+    if (!g_active) return;
+    std::lock_guard<std::mutex> lock(g_sceneMutex);
+    g_scene = SortPipelineScene();
+    g_epoch++;
+    g_hasLast = false;
+    depth_sort_reset(&g_sorter);
+    std::vector<uint32_t>().swap(g_cut);
+    for (int k = 0; k < 3; ++k) std::vector<float>().swap(g_cutCenters[k]);
+    g_active = false;
+}
+
+bool sort_pipeline_active()
+{
+    return g_active;
+}
+
+void sort_pipeline_submit(const SortRequest &request)
+{
+    g_requests.back() = request;
+    g_requests.publish();
+    g_wake.notify_one();
+}
+
+const SortResult *sort_pipeline_acquire()
+{
+    if (!g_results.update()) return nullptr;
+    // g_epoch only changes on this thread, under the scene lock
+    const SortResult &r = g_results.front();
+    return r.epoch == g_epoch ? &r : nullptr;
+}
+
+void sort_pipeline_shutdown()
+{
+    sort_pipeline_stop();
+    if (!g_thread.joinable()) return;
+    g_quit = true;
+    g_wake.notify_all();
+    g_thread.join();
+}
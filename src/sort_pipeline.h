@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "depth_sort.h"
+#include "splat_lod.h"
+
+// CPU frame preparation on a worker thread.
+//
+// The GL thread posts the camera of each frame and the worker turns it into
+// the frame's splat data: the LOD cut (when the scene has one), the
+// back-to-front depth sort and a frustum cull. Requests and results travel
+// through lock-free triple buffers, so while the GL thread renders frame N
+// the worker prepares the next camera, and neither waits for the other.
+// Each result carries the camera it was computed for; drawing with that
+// camera keeps sort and cull exact at the cost of one frame of latency,
+// which the results let the caller measure.
+
+// Read-only scene data the worker uses. Must stay unchanged between
+// sort_pipeline_start and sort_pipeline_stop.
+struct SortPipelineScene {
+    const float *centers[3] = {nullptr, nullptr, nullptr}; // originals, then coarse LOD splats
+    size_t count = 0;                                      // original splats
+    const SplatLod *lod = nullptr;
+    float maxTranslationDelta = 0.05f;                     // see DepthSorter
+};
+
+struct SortRequest {
+    uint64_t frame = 0;
+    uint64_t sampleNs = 0;     // when the camera was sampled (steady clock)
+    float view[16], proj[16];  // column-major
+    int height = 1;            // viewport, for the LOD pixel size
+    bool lod = false;
+    float lodPixelSize = 2.0f;
+};
+
+struct SortResult {
+    SortRequest request;           // the camera this data is for
+    uint64_t epoch = 0;
+    std::vector<uint32_t> order;   // visible splat indices, back to front
+    size_t culled = 0;             // dropped outside the view
+    DepthSortStats sort;
+    SplatLodCutStats lod;
+    bool lodActive = false;
+    double workMs = 0.0;           // cut + sort + cull
+    uint64_t readyNs = 0;
+};
+
+// Begin preparing frames for `scene`, replacing any previous one.
+void sort_pipeline_start(const SortPipelineScene &scene);
+
+// Wait for the frame in progress and forget the scene. Results computed for
+// it are never returned.
+void sort_pipeline_stop();
+
+bool sort_pipeline_active();
+
+// Post the newest camera (an unprocessed older one is replaced).
+void sort_pipeline_submit(const SortRequest &request);
+
+// The newest result not yet returned, or nullptr. Valid until the next call.
+const SortResult *sort_pipeline_acquire();
+
+// Stop the worker thread.
+void sort_pipeline_shutdown();
+
+uint64_t sort_pipeline_now_ns();
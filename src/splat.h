@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "half.h"
+
+// Highest spherical-harmonics degree stored per splat.
+constexpr int SPLAT_MAX_SH_DEGREE = 3;
+
+// Higher-band SH coefficients per color channel (bands 1..3).
+constexpr int SPLAT_SH_REST_COEFFS = 15;
+
+// Floats of higher-band SH per splat, stored coefficient-major as RGB triplets.
+constexpr int SPLAT_SH_REST_FLOATS = SPLAT_SH_REST_COEFFS * 3;
+
+// Band-0 SH basis constant, used to turn f_dc into a base color.
+constexpr float SPLAT_SH_C0 = 0.28209479177387814f;
+
+// Coefficients per color channel of SH bands 1..degree.
+inline int splat_sh_coeffs(int degree)
+{
+    return degree <= 0 ? 0 : (degree + 1) * (degree + 1) - 1;
+}
+
+// 32-bit words of higher-band SH per splat as the GPU holds it
+// (shaders/splat_sh.comp): the coefficients of bands 1..degree as half
+// RGB triplets, coefficient-major, two halves per word.
+inline uint32_t splat_sh_words(int degree)
+{
+    return (uint32_t)(splat_sh_coeffs(degree) * 3 + 1) / 2;
+}
+
+// Convert `count` splats of SPLAT_SH_REST_FLOATS floats to
+// splat_sh_words(degree) words each, dropping the bands above `degree`.
+inline void splat_sh_pack(const float *shRest, size_t count, int degree, uint32_t *out)
+{
+    int n = splat_sh_coeffs(degree) * 3;
+    uint32_t words = splat_sh_words(degree);
+    for (size_t i = 0; i < count; ++i) {
+        const float *src = shRest + i * SPLAT_SH_REST_FLOATS;
+        uint32_t *dst = out + i * words;
+        for (int j = 0; j < n; j += 2) {
+            uint32_t hi = j + 1 < n ? half_from_float(src[j + 1]) : 0u;
+            dst[j / 2] = (uint32_t)half_from_float(src[j]) | hi << 16;
+        }
+    }
+}
+
+// One Gaussian as laid out in the splat SSBO (std430, four vec4s).
+// Activations are applied at load time, so shaders read final values.
+struct GpuSplat {
+    float position[3];
+    float opacity;     // sigmoid(raw opacity)
+    float scale[3];    // exp(raw log-scale)
+    float _pad0;
+    float rotation[4]; // normalized quaternion (w, x, y, z)
+    float color[4];    // band-0 SH as RGB; alpha mirrors opacity
+};
+
+static_assert(sizeof(GpuSplat) == 64, "GpuSplat must match the std430 layout in the shaders");
+
+// Render-side copy of a GpuSplat, half the size, written on the GPU by
+// shaders/splat_pack.comp and read by the splat vertex shader (two uvec4s).
+struct PackedSplat {
+    float position[3];
+    uint32_t scaleXY;    // packHalf2x16(scale.x, scale.y)
+    uint32_t scaleZ;     // packHalf2x16(scale.z, 0)
+    uint32_t rotationWX; // packHalf2x16(w, x)
+    uint32_t rotationYZ; // packHalf2x16(y, z)
+    uint32_t color;      // packUnorm4x8(clamped rgb, opacity)
+};
+
+static_assert(sizeof(PackedSplat) == 32, "PackedSplat must match shaders/splat_pack.comp");
+
+// Destination arrays for decoded splats, indexed by splat index minus
+// `first` (0 for whole-scene arrays, the chunk start for chunk buffers).
+// Any array may be null.
+struct SplatSink {
+    GpuSplat *splats = nullptr;          // only written; may be mapped GPU memory
+    float *shRest = nullptr;             // SPLAT_SH_REST_FLOATS per splat
+    float *centers[3] = {nullptr, nullptr, nullptr}; // SoA x/y/z copy for CPU passes
+    size_t first = 0;
+};
@@ -0,0 +1,178 @@
+#include <math.h>
+#include <algorithm>
+#include "splat_edit.h"
+#include "parallel.h"
+
+static const size_t k_grain = 1 << 14;
+
+static const uint16_t k_transformFields = SPLAT_FIELD_POSITION | SPLAT_FIELD_SCALE | SPLAT_FIELD_ROTATION;
+
+static uint16_t op_fields(int op)
+{
+    switch (op) {
+    case SPLAT_EDIT_DELETE:
+    case SPLAT_EDIT_OPACITY: return SPLAT_FIELD_OPACITY;
+    case SPLAT_EDIT_COLOR: return SPLAT_FIELD_COLOR;
+    case SPLAT_EDIT_TRANSFORM: return k_transformFields;
+    default: return 0;
+    }
+}
+
+static int field_count(uint16_t fields)
+{
+    int n = 0;
+    for (; fields; fields &= fields - 1) ++n;
+    return n;
+}
+
+size_t SplatEditStep::bytes() const
+{
+    size_t total = 0;
+    for (const SplatDelta &d : deltas) total += d.indices.size() * sizeof(uint32_t) + d.values.size() * sizeof(float);
+    return total;
+}
+
+// Copy the masked floats of s to out, or with `swap`, exchange them.
+static void save_fields(GpuSplat *s, uint16_t fields, float *out, bool swap)
+{
+    float *f = (float *)s;
+    for (int k = 0; k < 16; ++k) {
+        if (!(fields & (1u << k))) continue;
+        if (swap) std::swap(f[k], *out);
+        else *out = f[k];
+        ++out;
+    }
+}
+
+// r * q for (w, x, y, z) quaternions
+static void quat_mul(const float r[4], const float q[4], float out[4])
+{
+    out[0] = r[0] * q[0] - r[1] * q[1] - r[2] * q[2] - r[3] * q[3];
+    out[1] = r[0] * q[1] + r[1] * q[0] + r[2] * q[3] - r[3] * q[2];
+    out[2] = r[0] * q[2] - r[1] * q[3] + r[2] * q[0] + r[3] * q[1];
+    out[3] = r[0] * q[3] + r[1] * q[2] - r[2] * q[1] + r[3] * q[0];
+}
+
+static void apply_one(const SplatEdit &e, const float rot[3][3], const float quat[4], GpuSplat *s)
+{
+    switch (e.op) {
+    case SPLAT_EDIT_DELETE:
+        s->opacity = s->color[3] = 0.0f;
+        break;
+    case SPLAT_EDIT_OPACITY:
+        s->opacity = s->color[3] = e.opacity;
+        break;
+    case SPLAT_EDIT_COLOR:
+        for (int k = 0; k < 3; ++k) s->color[k] = e.color[k];
+        break;
+    case SPLAT_EDIT_TRANSFORM: {
+        float d[3] = {s->position[0] - e.pivot[0], s->position[1] - e.pivot[1], s->position[2] - e.pivot[2]};
+        for (int r = 0; r < 3; ++r)
+            s->position[r] = e.pivot[r] + e.scale * (rot[r][0] * d[0] + rot[r][1] * d[1] + rot[r][2] * d[2]) +
+                             e.translate[r];
+        for (int k = 0; k < 3; ++k) s->scale[k] *= e.scale;
+        float q[4];
+        quat_mul(quat, s->rotation, q);
+        for (int k = 0; k < 4; ++k) s->rotation[k] = q[k];
+        break;
+    }
+    }
+}
+
+// Append the runs of consecutive indices in sorted `idx` as ranges.
+static void append_runs(const std::vector<uint32_t> &idx, std::vector<SplatRange> *dirty)
+{
+    for (size_t i = 0; i < idx.size();) {
+        size_t j = i + 1;
+        while (j < idx.size() && idx[j] == idx[j - 1] + 1) ++j;
+        dirty->push_back(SplatRange{idx[i], idx[j - 1] + 1});
+        i = j;
+    }
+}
+
+static bool valid(const SplatEdit &e, size_t count)
+{
+    if (op_fields(e.op) == 0 || (e.count > 0 && !e.indices)) return false;
+    if (e.op == SPLAT_EDIT_TRANSFORM && !(e.scale > 0.0f)) return false;
+    for (size_t i = 0; i < e.count; ++i)
+        if (e.indices[i] >= count) return false;
+    return true;
+}
+
+bool splat_edit_apply(GpuSplat *splats, size_t count, const SplatEdit *edits, size_t n, SplatEditStep *step,
+                      std::vector<SplatRange> *dirty)
+{
+    if (!splats || (n > 0 && !edits)) return false;
+    for (size_t i = 0; i < n; ++i)
+        if (!valid(edits[i], count)) return false;
+
+    if (step) *step = SplatEditStep();
+    for (size_t i = 0; i < n; ++i) {
+        const SplatEdit &e = edits[i];
+        if (e.count == 0) continue;
+        SplatDelta delta;
+        delta.fields = op_fields(e.op);
+        std::vector<uint32_t> &idx = delta.indices;
+        idx.assign(e.indices, e.indices + e.count);
+        std::sort(idx.begin(), idx.end());
+        idx.erase(std::unique(idx.begin(), idx.end()), idx.end());
+
+        // rotation matrix of the normalized quaternion, for positions
+        float quat[4];
+        float len = sqrtf(e.rotate[0] * e.rotate[0] + e.rotate[1] * e.rotate[1] + e.rotate[2] * e.rotate[2] +
+                          e.rotate[3] * e.rotate[3]);
+        for (int k = 0; k < 4; ++k) quat[k] = len > 0.0f ? e.rotate[k] / len : (k == 0 ? 1.0f : 0.0f);
+        float w = quat[0], x = quat[1], y = quat[2], z = quat[3];
+        float rot[3][3] = {
+            {1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - w * z), 2.0f * (x * z + w * y)},
+            {2.0f * (x * y + w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - w * x)},
+            {2.0f * (x * z - w * y), 2.0f * (y * z + w * x), 1.0f - 2.0f * (x * x + y * y)},
+        };
+
+        int nf = field_count(delta.fields);
+        if (step) delta.values.resize(idx.size() * nf);
+        float *values = delta.values.data();
+        parallel_for(idx.size(), k_grain, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                GpuSplat *s = &splats[idx[j]];
+                if (values) save_fields(s, delta.fields, values + j * nf, false);
+                apply_one(e, rot, quat, s);
+            }
+        });
+
+        if (dirty) append_runs(idx, dirty);
+        if (step) {
+            step->fields |= delta.fields;
+            step->deltas.push_back(std::move(delta));
+        }
+    }
+    return true;
+}
+
+void splat_edit_revert(GpuSplat *splats, SplatEditStep *step, std::vector<SplatRange> *dirty)
+{
+    if (!splats || !step) return;
+    // last applied first; the reversed list is the order to redo in
+    for (size_t i = step->deltas.size(); i-- > 0;) {
+        SplatDelta &d = step->deltas[i];
+        int nf = field_count(d.fields);
+        parallel_for(d.indices.size(), k_grain, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) save_fields(&splats[d.indices[j]], d.fields, &d.values[j * nf], true);
+        });
+        if (dirty) append_runs(d.indices, dirty);
+    }
+    std::reverse(step->deltas.begin(), step->deltas.end());
+}
+
+void splat_ranges_coalesce(std::vector<SplatRange> *ranges, uint32_t maxGap)
+{
+    if (!ranges || ranges->empty()) return;
+    std::vector<SplatRange> &r = *ranges;
+    std::sort(r.begin(), r.end(), [](const SplatRange &a, const SplatRange &b) { return a.begin < b.begin; });
+    size_t out = 0;
+    for (size_t i = 1; i < r.size(); ++i) {
+        if ((uint64_t)r[i].begin <= (uint64_t)r[out].end + maxGap) r[out].end = std::max(r[out].end, r[i].end);
+        else r[++out] = r[i];
+    }
+    r.resize(out + 1);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "splat.h"
+
+// Batched splat edits on a host copy of the scene.
+//
+// An edit applies one operation to a set of splat indices, on all cores.
+// Every batch reports the splat ranges it wrote, so the caller re-uploads
+// only those (merged when they lie close together), and records an undo
+// step holding just the fields each operation changed for just the splats
+// it touched, not a snapshot of the scene. Reverting a step swaps the
+// stored values with the current ones, which turns it into its redo step.
+
+enum SplatEditOp {
+    SPLAT_EDIT_DELETE = 0, // opacity to 0: culled everywhere, kept for undo
+    SPLAT_EDIT_COLOR,      // set the base color
+    SPLAT_EDIT_OPACITY,    // set the opacity
+    SPLAT_EDIT_TRANSFORM,  // p' = pivot + scale * rotate * (p - pivot) + translate
+};
+
+struct SplatEdit {
+    int op = SPLAT_EDIT_DELETE;
+    const uint32_t *indices = nullptr; // any order; duplicates are applied once
+    size_t count = 0;
+    float color[3] = {1.0f, 1.0f, 1.0f};
+    float opacity = 1.0f;
+    float translate[3] = {0.0f, 0.0f, 0.0f};
+    float rotate[4] = {1.0f, 0.0f, 0.0f, 0.0f}; // unit quaternion (w, x, y, z)
+    float scale = 1.0f;                          // uniform
+    float pivot[3] = {0.0f, 0.0f, 0.0f};
+};
+
+// Fields of GpuSplat as a mask over its 16 floats.
+enum SplatEditFields : uint16_t {
+    SPLAT_FIELD_POSITION = 0x0007,
+    SPLAT_FIELD_OPACITY = 0x8008, // opacity and the color alpha mirroring it
+    SPLAT_FIELD_SCALE = 0x0070,
+    SPLAT_FIELD_ROTATION = 0x0F00,
+    SPLAT_FIELD_COLOR = 0x7000,
+};
+
+// The previous values of the masked fields of the splats one edit touched,
+// indices ascending.
+struct SplatDelta {
+    uint16_t fields = 0;
+    std::vector<uint32_t> indices;
+    std::vector<float> values; // popcount(fields) floats per index
+};
+
+struct SplatEditStep {
+    std::vector<SplatDelta> deltas; // in the order they were applied
+    uint16_t fields = 0;            // union of the deltas' fields
+    size_t bytes() const;
+};
+
+// Splats [begin, end).
+struct SplatRange {
+    uint32_t begin, end;
+};
+
+// Apply `n` edits to `splats` (scene of `count`) in order. Appends the
+// written ranges to `dirty` and fills `step` (either may be null).
+// Returns false, changing nothing, if an edit is invalid or indexes past
+// the scene.
+bool splat_edit_apply(GpuSplat *splats, size_t count, const SplatEdit *edits, size_t n, SplatEditStep *step,
+                      std::vector<SplatRange> *dirty);
+
+// Undo `step` on `splats`, turning it into the step that redoes it.
+// Appends the written ranges to `dirty` (may be null).
+void splat_edit_revert(GpuSplat *splats, SplatEditStep *step, std::vector<SplatRange> *dirty);
+
+// Sort ranges and merge those that overlap or lie within `maxGap` splats
+// of each other: one upload per run of nearby edits instead of one per
+// range, at the cost of re-sending the unchanged splats in between.
+void splat_ranges_coalesce(std::vector<SplatRange> *ranges, uint32_t maxGap);
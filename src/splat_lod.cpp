@@ -0,0 +1,555 @@
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include "splat_lod.h"
+#include "depth_sort.h"
+#include "parallel.h"
+
+static const uint32_t k_leafSize = 8;     // leaves hold at most this many splats...
+static const int k_mortonLevels = 10;     // ...unless the octree is this deep already
+static const size_t k_grain = 1 << 12;
+
+static double ms_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ---------------------------------------------------------------------------
+// Build
+
+// 10 bits -> every third bit of 30
+static inline uint32_t spread_bits(uint32_t v)
+{
+    v &= 0x3FFu;
+    v = (v | (v << 16)) & 0x030000FFu;
+    v = (v | (v << 8)) & 0x0300F00Fu;
+    v = (v | (v << 4)) & 0x030C30C3u;
+    v = (v | (v << 2)) & 0x09249249u;
+    return v;
+}
+
+static inline uint32_t octant(uint32_t key, int level)
+{
+    return (key >> (3 * (k_mortonLevels - 1 - level))) & 7u;
+}
+
+typedef SplatLodMoments Moments;
+
+// Rotation matrix of a (w, x, y, z) quaternion, R[row][col].
+static void quat_to_rows(const float q[4], double R[3][3])
+{
+    double w = q[0], x = q[1], y = q[2], z = q[3];
+    R[0][0] = 1 - 2 * (y * y + z * z); R[0][1] = 2 * (x * y - w * z);     R[0][2] = 2 * (x * z + w * y);
+    R[1][0] = 2 * (x * y + w * z);     R[1][1] = 1 - 2 * (x * x + z * z); R[1][2] = 2 * (y * z - w * x);
+    R[2][0] = 2 * (x * z - w * y);     R[2][1] = 2 * (y * z + w * x);     R[2][2] = 1 - 2 * (x * x + y * y);
+}
+
+// Area-like size used for the weights, so flat splats still count.
+static inline double splat_area(double s0, double s1, double s2)
+{
+    return s0 * s1 + s1 * s2 + s2 * s0;
+}
+
+static void moments_from_splat(const GpuSplat &s, Moments *m)
+{
+    double R[3][3];
+    quat_to_rows(s.rotation, R);
+    double s2[3] = {(double)s.scale[0] * s.scale[0], (double)s.scale[1] * s.scale[1], (double)s.scale[2] * s.scale[2]};
+    double w = std::max((double)s.opacity * splat_area(s.scale[0], s.scale[1], s.scale[2]), 1e-20);
+    double p[3] = {s.position[0], s.position[1], s.position[2]};
+
+    static const int k_pairs[6][2] = {{0, 0}, {0, 1}, {0, 2}, {1, 1}, {1, 2}, {2, 2}};
+    for (int e = 0; e < 6; ++e) {
+        int a = k_pairs[e][0], b = k_pairs[e][1];
+        double cov = R[a][0] * s2[0] * R[b][0] + R[a][1] * s2[1] * R[b][1] + R[a][2] * s2[2] * R[b][2];
+        m->second[e] += w * (cov + p[a] * p[b]);
+    }
+    float extent = 3.0f * std::max(s.scale[0], std::max(s.scale[1], s.scale[2]));
+    for (int k = 0; k < 3; ++k) {
+        m->mean[k] += w * p[k];
+        m->color[k] += w * s.color[k];
+        m->lo[k] = std::min(m->lo[k], s.position[k] - extent);
+        m->hi[k] = std::max(m->hi[k], s.position[k] + extent);
+        m->centerLo[k] = std::min(m->centerLo[k], s.position[k]);
+        m->centerHi[k] = std::max(m->centerHi[k], s.position[k]);
+    }
+    m->w += w;
+}
+
+static void moments_clear(Moments *m)
+{
+    memset(m, 0, sizeof(*m));
+    for (int k = 0; k < 3; ++k) {
+        m->lo[k] = m->centerLo[k] = INFINITY;
+        m->hi[k] = m->centerHi[k] = -INFINITY;
+    }
+}
+
+static void moments_add(Moments *m, const Moments &o)
+{
+    m->w += o.w;
+    for (int k = 0; k < 3; ++k) {
+        m->mean[k] += o.mean[k];
+        m->color[k] += o.color[k];
+        m->lo[k] = std::min(m->lo[k], o.lo[k]);
+        m->hi[k] = std::max(m->hi[k], o.hi[k]);
+        m->centerLo[k] = std::min(m->centerLo[k], o.centerLo[k]);
+        m->centerHi[k] = std::max(m->centerHi[k], o.centerHi[k]);
+    }
+    for (int e = 0; e < 6; ++e) m->second[e] += o.second[e];
+}
+
+// Cyclic Jacobi on a symmetric 3x3 matrix: A = V diag(eval) V^T, with the
+// eigenvectors in the columns of V.
+static void eigen_symmetric(double A[3][3], double V[3][3], double eval[3])
+{
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c) V[r][c] = r == c ? 1.0 : 0.0;
+
+    for (int sweep = 0; sweep < 16; ++sweep) {
+        double off = A[0][1] * A[0][1] + A[0][2] * A[0][2] + A[1][2] * A[1][2];
+        double diag = A[0][0] * A[0][0] + A[1][1] * A[1][1] + A[2][2] * A[2][2];
+        if (off <= 1e-24 * diag) break;
+        for (int p = 0; p < 2; ++p) {
+            for (int q = p + 1; q < 3; ++q) {
+                if (A[p][q] == 0.0) continue;
+                double theta = (A[q][q] - A[p][p]) / (2.0 * A[p][q]);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+                for (int k = 0; k < 3; ++k) {
+                    double akp = A[k][p], akq = A[k][q];
+                    A[k][p] = c * akp - s * akq;
+                    A[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    double apk = A[p][k], aqk = A[q][k];
+                    A[p][k] = c * apk - s * aqk;
+                    A[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    double vkp = V[k][p], vkq = V[k][q];
+                    V[k][p] = c * vkp - s * vkq;
+                    V[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    for (int k = 0; k < 3; ++k) eval[k] = A[k][k];
+}
+
+// (w, x, y, z) quaternion of a rotation matrix R[row][col].
+static void rows_to_quat(const double R[3][3], float q[4])
+{
+    double w, x, y, z;
+    double trace = R[0][0] + R[1][1] + R[2][2];
+    if (trace > 0.0) {
+        double s = sqrt(trace + 1.0) * 2.0;
+        w = 0.25 * s;
+        x = (R[2][1] - R[1][2]) / s;
+        y = (R[0][2] - R[2][0]) / s;
+        z = (R[1][0] - R[0][1]) / s;
+    } else if (R[0][0] > R[1][1] && R[0][0] > R[2][2]) {
+        double s = sqrt(1.0 + R[0][0] - R[1][1] - R[2][2]) * 2.0;
+        w = (R[2][1] - R[1][2]) / s;
+        x = 0.25 * s;
+        y = (R[0][1] + R[1][0]) / s;
+        z = (R[0][2] + R[2][0]) / s;
+    } else if (R[1][1] > R[2][2]) {
+        double s = sqrt(1.0 + R[1][1] - R[0][0] - R[2][2]) * 2.0;
+        w = (R[0][2] - R[2][0]) / s;
+        x = (R[0][1] + R[1][0]) / s;
+        y = 0.25 * s;
+        z = (R[1][2] + R[2][1]) / s;
+    } else {
+        double s = sqrt(1.0 + R[2][2] - R[0][0] - R[1][1]) * 2.0;
+        w = (R[1][0] - R[0][1]) / s;
+        x = (R[0][2] + R[2][0]) / s;
+        y = (R[1][2] + R[2][1]) / s;
+        z = 0.25 * s;
+    }
+    double len = sqrt(w * w + x * x + y * y + z * z);
+    q[0] = (float)(w / len);
+    q[1] = (float)(x / len);
+    q[2] = (float)(y / len);
+    q[3] = (float)(z / len);
+}
+
+static void moments_to_splat(const Moments &m, GpuSplat *out)
+{
+    double mean[3] = {m.mean[0] / m.w, m.mean[1] / m.w, m.mean[2] / m.w};
+    double A[3][3];
+    A[0][0] = m.second[0] / m.w - mean[0] * mean[0];
+    A[0][1] = A[1][0] = m.second[1] / m.w - mean[0] * mean[1];
+    A[0][2] = A[2][0] = m.second[2] / m.w - mean[0] * mean[2];
+    A[1][1] = m.second[3] / m.w - mean[1] * mean[1];
+    A[1][2] = A[2][1] = m.second[4] / m.w - mean[1] * mean[2];
+    A[2][2] = m.second[5] / m.w - mean[2] * mean[2];
+
+    double V[3][3], eval[3];
+    eigen_symmetric(A, V, eval);
+    // a proper rotation: flip one axis of a reflection
+    double det = V[0][0] * (V[1][1] * V[2][2] - V[1][2] * V[2][1]) -
+                 V[0][1] * (V[1][0] * V[2][2] - V[1][2] * V[2][0]) +
+                 V[0][2] * (V[1][0] * V[2][1] - V[1][1] * V[2][0]);
+    if (det < 0.0)
+        for (int r = 0; r < 3; ++r) V[r][2] = -V[r][2];
+
+    double s[3];
+    for (int k = 0; k < 3; ++k) s[k] = sqrt(std::max(eval[k], 1e-14));
+
+    memset(out, 0, sizeof(*out));
+    for (int k = 0; k < 3; ++k) {
+        out->position[k] = (float)mean[k];
+        out->scale[k] = (float)s[k];
+        out->color[k] = (float)(m.color[k] / m.w);
+    }
+    rows_to_quat(V, out->rotation);
+    out->opacity = (float)std::min(1.0, m.w / splat_area(s[0], s[1], s[2]));
+    out->color[3] = out->opacity;
+}
+
+// Where a build reads the splats: an array, or a callback decoding them.
+struct Source {
+    const GpuSplat *splats;
+    const SplatLodFetch *fetch;
+
+    // splats [first, first + count), from the array or decoded into tmp
+    const GpuSplat *get(size_t first, size_t count, GpuSplat *tmp) const
+    {
+        if (splats) return splats + first;
+        (*fetch)(first, count, tmp);
+        return tmp;
+    }
+};
+
+static void leaf_moments(const SplatLod &lod, const Source &src, const SplatLodNode &node, Moments *m)
+{
+    moments_clear(m);
+    for (uint32_t j = 0; j < node.count; ++j) {
+        GpuSplat tmp;
+        moments_from_splat(*src.get(lod.indices[node.first + j], 1, &tmp), m);
+    }
+}
+
+// Bounds and coarse Gaussian of node n from its sums.
+static void finish_node(SplatLod *lod, uint32_t n, const Moments &m)
+{
+    SplatLodNode &node = lod->nodes[n];
+    for (int k = 0; k < 3; ++k) node.center[k] = 0.5f * (m.lo[k] + m.hi[k]);
+    float dx = m.hi[0] - m.lo[0], dy = m.hi[1] - m.lo[1], dz = m.hi[2] - m.lo[2];
+    node.radius = 0.5f * sqrtf(dx * dx + dy * dy + dz * dz);
+    dx = m.centerHi[0] - m.centerLo[0], dy = m.centerHi[1] - m.centerLo[1], dz = m.centerHi[2] - m.centerLo[2];
+    node.size = sqrtf(dx * dx + dy * dy + dz * dz);
+    moments_to_splat(m, &lod->coarse[n]);
+}
+
+// Fit inner node n from its children: leaf children are summed from their
+// splats and fitted here (each leaf has one parent), inner ones from their
+// kept sums, so those must be fitted already.
+static void fit_inner(SplatLod *lod, const Source &src, uint32_t n)
+{
+    const SplatLodNode &node = lod->nodes[n];
+    Moments m, child;
+    moments_clear(&m);
+    for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c) {
+        const SplatLodNode &cn = lod->nodes[c];
+        if (cn.childCount) {
+            moments_add(&m, lod->moments[cn.moments]);
+            continue;
+        }
+        leaf_moments(*lod, src, cn, &child);
+        finish_node(lod, c, child);
+        moments_add(&m, child);
+    }
+    lod->moments[node.moments] = m;
+    finish_node(lod, n, m);
+}
+
+// Fit a root with no children, in a scene of a few splats.
+static void fit_root_leaf(SplatLod *lod, const Source &src)
+{
+    Moments m;
+    leaf_moments(*lod, src, lod->nodes[0], &m);
+    finish_node(lod, 0, m);
+}
+
+static bool build(const Source &src, size_t count, SplatLod *lod)
+{
+    if (!lod || count == 0 || count >= 0xFFFFFFFFu) return false;
+    auto t0 = std::chrono::steady_clock::now();
+    *lod = SplatLod();
+    lod->splatCount = count;
+
+    // Morton keys over the centers' bounding cube: one pass over slices of
+    // the splats for the bounds, one for the keys
+    float lo[3] = {INFINITY, INFINITY, INFINITY}, hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    std::mutex boundsMutex;
+    parallel_for(count, k_grain, [&](size_t begin, size_t end) {
+        std::vector<GpuSplat> tmp(src.splats ? 0 : end - begin);
+        const GpuSplat *slice = src.get(begin, end - begin, tmp.data());
+        float clo[3] = {INFINITY, INFINITY, INFINITY}, chi[3] = {-INFINITY, -INFINITY, -INFINITY};
+        for (size_t i = 0; i < end - begin; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                clo[k] = std::min(clo[k], slice[i].position[k]);
+                chi[k] = std::max(chi[k], slice[i].position[k]);
+            }
+        }
+        std::lock_guard<std::mutex> lock(boundsMutex);
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = std::min(lo[k], clo[k]);
+            hi[k] = std::max(hi[k], chi[k]);
+        }
+    });
+    float side = std::max(hi[0] - lo[0], std::max(hi[1] - lo[1], hi[2] - lo[2]));
+    float cells = (float)(1 << k_mortonLevels);
+    float toCell = side > 0.0f ? (cells - 0.5f) / side : 0.0f;
+
+    std::vector<uint32_t> keys(count), keysTmp, indicesTmp;
+    lod->indices.resize(count);
+    uint32_t *keyOut = keys.data(), *indexOut = lod->indices.data();
+    parallel_for(count, k_grain, [&](size_t begin, size_t end) {
+        std::vector<GpuSplat> tmp(src.splats ? 0 : end - begin);
+        const GpuSplat *slice = src.get(begin, end - begin, tmp.data());
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t c[3];
+            for (int k = 0; k < 3; ++k) c[k] = (uint32_t)((slice[i - begin].position[k] - lo[k]) * toCell);
+            keyOut[i] = spread_bits(c[0]) | (spread_bits(c[1]) << 1) | (spread_bits(c[2]) << 2);
+            indexOut[i] = (uint32_t)i;
+        }
+    });
+    radix_sort_pairs(keys, lod->indices, keysTmp, indicesTmp);
+    std::vector<uint32_t>().swap(keysTmp);
+    std::vector<uint32_t>().swap(indicesTmp);
+
+    // top-down, one level at a time: children of a node are contiguous, and
+    // each level is a contiguous node range
+    std::vector<SplatLodNode> &nodes = lod->nodes;
+    std::vector<size_t> levelStart;
+    nodes.push_back(SplatLodNode());
+    nodes[0].count = (uint32_t)count;
+    nodes[0].parent = 0xFFFFFFFFu;
+    std::vector<uint32_t> splits; // 9 boundaries per node of the level
+    size_t levelBegin = 0, levelEnd = 1;
+    for (int level = 0; levelBegin < levelEnd; ++level) {
+        levelStart.push_back(levelBegin);
+        size_t n = levelEnd - levelBegin;
+        splits.assign(n * 9, 0);
+        parallel_for(n, k_grain, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                const SplatLodNode &node = nodes[levelBegin + i];
+                uint32_t *sp = &splits[i * 9];
+                sp[0] = node.first;
+                if (node.count <= k_leafSize || level >= k_mortonLevels) {
+                    for (int d = 1; d < 9; ++d) sp[d] = node.first;
+                    continue;
+                }
+                const uint32_t *kb = keys.data() + node.first, *ke = kb + node.count;
+                for (uint32_t d = 0; d < 8; ++d) {
+                    const uint32_t *p = std::partition_point(kb, ke, [&](uint32_t key) { return octant(key, level) <= d; });
+                    sp[d + 1] = (uint32_t)(p - keys.data());
+                }
+            }
+        });
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t *sp = &splits[i * 9];
+            if (sp[8] == sp[0]) continue; // leaf
+            size_t firstChild = nodes.size();
+            for (int d = 0; d < 8; ++d) {
+                if (sp[d + 1] == sp[d]) continue;
+                SplatLodNode child = SplatLodNode();
+                child.first = sp[d];
+                child.count = sp[d + 1] - sp[d];
+                child.parent = (uint32_t)(levelBegin + i);
+                nodes.push_back(child);
+            }
+            nodes[levelBegin + i].firstChild = (uint32_t)firstChild;
+            nodes[levelBegin + i].childCount = (uint32_t)(nodes.size() - firstChild);
+        }
+        levelBegin = levelEnd;
+        levelEnd = nodes.size();
+    }
+    std::vector<uint32_t>().swap(keys);
+    lod->depth = (int)levelStart.size();
+    levelStart.push_back(nodes.size());
+    lod->levels.assign(levelStart.begin(), levelStart.end());
+
+    // inner nodes keep their sums for refits; each leaf records its splats
+    size_t inner = 0;
+    for (SplatLodNode &node : nodes) node.moments = node.childCount ? (uint32_t)inner++ : 0xFFFFFFFFu;
+    lod->moments.resize(inner);
+    lod->leafOf.resize(count);
+    parallel_for(nodes.size(), k_grain, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            if (nodes[i].childCount) continue;
+            for (uint32_t j = 0; j < nodes[i].count; ++j) lod->leafOf[lod->indices[nodes[i].first + j]] = (uint32_t)i;
+        }
+    });
+
+    // moments bottom-up, one level at a time
+    lod->coarse.resize(nodes.size());
+    if (nodes[0].childCount == 0) fit_root_leaf(lod, src);
+    for (int level = lod->depth - 1; level >= 0; --level) {
+        size_t b0 = levelStart[level], n = levelStart[level + 1] - b0;
+        parallel_for(n, k_grain, [&](size_t b, size_t e) {
+            for (size_t i = b0 + b; i < b0 + e; ++i)
+                if (nodes[i].childCount) fit_inner(lod, src, (uint32_t)i);
+        });
+    }
+
+    lod->buildMs = ms_since(t0);
+    return true;
+}
+
+bool splat_lod_build(const GpuSplat *splats, size_t count, SplatLod *lod)
+{
+    return splats && build(Source{splats, nullptr}, count, lod);
+}
+
+bool splat_lod_build_from(const SplatLodFetch &fetch, size_t count, SplatLod *lod)
+{
+    return fetch && build(Source{nullptr, &fetch}, count, lod);
+}
+
+bool splat_lod_refit(SplatLod *lod, const GpuSplat *splats, const SplatRange *ranges, size_t rangeCount,
+                     std::vector<uint32_t> *changed)
+{
+    changed->clear();
+    if (!lod || !splats || lod->nodes.empty() || lod->leafOf.size() != lod->splatCount) return false;
+
+    // the leaves holding edited splats and every ancestor of them
+    std::vector<uint32_t> &dirty = *changed;
+    for (size_t r = 0; r < rangeCount; ++r) {
+        size_t end = std::min<size_t>(ranges[r].end, lod->splatCount);
+        for (size_t i = ranges[r].begin; i < end; ++i) dirty.push_back(lod->leafOf[i]);
+    }
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    size_t leaves = dirty.size();
+    for (size_t i = 0; i < leaves; ++i) {
+        for (uint32_t n = lod->nodes[dirty[i]].parent; n != 0xFFFFFFFFu; n = lod->nodes[n].parent) dirty.push_back(n);
+    }
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    if (dirty.empty()) return false;
+
+    Source src = {splats, nullptr};
+    if (lod->nodes[0].childCount == 0) fit_root_leaf(lod, src);
+    // deepest level first, so children are done before their parents; the
+    // edited leaves are fitted with their parents
+    for (int level = lod->depth - 1; level >= 0; --level) {
+        auto b0 = std::lower_bound(dirty.begin(), dirty.end(), lod->levels[level]);
+        auto e0 = std::lower_bound(b0, dirty.end(), lod->levels[level + 1]);
+        const uint32_t *list = dirty.data() + (b0 - dirty.begin());
+        parallel_for((size_t)(e0 - b0), 256, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+                if (lod->nodes[list[i]].childCount) fit_inner(lod, src, list[i]);
+        });
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Cut selection
+
+enum NodeAction { NODE_CULL, NODE_COARSE, NODE_SPLATS, NODE_REFINE };
+
+static NodeAction classify(const SplatLodNode &node, const float view[16], const SplatLodParams &params)
+{
+    const float *c = node.center;
+    float x = view[0] * c[0] + view[4] * c[1] + view[8] * c[2] + view[12];
+    float y = view[1] * c[0] + view[5] * c[1] + view[9] * c[2] + view[13];
+    float z = view[2] * c[0] + view[6] * c[1] + view[10] * c[2] + view[14];
+    float r = node.radius;
+
+    // sphere entirely behind the eye or outside a side plane
+    if (z > r) return NODE_CULL;
+    float tx = params.tanHalfFov[0], ty = params.tanHalfFov[1];
+    if ((fabsf(x) + z * tx) > r * sqrtf(1.0f + tx * tx)) return NODE_CULL;
+    if ((fabsf(y) + z * ty) > r * sqrtf(1.0f + ty * ty)) return NODE_CULL;
+
+    float d = -z;
+    if (d > r && node.size * params.focal < params.pixelSize * d) return NODE_COARSE;
+    return node.childCount == 0 ? NODE_SPLATS : NODE_REFINE;
+}
+
+struct CutPart {
+    std::vector<uint32_t> indices;
+    size_t coarse = 0, culled = 0;
+};
+
+// Append the action for one node to `out`; children to refine go to `stack`.
+static void visit(const SplatLod &lod, uint32_t n, const float view[16], const SplatLodParams &params,
+                  CutPart *out, std::vector<uint32_t> *stack)
+{
+    const SplatLodNode &node = lod.nodes[n];
+    switch (classify(node, view, params)) {
+    case NODE_CULL:
+        out->culled++;
+        break;
+    case NODE_COARSE:
+        out->indices.push_back((uint32_t)lod.splatCount + n);
+        out->coarse++;
+        break;
+    case NODE_SPLATS:
+        out->indices.insert(out->indices.end(), lod.indices.begin() + node.first,
+                            lod.indices.begin() + node.first + node.count);
+        break;
+    case NODE_REFINE:
+        for (uint32_t c = 0; c < node.childCount; ++c) stack->push_back(node.firstChild + c);
+        break;
+    }
+}
+
+void splat_lod_select(const SplatLod &lod, const float view[16], const SplatLodParams &params,
+                      std::vector<uint32_t> *cut, SplatLodCutStats *stats)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    cut->clear();
+    if (lod.nodes.empty()) return;
+
+    // breadth-first until there are enough subtrees to spread across threads
+    CutPart top;
+    std::vector<uint32_t> frontier(1, 0u), next;
+    size_t target = (size_t)parallel_thread_count() * 16;
+    while (!frontier.empty() && frontier.size() < target) {
+        next.clear();
+        for (uint32_t n : frontier) visit(lod, n, view, params, &top, &next);
+        frontier.swap(next);
+    }
+
+    std::vector<CutPart> parts(frontier.size());
+    parallel_for(frontier.size(), 1, [&](size_t b, size_t e) {
+        std::vector<uint32_t> stack;
+        for (size_t i = b; i < e; ++i) {
+            stack.assign(1, frontier[i]);
+            while (!stack.empty()) {
+                uint32_t n = stack.back();
+                stack.pop_back();
+                visit(lod, n, view, params, &parts[i], &stack);
+            }
+        }
+    });
+
+    size_t total = top.indices.size(), coarse = top.coarse, culled = top.culled;
+    std::vector<size_t> offsets(parts.size());
+    for (size_t i = 0; i < parts.size(); ++i) {
+        offsets[i] = total;
+        total += parts[i].indices.size();
+        coarse += parts[i].coarse;
+        culled += parts[i].culled;
+    }
+    cut->resize(total);
+    std::copy(top.indices.begin(), top.indices.end(), cut->begin());
+    parallel_for(parts.size(), 1, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) std::copy(parts[i].indices.begin(), parts[i].indices.end(), cut->begin() + offsets[i]);
+    });
+
+    if (stats) {
+        stats->splats = total;
+        stats->coarse = coarse;
+        stats->culled = culled;
+        stats->selectMs = ms_since(t0);
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "splat.h"
+#include "splat_edit.h"
+
+// Splat level of detail.
+//
+// An octree over splat centers (Morton order, built on all cores). Every
+// node also carries one coarse Gaussian that moment-matches the splats
+// below it: same weighted mean and covariance, base color averaged, and
+// opacity chosen to keep the total coverage. Each frame a cut is chosen by
+// projected node size: nodes smaller than a few pixels draw their coarse
+// Gaussian, larger leaves draw their original splats, and nodes outside the
+// view are skipped. The cut's size follows what is on screen, not the
+// scene size.
+//
+// Cut entries index a combined array: originals [0, splatCount) followed
+// by the coarse Gaussians, coarse[i] at splatCount + i.
+
+struct SplatLodNode {
+    float center[3];     // bounding sphere of the node's splats (3 sigma)
+    float radius;
+    float size;          // diagonal of the box around the splat centers: the
+                         // detail merging gives up
+    uint32_t firstChild; // children are contiguous in SplatLod::nodes
+    uint32_t childCount; // 0 for leaves
+    uint32_t first;      // the node's splats are indices[first, first + count)
+    uint32_t count;
+    uint32_t parent;     // UINT32_MAX for the root
+    uint32_t moments;    // inner nodes: their sums in SplatLod::moments
+};
+
+// Weighted sums over a node's splats. With w = opacity * area, the coarse
+// Gaussian takes the weighted mean and covariance (sum of each covariance
+// plus the spread of the means) and an opacity that keeps sum(w).
+struct SplatLodMoments {
+    double w;
+    double mean[3];   // sum w * mu
+    double second[6]; // sum w * (Sigma + mu mu^T): xx xy xz yy yz zz
+    double color[3];  // sum w * rgb
+    float lo[3], hi[3];        // splat extents (3 sigma)
+    float centerLo[3], centerHi[3];
+};
+
+struct SplatLod {
+    size_t splatCount = 0;
+    std::vector<SplatLodNode> nodes; // nodes[0] is the root
+    std::vector<uint32_t> indices;   // original splat indices in octree order
+    std::vector<GpuSplat> coarse;    // one per node
+    std::vector<uint32_t> leafOf;    // the leaf holding each original splat
+    std::vector<uint32_t> levels;    // first node of each level, then nodes.size()
+    // sums of the inner nodes, kept for splat_lod_refit; leaves hold few
+    // enough splats to sum again
+    std::vector<SplatLodMoments> moments;
+    int depth = 0;
+    double buildMs = 0.0;
+};
+
+// Build the hierarchy for `count` splats. Returns false for an empty scene
+// or one too large to index with 32 bits.
+bool splat_lod_build(const GpuSplat *splats, size_t count, SplatLod *lod);
+
+// Writes splats [first, first + count) to `out`; called from several
+// threads at once.
+typedef std::function<void(size_t first, size_t count, GpuSplat *out)> SplatLodFetch;
+
+// Build from splats decoded on demand, e.g. from a mapped scene file, so no
+// copy of the whole scene is held: the positions are read in slices, then
+// each leaf's splats one by one.
+bool splat_lod_build_from(const SplatLodFetch &fetch, size_t count, SplatLod *lod);
+
+// After edits to the splats in `ranges` (original indices), recompute the
+// coarse Gaussians and bounds of the leaves holding them and of their
+// ancestors, from the edited `splats`. The octree keeps its shape: splats
+// stay in their leaves even when they move away, and the node bounds follow
+// them. The nodes changed go to `changed`, ascending. Returns
+// false when nothing was refitted.
+bool splat_lod_refit(SplatLod *lod, const GpuSplat *splats, const SplatRange *ranges, size_t rangeCount,
+                     std::vector<uint32_t> *changed);
+
+struct SplatLodParams {
+    float focal = 1.0f;                  // pixels per world unit at distance 1
+    float tanHalfFov[2] = {1.0f, 1.0f};  // horizontal, vertical
+    float pixelSize = 2.0f;              // nodes below this on screen are merged
+};
+
+struct SplatLodCutStats {
+    size_t splats = 0;  // entries in the cut
+    size_t coarse = 0;  // of which merged Gaussians
+    size_t culled = 0;  // nodes skipped outside the view
+    double selectMs = 0.0;
+};
+
+// Choose the cut for a column-major view matrix and write its combined
+// indices to `cut` (in no particular order).
+void splat_lod_select(const SplatLod &lod, const float view[16], const SplatLodParams &params,
+                      std::vector<uint32_t> *cut, SplatLodCutStats *stats = nullptr);
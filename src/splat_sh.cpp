@@ -0,0 +1,145 @@
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include "splat_sh.h"
+#include "gpu_readback.h"
+#include "shader.h"
+
+// must match shaders/splat_sh.comp
+static const uint32_t k_groupSize = 256;
+
+static GLuint g_shProgram = 0;
+static GLint g_viewLoc = -1, g_projLoc = -1, g_eyeLoc = -1, g_degreeLoc = -1, g_strideLoc = -1;
+static GLint g_cosLoc = -1, g_countLoc = -1;
+
+static GpuReadback g_evaluatedReadback;
+
+size_t splat_sh_bytes(int degree)
+{
+    return degree > 0 ? (splat_sh_words(degree) + 1) * sizeof(uint32_t) : 0;
+}
+
+bool splat_sh_alloc(SplatShBuffers *b, size_t count, int degree)
+{
+    if (!b || count == 0 || degree < 1 || degree > SPLAT_MAX_SH_DEGREE) return false;
+    splat_sh_free(b);
+    uint32_t zero = 0;
+    b->coeffs = ssbo_alloc(count * splat_sh_words(degree) * sizeof(uint32_t));
+    b->directions = ssbo_alloc(count * sizeof(uint32_t));
+    b->evaluated = ssbo_alloc(sizeof(uint32_t), &zero);
+    if (!b->coeffs || !b->directions || !b->evaluated) {
+        fprintf(stderr, "splat_sh: no GPU memory for SH degree %d over %zu splats\n", degree, count);
+        splat_sh_free(b);
+        return false;
+    }
+    b->count = count;
+    b->degree = degree;
+    splat_sh_invalidate(*b, 0, count);
+    return true;
+}
+
+void splat_sh_free(SplatShBuffers *b)
+{
+    if (!b) return;
+    ssbo_free(b->coeffs);
+    ssbo_free(b->directions);
+    ssbo_free(b->evaluated);
+    *b = SplatShBuffers();
+}
+
+void splat_sh_upload(const SplatShBuffers &b, size_t first, size_t count, const uint32_t *words)
+{
+    if (!b.coeffs || first + count > b.count) return;
+    size_t stride = splat_sh_words(b.degree) * sizeof(uint32_t);
+    ssbo_update(b.coeffs, first * stride, words, count * stride);
+    splat_sh_invalidate(b, first, count);
+}
+
+void splat_sh_invalidate(const SplatShBuffers &b, size_t first, size_t count)
+{
+    if (!b.directions || first >= b.count) return;
+    count = std::min(count, b.count - first);
+    uint32_t zero = 0;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ssbo_buffer(b.directions));
+    glClearBufferSubData(GL_COPY_WRITE_BUFFER, GL_R32UI,
+                         (GLintptr)(ssbo_offset(b.directions) + first * sizeof(uint32_t)),
+                         (GLsizeiptr)(count * sizeof(uint32_t)), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+static void locate_uniforms()
+{
+    g_viewLoc = glGetUniformLocation(g_shProgram, "uView");
+    g_projLoc = glGetUniformLocation(g_shProgram, "uProj");
+    g_eyeLoc = glGetUniformLocation(g_shProgram, "uEye");
+    g_degreeLoc = glGetUniformLocation(g_shProgram, "uDegree");
+    g_strideLoc = glGetUniformLocation(g_shProgram, "uStride");
+    g_cosLoc = glGetUniformLocation(g_shProgram, "uCosThreshold");
+    g_countLoc = glGetUniformLocation(g_shProgram, "uCount");
+}
+
+bool splat_sh_init()
+{
+    g_shProgram = shader_begin_compute("shaders/splat_sh.comp");
+    if (!shader_finish(&g_shProgram)) {
+        fprintf(stderr, "splat_sh: failed to build the SH program\n");
+        return false;
+    }
+    locate_uniforms();
+    shader_watch(&g_shProgram, locate_uniforms);
+
+    if (!gpu_readback_init(&g_evaluatedReadback))
+        fprintf(stderr, "splat_sh: no readback buffer, evaluated counts unavailable\n");
+    return true;
+}
+
+void splat_sh_run(const SplatShBuffers &b, SsboHandle splats, SsboHandle packed, size_t count,
+                  const SplatShParams &params)
+{
+    int degree = std::min(params.degree, b.degree);
+    if (!g_shProgram || !b.coeffs || degree < 1 || count == 0) return;
+    count = std::min(count, b.count);
+
+    const float *v = params.view;
+    float eye[3];
+    for (int k = 0; k < 3; ++k) eye[k] = -(v[k * 4] * v[12] + v[k * 4 + 1] * v[13] + v[k * 4 + 2] * v[14]);
+    // cosines never exceed 1, so 2 re-evaluates every splat in view
+    float cosThreshold = params.angleDeg > 0.0f ? cosf(params.angleDeg * 3.14159265f / 180.0f) : 2.0f;
+
+    uint32_t zero = 0;
+    ssbo_update(b.evaluated, 0, &zero, sizeof(zero));
+    glUseProgram(g_shProgram);
+    glUniformMatrix4fv(g_viewLoc, 1, GL_FALSE, params.view);
+    glUniformMatrix4fv(g_projLoc, 1, GL_FALSE, params.proj);
+    glUniform3f(g_eyeLoc, eye[0], eye[1], eye[2]);
+    glUniform1ui(g_degreeLoc, (GLuint)degree);
+    glUniform1ui(g_strideLoc, splat_sh_words(b.degree));
+    glUniform1f(g_cosLoc, cosThreshold);
+    glUniform1ui(g_countLoc, (GLuint)count);
+    ssbo_bind(splats, 0);
+    ssbo_bind(b.coeffs, 3);
+    ssbo_bind(b.directions, 4);
+    ssbo_bind(packed, 6);
+    ssbo_bind(b.evaluated, 7);
+    glDispatchCompute(std::min<uint32_t>((uint32_t)((count + k_groupSize - 1) / k_groupSize), 65535u), 1, 1);
+    glUseProgram(0);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // the count for splat_sh_poll_evaluated
+    gpu_readback_copy(&g_evaluatedReadback, b.evaluated, 0);
+}
+
+bool splat_sh_poll_evaluated(size_t *evaluated)
+{
+    return gpu_readback_poll(&g_evaluatedReadback, evaluated);
+}
+
+void splat_sh_shutdown()
+{
+    gpu_readback_shutdown(&g_evaluatedReadback);
+    if (g_shProgram) { glDeleteProgram(g_shProgram); g_shProgram = 0; }
+}
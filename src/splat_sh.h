@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ssbo.h"
+#include "splat.h"
+
+// View-dependent splat color on the GPU.
+//
+// The higher SH bands of each splat stay on the GPU as half floats
+// (splat_sh_pack). A compute pass evaluates them once per splat, rather
+// than for every corner of its quad, and writes the clamped color into the
+// packed splat's color word, so the raster, tile and cull passes need no
+// SH of their own. Each splat keeps the view direction it was last
+// evaluated for and is skipped while the camera stays within an angular
+// threshold of it; splats out of view wait until they come into view.
+// Rewriting a splat's packed copy (pack_splats) resets it to its band-0
+// color, so the caller marks those splats stale with splat_sh_invalidate.
+
+struct SplatShBuffers {
+    size_t count = 0;
+    int degree = 0;            // bands stored (1..3)
+    SsboHandle coeffs = 0;     // splat_sh_words(degree) words per splat
+    SsboHandle directions = 0; // uint32 per splat, 0 when stale
+    SsboHandle evaluated = 0;  // uint32 counter of the last run
+};
+
+// GPU bytes per splat for SH of `degree` (0 for none).
+size_t splat_sh_bytes(int degree);
+
+// Allocate buffers for `count` splats with bands 1..degree, every splat
+// stale. Returns false (and logs) when out of memory.
+bool splat_sh_alloc(SplatShBuffers *buffers, size_t count, int degree);
+void splat_sh_free(SplatShBuffers *buffers);
+
+// Upload the SH of splats [first, first + count), already packed, and mark
+// them stale.
+void splat_sh_upload(const SplatShBuffers &buffers, size_t first, size_t count, const uint32_t *words);
+
+// Mark splats [first, first + count) for evaluation in the next run.
+void splat_sh_invalidate(const SplatShBuffers &buffers, size_t first, size_t count);
+
+// Compile the SH program. Returns false if it fails to build.
+bool splat_sh_init();
+
+struct SplatShParams {
+    float view[16], proj[16]; // column-major
+    int degree = 3;           // bands to evaluate, at most the buffers' degree
+    float angleDeg = 1.0f;    // reuse a splat's color within this view angle (0: never)
+};
+
+// Evaluate the stale splats in view among the first `count` GpuSplats of
+// `splats` into `packed` (PackedSplats). Issues the barrier the draw needs.
+void splat_sh_run(const SplatShBuffers &buffers, SsboHandle splats, SsboHandle packed, size_t count,
+                  const SplatShParams &params);
+
+// Splats evaluated by the newest run the GPU has finished, read without
+// waiting for it. Returns false while none has finished since the last call.
+bool splat_sh_poll_evaluated(size_t *evaluated);
+
+void splat_sh_shutdown();
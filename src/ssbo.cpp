@@ -3,56 +3,430 @@
 #endif
 #include <glad/glad.h>
 #include <stdio.h>
+#include <string.h>
+#include <vector>
 #include "ssbo.h"
 
-static GLuint g_ssbo = 0;
-static size_t g_ssbo_size = 0;
+// shared arenas are this big; anything over a quarter of it gets its own
+static const size_t k_arenaSize = (size_t)32 << 20;
+static const size_t k_dedicatedThreshold = k_arenaSize / 4;
 
-bool ssbo_create_from_data(const void* data, size_t byteSize)
+// handle = (generation << 20) | (slot + 1)
+static const uint32_t k_slotBits = 20;
+static const uint32_t k_slotMask = (1u << k_slotBits) - 1;
+
+struct FreeRange {
+    size_t offset, size;
+};
+
+struct Arena {
+    GLuint buffer = 0; // 0: unused entry
+    size_t size = 0;
+    size_t used = 0;
+    bool dedicated = false;
+    SsboHandle mapped = 0;
+    std::vector<FreeRange> free; // sorted by offset, coalesced
+};
+
+struct Slot {
+    uint32_t arena = 0;
+    size_t offset = 0;
+    size_t size = 0;     // requested bytes
+    size_t reserved = 0; // aligned bytes taken from the arena
+    uint32_t generation = 0;
+    bool live = false;
+};
+
+struct BoundRange {
+    GLuint buffer;
+    size_t offset, size;
+};
+
+static std::vector<Arena> g_arenas;
+static std::vector<Slot> g_slots;
+static std::vector<uint32_t> g_freeSlots;
+static size_t g_alignment = 0;
+
+// last range bound to each indexed binding, to skip redundant binds
+static const uint32_t k_cachedBindings = 16;
+static BoundRange g_bound[k_cachedBindings];
+
+size_t ssbo_offset_alignment()
 {
-    if (g_ssbo != 0) return false;
-    if (!data || byteSize == 0) return false;
+    if (g_alignment == 0) {
+        GLint align = 0;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &align);
+        g_alignment = align > 0 ? (size_t)align : 256;
+    }
+    return g_alignment;
+}
 
-    glGenBuffers(1, &g_ssbo);
-    if (g_ssbo == 0) {
+static size_t align_up(size_t v, size_t a)
+{
+    return (v + a - 1) / a * a;
+}
+
+static Slot *get_slot(SsboHandle handle)
+{
+    uint32_t index = handle & k_slotMask;
+    if (index == 0 || index > g_slots.size()) return nullptr;
+    Slot &s = g_slots[index - 1];
+    if (!s.live || s.generation != (handle >> k_slotBits)) return nullptr;
+    return &s;
+}
+
+static void forget_bindings(GLuint buffer)
+{
+    for (uint32_t i = 0; i < k_cachedBindings; ++i)
+        if (g_bound[i].buffer == buffer) g_bound[i] = BoundRange();
+}
+
+static uint32_t create_arena(size_t size, bool dedicated)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    if (buffer == 0) {
         fprintf(stderr, "ssbo: glGenBuffers failed\n");
-        return false;
+        return UINT32_MAX;
     }
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_ssbo);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)byteSize, data, GL_DYNAMIC_DRAW);
+    // errors left behind by unrelated calls must not fail this allocation
+    // (bounded: a lost context can keep reporting one)
+    for (int i = 0; i < 16 && glGetError() != GL_NO_ERROR; ++i) {}
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)size, NULL, GL_DYNAMIC_STORAGE_BIT | GL_MAP_WRITE_BIT);
+    GLint64 allocated = 0;
+    glGetBufferParameteri64v(GL_SHADER_STORAGE_BUFFER, GL_BUFFER_SIZE, &allocated);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    if (glGetError() != GL_NO_ERROR || allocated != (GLint64)size) {
+        fprintf(stderr, "ssbo: failed to allocate a %zu byte buffer\n", size);
+        glDeleteBuffers(1, &buffer);
+        return UINT32_MAX;
+    }
+
+    uint32_t index = 0;
+    while (index < g_arenas.size() && g_arenas[index].buffer != 0) ++index;
+    if (index == g_arenas.size()) g_arenas.emplace_back();
+
+    Arena &a = g_arenas[index];
+    a = Arena();
+    a.buffer = buffer;
+    a.size = size;
+    a.dedicated = dedicated;
+    a.free.push_back(FreeRange{0, size});
+    return index;
+}
 
-    g_ssbo_size = byteSize;
+static void destroy_arena(Arena &a)
+{
+    forget_bindings(a.buffer);
+    glDeleteBuffers(1, &a.buffer);
+    a = Arena();
+}
+
+// Best-fit search of an arena's free list. Returns the range index or -1.
+static int find_fit(const Arena &a, size_t bytes)
+{
+    int best = -1;
+    for (size_t i = 0; i < a.free.size(); ++i) {
+        if (a.free[i].size >= bytes && (best < 0 || a.free[i].size < a.free[best].size))
+            best = (int)i;
+    }
+    return best;
+}
+
+static void take_range(Arena &a, int rangeIndex, size_t bytes)
+{
+    FreeRange &r = a.free[rangeIndex];
+    r.offset += bytes;
+    r.size -= bytes;
+    if (r.size == 0) a.free.erase(a.free.begin() + rangeIndex);
+    a.used += bytes;
+}
+
+static void return_range(Arena &a, size_t offset, size_t bytes)
+{
+    size_t i = 0;
+    while (i < a.free.size() && a.free[i].offset < offset) ++i;
+    a.free.insert(a.free.begin() + i, FreeRange{offset, bytes});
+    // merge with the next, then the previous neighbour
+    if (i + 1 < a.free.size() && a.free[i].offset + a.free[i].size == a.free[i + 1].offset) {
+        a.free[i].size += a.free[i + 1].size;
+        a.free.erase(a.free.begin() + i + 1);
+    }
+    if (i > 0 && a.free[i - 1].offset + a.free[i - 1].size == a.free[i].offset) {
+        a.free[i - 1].size += a.free[i].size;
+        a.free.erase(a.free.begin() + i);
+    }
+    a.used -= bytes;
+}
+
+// Find room for `reserved` aligned bytes, creating an arena if needed.
+static bool place(size_t reserved, uint32_t *arenaOut, size_t *offsetOut)
+{
+    if (reserved <= k_dedicatedThreshold) {
+        for (uint32_t i = 0; i < g_arenas.size(); ++i) {
+            Arena &a = g_arenas[i];
+            if (a.buffer == 0 || a.dedicated) continue;
+            int r = find_fit(a, reserved);
+            if (r < 0) continue;
+            *arenaOut = i;
+            *offsetOut = a.free[r].offset;
+            take_range(a, r, reserved);
+            return true;
+        }
+    }
+
+    bool dedicated = reserved > k_dedicatedThreshold;
+    uint32_t index = create_arena(dedicated ? reserved : k_arenaSize, dedicated);
+    if (index == UINT32_MAX) return false;
+    *arenaOut = index;
+    *offsetOut = 0;
+    take_range(g_arenas[index], 0, reserved);
     return true;
 }
 
-void ssbo_update(const void* data, size_t byteSize)
+static void release(uint32_t arenaIndex, size_t offset, size_t reserved)
 {
-    if (g_ssbo == 0 || data == nullptr || byteSize == 0) return;
-    if (byteSize > g_ssbo_size) byteSize = g_ssbo_size;
+    Arena &a = g_arenas[arenaIndex];
+    return_range(a, offset, reserved);
+    if (a.used == 0) destroy_arena(a);
+}
+
+SsboHandle ssbo_alloc(size_t byteSize, const void *data)
+{
+    if (byteSize == 0) return 0;
+
+    size_t reserved = align_up(byteSize, ssbo_offset_alignment());
+    uint32_t arena;
+    size_t offset;
+    if (!place(reserved, &arena, &offset)) return 0;
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_ssbo);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)byteSize, data);
+    uint32_t index;
+    if (!g_freeSlots.empty()) {
+        index = g_freeSlots.back();
+        g_freeSlots.pop_back();
+    } else {
+        if (g_slots.size() >= k_slotMask) {
+            fprintf(stderr, "ssbo: out of handles\n");
+            release(arena, offset, reserved);
+            return 0;
+        }
+        index = (uint32_t)g_slots.size();
+        g_slots.emplace_back();
+    }
+
+    Slot &s = g_slots[index];
+    s.arena = arena;
+    s.offset = offset;
+    s.size = byteSize;
+    s.reserved = reserved;
+    s.generation = (s.generation + 1) & (0xFFFFFFFFu >> k_slotBits);
+    s.live = true;
+    SsboHandle handle = (s.generation << k_slotBits) | (index + 1);
+
+    if (data) ssbo_update(handle, 0, data, byteSize);
+    return handle;
+}
+
+void ssbo_free(SsboHandle handle)
+{
+    Slot *s = get_slot(handle);
+    if (!s) return;
+    if (g_arenas[s->arena].mapped == handle) ssbo_unmap(handle);
+    release(s->arena, s->offset, s->reserved);
+    s->live = false;
+    g_freeSlots.push_back((handle & k_slotMask) - 1);
+}
+
+bool ssbo_resize(SsboHandle handle, size_t byteSize)
+{
+    Slot *s = get_slot(handle);
+    if (!s || byteSize == 0) return false;
+    Arena &a = g_arenas[s->arena];
+    if (a.mapped == handle) {
+        fprintf(stderr, "ssbo: cannot resize a mapped buffer\n");
+        return false;
+    }
+
+    size_t reserved = align_up(byteSize, ssbo_offset_alignment());
+    bool wrongKind = a.dedicated != (reserved > k_dedicatedThreshold);
+
+    // shrink in place (a dedicated arena is only kept while at least half used)
+    if (reserved <= s->reserved && !wrongKind && (!a.dedicated || reserved * 2 >= a.size)) {
+        if (reserved < s->reserved) return_range(a, s->offset + reserved, s->reserved - reserved);
+        s->size = byteSize;
+        s->reserved = reserved;
+        return true;
+    }
+
+    // grow in place into a free range right after the allocation
+    if (reserved > s->reserved && !wrongKind) {
+        size_t end = s->offset + s->reserved;
+        for (size_t i = 0; i < a.free.size(); ++i) {
+            if (a.free[i].offset != end) continue;
+            size_t extra = reserved - s->reserved;
+            if (a.free[i].size >= extra) {
+                take_range(a, (int)i, extra);
+                s->size = byteSize;
+                s->reserved = reserved;
+                return true;
+            }
+            break;
+        }
+    }
+
+    // move: new space, GPU-side copy of the kept bytes, release the old space
+    // (`a` is not used past this point: place() may grow the arena list)
+    uint32_t newArena;
+    size_t newOffset;
+    if (!place(reserved, &newArena, &newOffset)) return false;
+    size_t keep = byteSize < s->size ? byteSize : s->size;
+    glBindBuffer(GL_COPY_READ_BUFFER, g_arenas[s->arena].buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, g_arenas[newArena].buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)s->offset, (GLintptr)newOffset,
+                        (GLsizeiptr)keep);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    release(s->arena, s->offset, s->reserved);
+
+    s->arena = newArena;
+    s->offset = newOffset;
+    s->size = byteSize;
+    s->reserved = reserved;
+    return true;
+}
+
+void *ssbo_map(SsboHandle handle)
+{
+    Slot *s = get_slot(handle);
+    if (!s) return nullptr;
+    Arena &a = g_arenas[s->arena];
+    if (a.mapped != 0) {
+        fprintf(stderr, "ssbo: another buffer in this arena is already mapped\n");
+        return nullptr;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, a.buffer);
+    void *ptr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, (GLintptr)s->offset, (GLsizeiptr)s->size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    if (!ptr) {
+        fprintf(stderr, "ssbo: glMapBufferRange failed for %zu bytes\n", s->size);
+        return nullptr;
+    }
+    a.mapped = handle;
+    return ptr;
+}
+
+bool ssbo_unmap(SsboHandle handle)
+{
+    Slot *s = get_slot(handle);
+    if (!s || g_arenas[s->arena].mapped != handle) return false;
+    Arena &a = g_arenas[s->arena];
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, a.buffer);
+    GLboolean ok = glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    a.mapped = 0;
+    if (!ok) fprintf(stderr, "ssbo: buffer contents lost while mapped\n");
+    return ok == GL_TRUE;
+}
+
+void ssbo_update(SsboHandle handle, size_t offset, const void* data, size_t byteSize)
+{
+    Slot *s = get_slot(handle);
+    if (!s || data == nullptr || byteSize == 0 || offset >= s->size) return;
+    if (byteSize > s->size - offset) byteSize = s->size - offset;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_arenas[s->arena].buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)(s->offset + offset), (GLsizeiptr)byteSize, data);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
-void ssbo_bind_base(uint32_t binding)
+void ssbo_read(SsboHandle handle, size_t offset, void* out, size_t byteSize)
+{
+    Slot *s = get_slot(handle);
+    if (!s || out == nullptr || byteSize == 0 || offset >= s->size) return;
+    if (byteSize > s->size - offset) byteSize = s->size - offset;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_arenas[s->arena].buffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)(s->offset + offset), (GLsizeiptr)byteSize, out);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ssbo_bind(SsboHandle handle, uint32_t binding)
+{
+    ssbo_bind_range(handle, binding, 0, ssbo_size(handle));
+}
+
+void ssbo_bind_range(SsboHandle handle, uint32_t binding, size_t offset, size_t byteSize)
+{
+    Slot *s = get_slot(handle);
+    if (!s || byteSize == 0 || offset + byteSize > s->size) return;
+
+    GLuint buffer = g_arenas[s->arena].buffer;
+    size_t start = s->offset + offset;
+    if (binding < k_cachedBindings) {
+        BoundRange &b = g_bound[binding];
+        if (b.buffer == buffer && b.offset == start && b.size == byteSize) return;
+        b = BoundRange{buffer, start, byteSize};
+    }
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, (GLuint)binding, buffer, (GLintptr)start, (GLsizeiptr)byteSize);
+}
+
+size_t ssbo_size(SsboHandle handle)
+{
+    Slot *s = get_slot(handle);
+    return s ? s->size : 0;
+}
+
+uint32_t ssbo_buffer(SsboHandle handle)
 {
-    if (g_ssbo == 0) return;
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, (GLuint)binding, g_ssbo);
+    Slot *s = get_slot(handle);
+    return s ? (uint32_t)g_arenas[s->arena].buffer : 0;
 }
 
-uint32_t ssbo_get_buffer()
+size_t ssbo_offset(SsboHandle handle)
 {
-    return (uint32_t)g_ssbo;
+    Slot *s = get_slot(handle);
+    return s ? s->offset : 0;
 }
 
-void ssbo_destroy()
+SsboStats ssbo_stats()
 {
-    if (g_ssbo) {
-        glDeleteBuffers(1, &g_ssbo);
-        g_ssbo = 0;
-        g_ssbo_size = 0;
+    SsboStats st;
+    for (const Arena &a : g_arenas) {
+        if (a.buffer == 0) continue;
+        ++st.arenas;
+        st.reservedBytes += a.size;
+        st.usedBytes += a.used;
     }
-}
\ No newline at end of file
+    for (const Slot &s : g_slots)
+        if (s.live) ++st.allocations;
+    return st;
+}
+
+void ssbo_shutdown()
+{
+    for (Arena &a : g_arenas) {
+        if (a.buffer == 0) continue;
+        if (a.mapped) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, a.buffer);
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+        destroy_arena(a);
+    }
+    g_arenas.clear();
+    // keep generations so stale handles from before the shutdown stay invalid
+    for (uint32_t i = 0; i < g_slots.size(); ++i) {
+        if (g_slots[i].live) {
+            g_slots[i].live = false;
+            g_freeSlots.push_back(i);
+        }
+    }
+    memset(g_bound, 0, sizeof(g_bound));
+}
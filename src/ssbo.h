@@ -2,17 +2,74 @@
 #include <cstddef>
 #include <cstdint>
 
-// Create an SSBO from initial data. Returns true on success.
-bool ssbo_create_from_data(const void *data, size_t byteSize);
+// Shader storage buffers, handed out as handles to sub-allocations of a few
+// large GL buffers ("arenas"). Offsets honour
+// GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, so any allocation can be bound
+// with glBindBufferRange. Allocations up to 8 MB share 32 MB arenas;
+// larger ones get an arena of their own. Freed space is coalesced and empty
+// arenas are released, so loading one scene after another does not
+// fragment memory.
+// All functions must be called on the GL thread.
 
-// Update entire SSBO contents. byteSize must be <= original size.
-void ssbo_update(const void *data, size_t byteSize);
+// 0 is never a valid handle.
+typedef uint32_t SsboHandle;
 
-// Bind SSBO to a shader storage binding point.
-void ssbo_bind_base(uint32_t binding);
+// Allocate byteSize bytes, optionally filled from `data`. Returns 0 on failure.
+SsboHandle ssbo_alloc(size_t byteSize, const void *data = nullptr);
 
-// Get underlying buffer handle (0 if none).
-uint32_t ssbo_get_buffer();
+// Release an allocation (0 is ignored).
+void ssbo_free(SsboHandle handle);
 
-// Destroy SSBO and free resources.
-void ssbo_destroy();
\ No newline at end of file
+// Grow or shrink an allocation, keeping the first min(old, new) bytes. The
+// handle stays valid; its buffer and offset may change. Grows in place when
+// the space after it is free.
+bool ssbo_resize(SsboHandle handle, size_t byteSize);
+
+// Map an allocation for writing (contents are discarded), so callers can
+// fill it in place from any thread without a staging copy. Only one
+// allocation per arena can be mapped at a time, and allocations up to
+// 8 MB share arenas with unrelated ones: while any buffer is mapped,
+// mapping another small one may fail. Unmap first, or fill the second with
+// ssbo_update. Returns nullptr on failure.
+void *ssbo_map(SsboHandle handle);
+
+// Unmap a mapped allocation. Returns false if the driver reports the
+// contents were lost while mapped.
+bool ssbo_unmap(SsboHandle handle);
+
+// Update bytes [offset, offset + byteSize) of an allocation (clamped to its size).
+void ssbo_update(SsboHandle handle, size_t offset, const void *data, size_t byteSize);
+
+// Read bytes [offset, offset + byteSize) back into `out` (clamped to the
+// allocation). Stalls until the GPU is done writing them.
+void ssbo_read(SsboHandle handle, size_t offset, void *out, size_t byteSize);
+
+// Bind a whole allocation to a shader storage binding point.
+void ssbo_bind(SsboHandle handle, uint32_t binding);
+
+// Bind bytes [offset, offset + byteSize) of an allocation. `offset` must be
+// a multiple of ssbo_offset_alignment(). Rebinding the same range is free.
+void ssbo_bind_range(SsboHandle handle, uint32_t binding, size_t offset, size_t byteSize);
+
+// Size in bytes of an allocation (0 for an invalid handle).
+size_t ssbo_size(SsboHandle handle);
+
+// GL buffer and byte offset backing an allocation, for GL calls that take a
+// buffer directly (copies, indirect draws). Valid until the next resize.
+uint32_t ssbo_buffer(SsboHandle handle);
+size_t ssbo_offset(SsboHandle handle);
+
+// GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT.
+size_t ssbo_offset_alignment();
+
+struct SsboStats {
+    size_t arenas = 0;        // GL buffers
+    size_t allocations = 0;
+    size_t reservedBytes = 0; // sum of arena sizes
+    size_t usedBytes = 0;     // sum of aligned allocation sizes
+};
+
+SsboStats ssbo_stats();
+
+// Release every allocation and arena.
+void ssbo_shutdown();
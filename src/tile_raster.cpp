@@ -0,0 +1,247 @@
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include <stdio.h>
+#include <algorithm>
+#include "tile_raster.h"
+#include "gpu_sort.h"
+#include "shader.h"
+#include "profiler.h"
+
+// must match the compute shaders
+static const int k_tileSize = 16;
+static const uint32_t k_groupSize = 256;
+
+static GLuint g_preprocessProgram = 0, g_duplicateProgram = 0, g_rangesProgram = 0, g_renderProgram = 0;
+static GLint g_preViewLoc = -1, g_preProjLoc = -1, g_preViewportLoc = -1, g_preFocalLoc = -1;
+static GLint g_preScaleLoc = -1, g_preTilesLoc = -1, g_preCountLoc = -1;
+static GLint g_dupTilesLoc = -1, g_dupCountLoc = -1;
+static GLint g_rangesCountLoc = -1;
+static GLint g_renderTilesLoc = -1, g_renderSizeLoc = -1;
+
+static GLuint g_texture = 0;
+static int g_width = 0, g_height = 0;
+
+// per-splat: projected entries and tile counts (scanned in place to offsets)
+static SsboHandle g_projected = 0, g_tileOffsets = 0;
+static size_t g_splatCapacity = 0;
+// per-instance keys/values and the sort scratch sized for them
+static SsboHandle g_instanceKeys = 0, g_instanceValues = 0;
+static GpuSortBuffers g_sortBuffers;
+static size_t g_instanceCapacity = 0;
+static SsboHandle g_tileRanges = 0;
+
+static TileRasterStats g_stats;
+
+static GLuint groups_for(size_t count)
+{
+    return (GLuint)std::min<size_t>((count + k_groupSize - 1) / k_groupSize, 65535);
+}
+
+static void locate_uniforms()
+{
+    g_preViewLoc = glGetUniformLocation(g_preprocessProgram, "uView");
+    g_preProjLoc = glGetUniformLocation(g_preprocessProgram, "uProj");
+    g_preViewportLoc = glGetUniformLocation(g_preprocessProgram, "uViewport");
+    g_preFocalLoc = glGetUniformLocation(g_preprocessProgram, "uFocal");
+    g_preScaleLoc = glGetUniformLocation(g_preprocessProgram, "uSplatScale");
+    g_preTilesLoc = glGetUniformLocation(g_preprocessProgram, "uTiles");
+    g_preCountLoc = glGetUniformLocation(g_preprocessProgram, "uCount");
+    g_dupTilesLoc = glGetUniformLocation(g_duplicateProgram, "uTiles");
+    g_dupCountLoc = glGetUniformLocation(g_duplicateProgram, "uCount");
+    g_rangesCountLoc = glGetUniformLocation(g_rangesProgram, "uCount");
+    g_renderTilesLoc = glGetUniformLocation(g_renderProgram, "uTiles");
+    g_renderSizeLoc = glGetUniformLocation(g_renderProgram, "uViewportSize");
+}
+
+bool tile_raster_init()
+{
+    g_preprocessProgram = shader_begin_compute("shaders/tile_preprocess.comp");
+    g_duplicateProgram = shader_begin_compute("shaders/tile_duplicate.comp");
+    g_rangesProgram = shader_begin_compute("shaders/tile_ranges.comp");
+    g_renderProgram = shader_begin_compute("shaders/tile_render.comp");
+    bool ok = shader_finish(&g_preprocessProgram);
+    ok = shader_finish(&g_duplicateProgram) && ok;
+    ok = shader_finish(&g_rangesProgram) && ok;
+    ok = shader_finish(&g_renderProgram) && ok;
+    if (!ok) {
+        fprintf(stderr, "tile_raster: failed to build the tile programs\n");
+        tile_raster_shutdown();
+        return false;
+    }
+
+    locate_uniforms();
+    shader_watch(&g_preprocessProgram, locate_uniforms);
+    shader_watch(&g_duplicateProgram, locate_uniforms);
+    shader_watch(&g_rangesProgram, locate_uniforms);
+    shader_watch(&g_renderProgram, locate_uniforms);
+    return true;
+}
+
+uint32_t tile_raster_target(int width, int height)
+{
+    if (width <= 0 || height <= 0) return 0;
+    if (g_texture && width == g_width && height == g_height) return g_texture;
+
+    if (g_texture) glDeleteTextures(1, &g_texture);
+    glGenTextures(1, &g_texture);
+    glBindTexture(GL_TEXTURE_2D, g_texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    g_width = width;
+    g_height = height;
+
+    g_stats.tilesX = (uint32_t)((width + k_tileSize - 1) / k_tileSize);
+    g_stats.tilesY = (uint32_t)((height + k_tileSize - 1) / k_tileSize);
+    size_t rangeBytes = (size_t)g_stats.tilesX * g_stats.tilesY * 2 * sizeof(uint32_t);
+    bool ok = g_tileRanges ? ssbo_resize(g_tileRanges, rangeBytes) : (g_tileRanges = ssbo_alloc(rangeBytes)) != 0;
+    if (!ok) fprintf(stderr, "tile_raster: failed to allocate tile ranges\n");
+    return g_texture;
+}
+
+// grow-only buffers: a handle is resized in place or moved, never re-created
+static bool ensure(SsboHandle *handle, size_t bytes)
+{
+    if (*handle) return ssbo_size(*handle) >= bytes || ssbo_resize(*handle, bytes);
+    *handle = ssbo_alloc(bytes);
+    return *handle != 0;
+}
+
+void tile_raster_render(SsboHandle packed, SsboHandle order, size_t count, const float view[16],
+                        const float proj[16], float splatScale)
+{
+    g_stats.instances = 0;
+    if (!g_renderProgram || !g_texture || !g_tileRanges) return;
+    if (count == 0) {
+        glClearTexImage(g_texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        return;
+    }
+
+    if (count > g_splatCapacity) {
+        if (!ensure(&g_projected, count * 8 * sizeof(uint32_t)) ||
+            !ensure(&g_tileOffsets, (count + 1) * sizeof(uint32_t))) {
+            fprintf(stderr, "tile_raster: failed to allocate buffers for %zu splats\n", count);
+            return;
+        }
+        g_splatCapacity = count;
+    }
+
+    // 1. project and count tiles, in draw order
+    {
+        PROFILE_GPU("tile_preprocess");
+        glUseProgram(g_preprocessProgram);
+        glUniformMatrix4fv(g_preViewLoc, 1, GL_FALSE, view);
+        glUniformMatrix4fv(g_preProjLoc, 1, GL_FALSE, proj);
+        glUniform2f(g_preViewportLoc, (float)g_width, (float)g_height);
+        glUniform2f(g_preFocalLoc, proj[0] * g_width * 0.5f, proj[5] * g_height * 0.5f);
+        glUniform1f(g_preScaleLoc, splatScale);
+        glUniform2ui(g_preTilesLoc, g_stats.tilesX, g_stats.tilesY);
+        glUniform1ui(g_preCountLoc, (GLuint)count);
+        ssbo_bind(packed, 0);
+        ssbo_bind(order, 1);
+        ssbo_bind(g_projected, 2);
+        ssbo_bind(g_tileOffsets, 3);
+        glDispatchCompute(groups_for(count), 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // 2. offsets; like the reference renderer, read the instance total back
+    // to size the instance buffers (the CPU waits here for steps 1 and 2)
+    uint32_t instances = 0;
+    {
+        PROFILE_ZONE("tile_readback");
+        PROFILE_GPU("tile_scan");
+        gpu_sort_scan(g_tileOffsets, count);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        ssbo_read(g_tileOffsets, count * sizeof(uint32_t), &instances, sizeof(instances));
+    }
+    if (instances > g_instanceCapacity) {
+        // headroom so a slowly moving camera doesn't resize every frame
+        size_t capacity = (size_t)instances + instances / 4;
+        if (!ensure(&g_instanceKeys, capacity * sizeof(uint32_t)) ||
+            !ensure(&g_instanceValues, capacity * sizeof(uint32_t)) || !gpu_sort_alloc(&g_sortBuffers, capacity)) {
+            fprintf(stderr, "tile_raster: failed to allocate %zu tile instances\n", capacity);
+            return;
+        }
+        g_instanceCapacity = capacity;
+    }
+
+    // clear ranges so empty tiles read (0, 0)
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo_buffer(g_tileRanges));
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, (GLintptr)ssbo_offset(g_tileRanges),
+                         (GLsizeiptr)ssbo_size(g_tileRanges), GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    if (instances > 0) {
+        PROFILE_GPU("tile_bin");
+        glUseProgram(g_duplicateProgram);
+        glUniform2ui(g_dupTilesLoc, g_stats.tilesX, g_stats.tilesY);
+        glUniform1ui(g_dupCountLoc, (GLuint)count);
+        ssbo_bind(g_projected, 2);
+        ssbo_bind(g_tileOffsets, 3);
+        ssbo_bind(g_instanceKeys, 4);
+        ssbo_bind(g_instanceValues, 6);
+        glDispatchCompute(groups_for(count), 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // 3. stable sort by tile (16 bits cover 4096x4096 at 16px tiles)
+        uint32_t tiles = g_stats.tilesX * g_stats.tilesY;
+        gpu_sort_pairs(g_sortBuffers, g_instanceKeys, g_instanceValues, instances, tiles <= 65536 ? 2 : 4);
+
+        glUseProgram(g_rangesProgram);
+        glUniform1ui(g_rangesCountLoc, instances);
+        ssbo_bind(g_instanceKeys, 4);
+        ssbo_bind(g_tileRanges, 7);
+        glDispatchCompute(groups_for(instances), 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // 4. blend per tile
+    PROFILE_GPU("tile_blend");
+    glUseProgram(g_renderProgram);
+    glUniform2ui(g_renderTilesLoc, g_stats.tilesX, g_stats.tilesY);
+    glUniform2i(g_renderSizeLoc, g_width, g_height);
+    ssbo_bind(g_projected, 2);
+    ssbo_bind(g_instanceValues, 6);
+    ssbo_bind(g_tileRanges, 7);
+    glBindImageTexture(0, g_texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    glDispatchCompute(g_stats.tilesX, g_stats.tilesY, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    glUseProgram(0);
+
+    g_stats.instances = instances;
+}
+
+const TileRasterStats &tile_raster_stats()
+{
+    return g_stats;
+}
+
+void tile_raster_release()
+{
+    ssbo_free(g_projected);
+    ssbo_free(g_tileOffsets);
+    ssbo_free(g_instanceKeys);
+    ssbo_free(g_instanceValues);
+    gpu_sort_free(&g_sortBuffers);
+    g_projected = g_tileOffsets = g_instanceKeys = g_instanceValues = 0;
+    g_splatCapacity = g_instanceCapacity = 0;
+    g_stats.instances = 0;
+}
+
+void tile_raster_shutdown()
+{
+    tile_raster_release();
+    ssbo_free(g_tileRanges);
+    g_tileRanges = 0;
+    if (g_texture) { glDeleteTextures(1, &g_texture); g_texture = 0; }
+    g_width = g_height = 0;
+    g_stats = TileRasterStats();
+    if (g_preprocessProgram) { glDeleteProgram(g_preprocessProgram); g_preprocessProgram = 0; }
+    if (g_duplicateProgram) { glDeleteProgram(g_duplicateProgram); g_duplicateProgram = 0; }
+    if (g_rangesProgram) { glDeleteProgram(g_rangesProgram); g_rangesProgram = 0; }
+    if (g_renderProgram) { glDeleteProgram(g_renderProgram); g_renderProgram = 0; }
+}
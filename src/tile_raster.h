@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ssbo.h"
+
+// Tile-binned compute rasterizer, an alternative to the instanced-quad draw
+// that follows the reference 3DGS renderer:
+//   1. preprocess: project and cull splats, count overlapped 16x16 tiles
+//   2. scan the counts, duplicate each splat once per tile as (tile, splat)
+//   3. stable radix sort by tile; splats arrive in back-to-front draw
+//      order, so every tile's run stays depth sorted; find per-tile ranges
+//   4. one workgroup per tile blends front to back in shared memory and
+//      stops once the tile is opaque
+// The result is an RGBA8 image (straight color, alpha = coverage) meant to
+// be drawn over the cleared framebuffer with ordinary alpha blending.
+
+struct TileRasterStats {
+    size_t instances = 0; // (tile, splat) pairs this frame
+    uint32_t tilesX = 0, tilesY = 0;
+};
+
+// Compile the programs. Returns false if they fail to build.
+bool tile_raster_init();
+
+// (Re)create the output image for a width x height viewport. Returns the GL
+// texture, which stays the same until the size changes.
+uint32_t tile_raster_target(int width, int height);
+
+// Render `count` PackedSplats in the back-to-front `order` into the target
+// image. Matrices are column-major; `splatScale` as in the raster engine.
+void tile_raster_render(SsboHandle packed, SsboHandle order, size_t count, const float view[16],
+                        const float proj[16], float splatScale);
+
+const TileRasterStats &tile_raster_stats();
+
+// Free per-scene buffers (they regrow on the next render).
+void tile_raster_release();
+
+void tile_raster_shutdown();
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free triple buffer between one producer and one consumer thread.
+// The producer always has a slot of its own to fill and the consumer always
+// reads the newest published one; neither ever waits for the other, and
+// values published while the consumer was busy are skipped. Slots are
+// reused, so a T holding vectors keeps their capacity.
+template <typename T>
+struct TripleBuffer {
+    // Producer: the slot to fill, then publish it.
+    T &back() { return slots[backIndex]; }
+    void publish()
+    {
+        uint8_t prev = middle.exchange((uint8_t)(backIndex | k_fresh), std::memory_order_acq_rel);
+        backIndex = prev & 3;
+    }
+
+    // Consumer: whether something was published since the last update, and
+    // take it. front() stays valid until the next update.
+    bool pending() const { return (middle.load(std::memory_order_acquire) & k_fresh) != 0; }
+    bool update()
+    {
+        if (!pending()) return false;
+        uint8_t prev = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = prev & 3;
+        return true;
+    }
+    T &front() { return slots[frontIndex]; }
+
+private:
+    static const uint8_t k_fresh = 4;
+    T slots[3];
+    uint8_t backIndex = 0, frontIndex = 1;
+    std::atomic<uint8_t> middle{2};
+};
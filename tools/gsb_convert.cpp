@@ -0,0 +1,161 @@
+// gsb_convert: turn a 3DGS .ply into a .gsb splat cache and report how
+// closely the cache reproduces the source.
+//
+//   gsb_convert input.ply output.gsb [--quantize] [--sh-codebook N] [--no-sh]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "ply_loader.h"
+#include "gsb.h"
+
+static float clamp01(float v)
+{
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+static double ms_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: gsb_convert input.ply output.gsb [options]\n"
+            "  --quantize        half positions/scales, 8-bit rotation and color\n"
+            "  --sh-codebook N   compress higher SH bands into an N-entry codebook (2..65536)\n"
+            "  --no-sh           drop higher SH bands\n");
+}
+
+struct ErrorStats {
+    double maxAbs = 0.0;
+    double sumSq = 0.0;
+    size_t n = 0;
+
+    void add(double err)
+    {
+        double a = fabs(err);
+        if (a > maxAbs) maxAbs = a;
+        sumSq += err * err;
+        ++n;
+    }
+    double rms() const { return n ? sqrt(sumSq / (double)n) : 0.0; }
+};
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+
+    const char *inPath = argv[1];
+    const char *outPath = argv[2];
+    GsbWriteOptions opt;
+    for (int i = 3; i < argc; ++i) {
+        if (strcmp(argv[i], "--quantize") == 0) {
+            opt.quantize = true;
+        } else if (strcmp(argv[i], "--sh-codebook") == 0 && i + 1 < argc) {
+            const char *arg = argv[++i];
+            char *end = nullptr;
+            long n = strtol(arg, &end, 10);
+            if (end == arg || *end != '\0' || n < 2 || n > 65536) {
+                fprintf(stderr, "gsb_convert: --sh-codebook takes 2..65536 entries, got '%s'\n", arg);
+                return 1;
+            }
+            opt.shCodebookSize = (int)n;
+        } else if (strcmp(argv[i], "--no-sh") == 0) {
+            opt.includeSh = false;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    PlyFile ply;
+    if (!ply_open(inPath, &ply)) return 1;
+    size_t count = ply.vertexCount;
+    int shDegree = ply.shDegree;
+    size_t plyBytes = ply.file.size;
+
+    std::vector<GpuSplat> splats(count);
+    std::vector<float> sh(shDegree > 0 ? count * SPLAT_SH_REST_FLOATS : 0);
+    float bmin[3], bmax[3];
+    SplatSink sink;
+    sink.splats = splats.data();
+    sink.shRest = sh.empty() ? nullptr : sh.data();
+    ply_load(ply, sink, bmin, bmax);
+    ply_close(&ply);
+    double plyMs = ms_since(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    if (!gsb_write(outPath, splats.data(), sh.empty() ? nullptr : sh.data(), count, shDegree, bmin, bmax, opt))
+        return 1;
+    double writeMs = ms_since(t0);
+
+    // round trip: read the cache back exactly like the viewer does
+    t0 = std::chrono::steady_clock::now();
+    GsbFile gsb;
+    if (!gsb_open(outPath, &gsb)) return 1;
+    std::vector<GpuSplat> back(count);
+    std::vector<float> backSh(sh.size());
+    SplatSink backSink;
+    backSink.splats = back.data();
+    backSink.shRest = backSh.empty() ? nullptr : backSh.data();
+    gsb_load(gsb, backSink);
+    double loadMs = ms_since(t0);
+    size_t gsbBytes = gsb.file.size;
+    uint32_t flags = gsb.header.flags;
+    uint32_t codebookSize = gsb.header.codebookSize;
+    gsb_close(&gsb);
+
+    ErrorStats pos, scale, rot, opacity, color, shErr;
+    for (size_t i = 0; i < count; ++i) {
+        const GpuSplat &a = splats[i];
+        const GpuSplat &b = back[i];
+        for (int k = 0; k < 3; ++k) {
+            pos.add(b.position[k] - a.position[k]);
+            if (a.scale[k] > 0.0f) scale.add((b.scale[k] - a.scale[k]) / a.scale[k]);
+            // colors outside [0,1] are clamped when rendered (and by the
+            // quantized layout), so compare both sides clamped
+            color.add(clamp01(b.color[k]) - clamp01(a.color[k]));
+        }
+        opacity.add(b.opacity - a.opacity);
+        // rotation angle between the quaternions, via the chord length (stable near 0)
+        double dot = 0.0, chord = 0.0;
+        for (int k = 0; k < 4; ++k) dot += (double)a.rotation[k] * b.rotation[k];
+        for (int k = 0; k < 4; ++k) {
+            double d = (double)b.rotation[k] - (dot < 0.0 ? -a.rotation[k] : a.rotation[k]);
+            chord += d * d;
+        }
+        chord = sqrt(chord) * 0.5;
+        rot.add(4.0 * asin(chord > 1.0 ? 1.0 : chord) * 57.29577951308232);
+    }
+    if (flags & GSB_HAS_SH) {
+        for (size_t i = 0; i < sh.size(); ++i) shErr.add(backSh[i] - sh[i]);
+    }
+
+    printf("gsb_convert: %s -> %s\n", inPath, outPath);
+    printf("  splats          %zu (SH degree %d)\n", count, shDegree);
+    printf("  layout          %s, SH %s", (flags & GSB_QUANTIZED) ? "quantized" : "raw",
+           !(flags & GSB_HAS_SH) ? "dropped" : ((flags & GSB_SH_CODEBOOK) ? "codebook" : "raw"));
+    if (flags & GSB_SH_CODEBOOK) printf(" (%u entries)", codebookSize);
+    printf("\n");
+    printf("  size            %.2f MB -> %.2f MB (%.2fx smaller, %.1f bytes/splat)\n",
+           plyBytes / 1048576.0, gsbBytes / 1048576.0, (double)plyBytes / (double)gsbBytes,
+           (double)gsbBytes / (double)count);
+    printf("  time            ply decode %.1f ms, write %.1f ms, gsb load %.1f ms\n", plyMs, writeMs, loadMs);
+    printf("  error           max        rms\n");
+    printf("  position        %-10.3g %-10.3g (world units)\n", pos.maxAbs, pos.rms());
+    printf("  scale           %-10.3g %-10.3g (relative)\n", scale.maxAbs, scale.rms());
+    printf("  rotation        %-10.3g %-10.3g (degrees)\n", rot.maxAbs, rot.rms());
+    printf("  opacity         %-10.3g %-10.3g\n", opacity.maxAbs, opacity.rms());
+    printf("  color           %-10.3g %-10.3g\n", color.maxAbs, color.rms());
+    if (flags & GSB_HAS_SH)
+        printf("  sh rest         %-10.3g %-10.3g\n", shErr.maxAbs, shErr.rms());
+    return 0;
+}
@@ -0,0 +1,834 @@
+// gsgl_bench: render a scene offscreen along a scripted camera path and
+// report per-frame and per-stage timings as JSON, optionally dumping frames
+// for image diffs. Runs without a display (see headless.h).
+//
+//   gsgl_bench [scene.ply | scene.gsb] [options]
+#ifndef GLFW_INCLUDE_NONE
+#define GLFW_INCLUDE_NONE
+#endif
+#include <glad/glad.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "graphics.h"
+#include "headless.h"
+#include "profiler.h"
+#include "scene_gen.h"
+#include "cpu_raster.h"
+#include "parallel.h"
+#include "ply_loader.h"
+#include "gsb.h"
+
+static const float k_clearColor[3] = {0.1f, 0.12f, 0.15f};
+// --stream: how long to wait for the first drawn splat
+static const double k_streamWaitMs = 60000.0;
+static const int k_streamEndFrames = 10;
+
+static double ms_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: gsgl_bench [scene.ply | scene.gsb] [options]\n"
+            "  --splats N        generated city scene of N splats when no scene is given (default 1000000)\n"
+            "  --frames N        measured frames (default 120)\n"
+            "  --warmup N        frames rendered before measuring (default 10)\n"
+            "  --size WxH        framebuffer size (default 1280x720)\n"
+            "  --path P          camera path: orbit, dolly, flyover or a keyframe file (default orbit)\n"
+            "  --sort S          none, cpu or gpu (default gpu, cpu if unavailable)\n"
+            "  --engine E        raster, tiles or cpu (reference renderer, needs no GL; default raster)\n"
+            "  --lod-px X        LOD node size in pixels (default 2)\n"
+            "  --no-lod          draw every splat\n"
+            "  --json FILE       write the report here instead of stdout\n"
+            "  --dump DIR        write frames as DIR/frame_NNNN.ppm\n"
+            "  --dump-every K    dump every K-th measured frame (default 1)\n"
+            "  --trace FILE      profile CPU and GPU zones and write a Chrome trace\n"
+            "  --stream          stream the scene in while measuring (graphics_load_scene_async)\n"
+            "  --upload-budget MS  chunk upload time per frame when streaming (default 4)\n"
+            "  --gpu-budget MB   render streamed scenes above this out of core\n"
+            "  --pipeline        CPU sort on a worker thread, one frame behind (implies --sort cpu)\n"
+            "  --no-gpu-cull     GPU sort: sort and draw every splat instead of the visible ones\n"
+            "  --cull-px X       GPU cull: also drop splats under X pixels in radius (default 0)\n"
+            "  --edit N          box-select the middle of the view, then edit N selected splats per frame\n"
+            "  --threads N       CPU engine: threads to render with (default all)\n"
+            "  --scaling         CPU engine: replay the path again at 1, 2, 4, ... threads\n"
+            "  --reference       GPU engines: compare every --dump-every-th frame with the CPU engine\n"
+            "  --sh-degree N     SH bands to load and evaluate, up to the scene's (default 3)\n"
+            "  --sh-angle DEG    reuse a splat's SH color until its view direction turns this far (default 1)\n"
+            "\n"
+            "A keyframe file has one 'yaw pitch distance tx ty tz' line per keyframe\n"
+            "(radians, world units; '#' starts a comment). Keyframes are spread evenly\n"
+            "over the measured frames and interpolated linearly.\n");
+}
+
+struct Keyframe {
+    float yaw, pitch, distance, target[3];
+};
+
+static Keyframe keyframe_from(const Camera &cam)
+{
+    Keyframe k = {cam.yaw, cam.pitch, cam.distance, {cam.target[0], cam.target[1], cam.target[2]}};
+    return k;
+}
+
+// Built-in paths are relative to the camera fitted to the scene.
+static bool builtin_path(const char *name, const Camera &fit, std::vector<Keyframe> *keys)
+{
+    Keyframe base = keyframe_from(fit);
+    keys->clear();
+    if (strcmp(name, "orbit") == 0) {
+        // one full turn at the fitted distance
+        for (int i = 0; i <= 8; ++i) {
+            Keyframe k = base;
+            k.yaw = base.yaw + 6.2831853f * (float)i / 8.0f;
+            keys->push_back(k);
+        }
+    } else if (strcmp(name, "dolly") == 0) {
+        // from the fitted distance in to a fifth of it and back out
+        Keyframe k = base;
+        keys->push_back(k);
+        k.distance = base.distance * 0.2f;
+        keys->push_back(k);
+        keys->push_back(base);
+    } else if (strcmp(name, "flyover") == 0) {
+        // low pass that climbs to a top-down view while turning
+        Keyframe k = base;
+        k.pitch = 0.05f;
+        k.distance = base.distance * 0.6f;
+        keys->push_back(k);
+        k.yaw = base.yaw + 1.5f;
+        k.pitch = 0.7f;
+        k.distance = base.distance;
+        keys->push_back(k);
+        k.yaw = base.yaw + 3.0f;
+        k.pitch = 1.4f;
+        k.distance = base.distance * 1.3f;
+        keys->push_back(k);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool load_path_file(const char *path, std::vector<Keyframe> *keys)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "gsgl_bench: cannot open camera path %s\n", path);
+        return false;
+    }
+    keys->clear();
+    char line[512];
+    int lineNo = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f)) {
+        ++lineNo;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        Keyframe k;
+        char extra;
+        int n = sscanf(line, "%f %f %f %f %f %f %c", &k.yaw, &k.pitch, &k.distance, &k.target[0], &k.target[1],
+                       &k.target[2], &extra);
+        if (n == EOF || n <= 0) continue;
+        if (n != 6 || k.distance <= 0.0f) {
+            fprintf(stderr, "gsgl_bench: %s:%d: expected 'yaw pitch distance tx ty tz'\n", path, lineNo);
+            ok = false;
+            break;
+        }
+        keys->push_back(k);
+    }
+    fclose(f);
+    if (ok && keys->empty()) {
+        fprintf(stderr, "gsgl_bench: %s has no keyframes\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+// Camera at `t` in [0, 1] along the keyframes.
+static void path_sample(const std::vector<Keyframe> &keys, float t, Camera *cam)
+{
+    float x = t * (float)(keys.size() - 1);
+    size_t i = std::min((size_t)x, keys.size() - 1);
+    size_t j = std::min(i + 1, keys.size() - 1);
+    float a = x - (float)i;
+    const Keyframe &k0 = keys[i], &k1 = keys[j];
+    cam->yaw = k0.yaw + (k1.yaw - k0.yaw) * a;
+    cam->pitch = k0.pitch + (k1.pitch - k0.pitch) * a;
+    cam->distance = k0.distance + (k1.distance - k0.distance) * a;
+    for (int c = 0; c < 3; ++c) cam->target[c] = k0.target[c] + (k1.target[c] - k0.target[c]) * a;
+}
+
+struct Series {
+    std::string name;
+    std::vector<double> values;
+};
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    double x = p * (double)(sorted.size() - 1);
+    size_t i = (size_t)x;
+    size_t j = std::min(i + 1, sorted.size() - 1);
+    return sorted[i] + (sorted[j] - sorted[i]) * (x - (double)i);
+}
+
+static void write_series(FILE *f, const Series &s, bool last)
+{
+    std::vector<double> v = s.values;
+    std::sort(v.begin(), v.end());
+    double sum = 0.0;
+    for (double x : v) sum += x;
+    double mean = v.empty() ? 0.0 : sum / (double)v.size();
+    fprintf(f, "    \"%s\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"mean\": %.4f, \"max\": %.4f}%s\n", s.name.c_str(),
+            percentile(v, 0.50), percentile(v, 0.95), percentile(v, 0.99), mean, v.empty() ? 0.0 : v.back(),
+            last ? "" : ",");
+}
+
+// Append the newest result of every GPU profiler zone that ran in it.
+static void collect_gpu_stages(std::vector<Series> *stages)
+{
+    for (size_t z = 0; z < profiler_zone_count(); ++z) {
+        const ProfilerZoneStats &zone = profiler_zone(z);
+        if (!zone.gpu || zone.lastMs <= 0.0f) continue;
+        // "gpu_sort" becomes gpu_sort_ms, "raster" gpu_raster_ms
+        const char *base = strncmp(zone.name, "gpu_", 4) == 0 ? zone.name + 4 : zone.name;
+        std::string name = std::string("gpu_") + base + "_ms";
+        auto it = std::find_if(stages->begin(), stages->end(), [&](const Series &s) { return s.name == name; });
+        if (it == stages->end()) it = stages->insert(stages->end(), Series{name, {}});
+        it->values.push_back(zone.lastMs);
+    }
+}
+
+// JSON string literal body for a path or renderer name.
+static std::string json_escape(const char *s)
+{
+    std::string out;
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') out += '\\';
+        if ((unsigned char)*s >= 0x20) out += *s;
+    }
+    return out;
+}
+
+// Straight-alpha RGBA (the tile and CPU engines' images) over the clear
+// color, like the UI composites it.
+static void composite_over_clear(unsigned char *rgba, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i) {
+        unsigned char *p = &rgba[i * 4];
+        float a = p[3] / 255.0f;
+        for (int c = 0; c < 3; ++c) p[c] = (unsigned char)(p[c] * a + k_clearColor[c] * 255.0f * (1.0f - a) + 0.5f);
+        p[3] = 255;
+    }
+}
+
+// The frame as the viewer would show it.
+static void read_frame(std::vector<unsigned char> *rgba)
+{
+    int w = headless_width(), h = headless_height();
+    rgba->resize((size_t)w * h * 4);
+    uint32_t tex = graphics_scene_texture(w, h);
+    if (!tex) {
+        headless_read_pixels(rgba->data());
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba->data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    composite_over_clear(rgba->data(), (size_t)w * h);
+}
+
+// PSNR over RGB (capped at 100 dB for identical images, to stay valid
+// JSON) and the largest channel difference.
+static double image_psnr(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b, int *maxError)
+{
+    double sum = 0.0;
+    size_t n = 0;
+    for (size_t i = 0; i < a.size() && i < b.size(); i += 4) {
+        for (int k = 0; k < 3; ++k) {
+            int d = (int)a[i + k] - (int)b[i + k];
+            sum += (double)d * d;
+            *maxError = std::max(*maxError, abs(d));
+        }
+        n += 3;
+    }
+    double mse = n ? sum / (double)n : 0.0;
+    return mse > 0.0 ? std::min(100.0, 10.0 * log10(255.0 * 255.0 / mse)) : 100.0;
+}
+
+// Host copy of a scene for the CPU engine.
+struct HostScene {
+    std::vector<GpuSplat> splats;
+    std::vector<float> sh;
+    int shDegree = 0;
+    float boundsMin[3], boundsMax[3];
+};
+
+static bool load_host_scene(const char *path, size_t genSplats, HostScene *scene)
+{
+    size_t n = path ? strlen(path) : 0;
+    if (!path) {
+        scene->splats = scene_generate_city(genSplats);
+        for (int k = 0; k < 3; ++k) {
+            scene->boundsMin[k] = INFINITY;
+            scene->boundsMax[k] = -INFINITY;
+        }
+        for (const GpuSplat &s : scene->splats) {
+            for (int k = 0; k < 3; ++k) {
+                scene->boundsMin[k] = std::min(scene->boundsMin[k], s.position[k]);
+                scene->boundsMax[k] = std::max(scene->boundsMax[k], s.position[k]);
+            }
+        }
+    } else if (n >= 4 && (strcmp(path + n - 4, ".gsb") == 0 || strcmp(path + n - 4, ".GSB") == 0)) {
+        GsbFile gsb;
+        if (!gsb_open(path, &gsb)) return false;
+        const GsbHeader &h = gsb.header;
+        scene->splats.resize((size_t)h.count);
+        if (h.flags & GSB_HAS_SH) scene->sh.resize((size_t)h.count * SPLAT_SH_REST_FLOATS);
+        scene->shDegree = scene->sh.empty() ? 0 : (int)h.shDegree;
+        SplatSink sink;
+        sink.splats = scene->splats.data();
+        sink.shRest = scene->sh.empty() ? nullptr : scene->sh.data();
+        gsb_load(gsb, sink);
+        memcpy(scene->boundsMin, h.boundsMin, sizeof(scene->boundsMin));
+        memcpy(scene->boundsMax, h.boundsMax, sizeof(scene->boundsMax));
+        gsb_close(&gsb);
+    } else {
+        PlyFile ply;
+        if (!ply_open(path, &ply)) return false;
+        scene->splats.resize(ply.vertexCount);
+        if (ply.shDegree > 0) scene->sh.resize(ply.vertexCount * SPLAT_SH_REST_FLOATS);
+        scene->shDegree = ply.shDegree;
+        SplatSink sink;
+        sink.splats = scene->splats.data();
+        sink.shRest = scene->sh.empty() ? nullptr : scene->sh.data();
+        ply_load(ply, sink, scene->boundsMin, scene->boundsMax);
+        ply_close(&ply);
+    }
+    return !scene->splats.empty();
+}
+
+// Render the host scene from `cam` into a composited, bottom-up frame.
+static bool render_reference(const HostScene &scene, int shDegree, const Camera &cam, int width, int height,
+                             unsigned threads, std::vector<unsigned char> *rgba, CpuRasterStats *stats)
+{
+    CpuRasterScene s;
+    s.splats = scene.splats.data();
+    s.shRest = scene.sh.empty() ? nullptr : scene.sh.data();
+    s.shDegree = shDegree;
+    s.count = scene.splats.size();
+    CpuRasterParams p;
+    camera_view_matrix(cam, p.view);
+    camera_proj_matrix(cam, (float)width / (float)height, p.proj);
+    p.width = width;
+    p.height = height;
+    p.threads = threads;
+    rgba->resize((size_t)width * height * 4);
+    if (!cpu_raster_render(s, p, rgba->data(), stats)) return false;
+    composite_over_clear(rgba->data(), (size_t)width * height);
+    return true;
+}
+
+struct CpuBench {
+    const char *scenePath, *pathName, *jsonPath, *dumpDir;
+    size_t genSplats;
+    int frames, warmup, dumpEvery, width, height;
+    unsigned threads;
+    bool scaling;
+    int shDegree;
+};
+
+// --engine cpu: the whole run on the CPU reference renderer, without GL.
+static int run_cpu_bench(const CpuBench &b)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    HostScene scene;
+    if (!load_host_scene(b.scenePath, b.genSplats, &scene)) {
+        fprintf(stderr, "gsgl_bench: failed to load the scene\n");
+        return 1;
+    }
+    double loadMs = ms_since(t0);
+    scene.shDegree = std::min(scene.shDegree, b.shDegree);
+    Camera cam;
+    camera_fit_bounds(&cam, scene.boundsMin, scene.boundsMax);
+    std::vector<Keyframe> keys;
+    if (!builtin_path(b.pathName, cam, &keys) && !load_path_file(b.pathName, &keys)) return 1;
+
+    Series frame = {"frame_ms", {}}, project = {"project_ms", {}}, bin = {"bin_ms", {}};
+    Series sort = {"sort_ms", {}}, blend = {"blend_ms", {}};
+    std::vector<unsigned char> pixels;
+    CpuRasterStats stats;
+    double visible = 0.0;
+    int dumped = 0;
+    const char *dumpDir = b.dumpDir;
+    for (int i = -b.warmup; i < b.frames; ++i) {
+        float t = b.frames > 1 ? (float)std::max(i, 0) / (float)(b.frames - 1) : 0.0f;
+        path_sample(keys, t, &cam);
+        auto f0 = std::chrono::steady_clock::now();
+        render_reference(scene, scene.shDegree, cam, b.width, b.height, b.threads, &pixels, &stats);
+        double frameMs = ms_since(f0);
+        if (i < 0) continue;
+        frame.values.push_back(frameMs);
+        project.values.push_back(stats.projectMs);
+        bin.values.push_back(stats.binMs);
+        sort.values.push_back(stats.sortMs);
+        blend.values.push_back(stats.blendMs);
+        visible += (double)stats.visible;
+        if (dumpDir && i % b.dumpEvery == 0) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/frame_%04d.ppm", dumpDir, i);
+            if (!headless_write_ppm(path, pixels.data(), b.width, b.height)) dumpDir = nullptr;
+            else ++dumped;
+        }
+    }
+
+    // the same path again at 1, 2, 4, ... threads and at every thread
+    struct Scaling {
+        unsigned threads;
+        double meanMs;
+    };
+    std::vector<Scaling> scaling;
+    if (b.scaling) {
+        unsigned maxThreads = parallel_thread_count();
+        for (unsigned n = 1;; n = std::min(n * 2, maxThreads)) {
+            double sum = 0.0;
+            for (int i = 0; i < b.frames; ++i) {
+                float t = b.frames > 1 ? (float)i / (float)(b.frames - 1) : 0.0f;
+                path_sample(keys, t, &cam);
+                auto f0 = std::chrono::steady_clock::now();
+                render_reference(scene, scene.shDegree, cam, b.width, b.height, n, &pixels, nullptr);
+                sum += ms_since(f0);
+            }
+            scaling.push_back({n, sum / b.frames});
+            if (n == maxThreads) break;
+        }
+    }
+
+    FILE *out = b.jsonPath ? fopen(b.jsonPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "gsgl_bench: cannot write %s\n", b.jsonPath);
+        out = stdout;
+    }
+    fprintf(out, "{\n");
+    fprintf(out, "  \"renderer\": \"cpu reference (%s)\",\n", stats.simd ? "avx2" : "scalar");
+    fprintf(out, "  \"scene\": \"%s\",\n", b.scenePath ? json_escape(b.scenePath).c_str() : "generated:city");
+    fprintf(out, "  \"splats\": %zu, \"sh_degree\": %d,\n", scene.splats.size(), scene.shDegree);
+    fprintf(out, "  \"load_ms\": %.1f,\n", loadMs);
+    fprintf(out, "  \"width\": %d, \"height\": %d,\n", b.width, b.height);
+    fprintf(out, "  \"path\": \"%s\", \"frames\": %d, \"warmup\": %d,\n", json_escape(b.pathName).c_str(),
+            b.frames, b.warmup);
+    fprintf(out, "  \"engine\": \"cpu\", \"threads\": %u, \"simd\": %s,\n", stats.threads,
+            stats.simd ? "true" : "false");
+    fprintf(out, "  \"mean_visible\": %.0f, \"tile_instances_last\": %zu,\n", visible / b.frames, stats.instances);
+    fprintf(out, "  \"frames_dumped\": %d,\n", dumped);
+    if (!scaling.empty()) {
+        // splats per second through the whole pipeline, and speedup over one thread
+        fprintf(out, "  \"scaling\": [\n");
+        for (size_t i = 0; i < scaling.size(); ++i) {
+            const Scaling &s = scaling[i];
+            fprintf(out, "    {\"threads\": %u, \"mean_ms\": %.3f, \"msplats_per_s\": %.2f, \"speedup\": %.2f}%s\n",
+                    s.threads, s.meanMs, scene.splats.size() / (s.meanMs * 1e3), scaling[0].meanMs / s.meanMs,
+                    i + 1 == scaling.size() ? "" : ",");
+        }
+        fprintf(out, "  ],\n");
+    }
+    const Series *stages[] = {&frame, &project, &bin, &sort, &blend};
+    fprintf(out, "  \"stages\": {\n");
+    for (size_t i = 0; i < 5; ++i) write_series(out, *stages[i], i + 1 == 5);
+    fprintf(out, "  }\n}\n");
+    if (out != stdout) fclose(out);
+    cpu_raster_release();
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *scenePath = nullptr;
+    const char *pathName = "orbit";
+    const char *jsonPath = nullptr;
+    const char *dumpDir = nullptr;
+    const char *tracePath = nullptr;
+    size_t genSplats = 1000000;
+    int frames = 120, warmup = 10, dumpEvery = 1;
+    int width = 1280, height = 720;
+    int sortMode = -1;
+    int engine = ENGINE_RASTER;
+    bool lod = true;
+    float lodPx = 2.0f;
+    bool stream = false;
+    bool pipeline = false;
+    bool gpuCull = true;
+    float cullPx = 0.0f;
+    float uploadBudget = 4.0f;
+    int gpuBudget = 0;
+    unsigned threads = 0;
+    bool scaling = false, reference = false;
+    size_t editSplats = 0;
+    int shDegree = SPLAT_MAX_SH_DEGREE;
+    float shAngle = 1.0f;
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(a, "--splats") == 0 && hasValue) {
+            genSplats = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(a, "--frames") == 0 && hasValue) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(a, "--warmup") == 0 && hasValue) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(a, "--size") == 0 && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2) width = 0;
+        } else if (strcmp(a, "--path") == 0 && hasValue) {
+            pathName = argv[++i];
+        } else if (strcmp(a, "--sort") == 0 && hasValue) {
+            const char *s = argv[++i];
+            sortMode = strcmp(s, "none") == 0 ? SORT_NONE : strcmp(s, "cpu") == 0 ? SORT_CPU
+                     : strcmp(s, "gpu") == 0 ? SORT_GPU : -2;
+        } else if (strcmp(a, "--engine") == 0 && hasValue) {
+            const char *s = argv[++i];
+            engine = strcmp(s, "raster") == 0 ? ENGINE_RASTER : strcmp(s, "tiles") == 0 ? ENGINE_TILES
+                   : strcmp(s, "cpu") == 0 ? ENGINE_CPU : -1;
+        } else if (strcmp(a, "--lod-px") == 0 && hasValue) {
+            lodPx = (float)atof(argv[++i]);
+        } else if (strcmp(a, "--no-lod") == 0) {
+            lod = false;
+        } else if (strcmp(a, "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        } else if (strcmp(a, "--dump") == 0 && hasValue) {
+            dumpDir = argv[++i];
+        } else if (strcmp(a, "--dump-every") == 0 && hasValue) {
+            dumpEvery = atoi(argv[++i]);
+        } else if (strcmp(a, "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else if (strcmp(a, "--stream") == 0) {
+            stream = true;
+        } else if (strcmp(a, "--pipeline") == 0) {
+            pipeline = true;
+        } else if (strcmp(a, "--no-gpu-cull") == 0) {
+            gpuCull = false;
+        } else if (strcmp(a, "--cull-px") == 0 && hasValue) {
+            cullPx = (float)atof(argv[++i]);
+        } else if (strcmp(a, "--threads") == 0 && hasValue) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(a, "--scaling") == 0) {
+            scaling = true;
+        } else if (strcmp(a, "--reference") == 0) {
+            reference = true;
+        } else if (strcmp(a, "--edit") == 0 && hasValue) {
+            editSplats = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(a, "--upload-budget") == 0 && hasValue) {
+            uploadBudget = (float)atof(argv[++i]);
+        } else if (strcmp(a, "--gpu-budget") == 0 && hasValue) {
+            gpuBudget = atoi(argv[++i]);
+        } else if (strcmp(a, "--sh-degree") == 0 && hasValue) {
+            shDegree = atoi(argv[++i]);
+        } else if (strcmp(a, "--sh-angle") == 0 && hasValue) {
+            shAngle = (float)atof(argv[++i]);
+        } else if (a[0] != '-' && !scenePath) {
+            scenePath = a;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (frames <= 0 || warmup < 0 || dumpEvery <= 0 || width <= 0 || height <= 0 || sortMode == -2 ||
+        engine < 0 || lodPx <= 0.0f || (!scenePath && genSplats == 0) || (stream && !scenePath) ||
+        uploadBudget < 0.0f || gpuBudget < 0 || cullPx < 0.0f || shDegree < 0 ||
+        shDegree > SPLAT_MAX_SH_DEGREE || shAngle < 0.0f ||
+        (engine == ENGINE_CPU && (stream || pipeline || reference || editSplats)) ||
+        (editSplats && (stream || reference)) ||
+        (pipeline && sortMode >= 0 && sortMode != SORT_CPU)) {
+        usage();
+        return 1;
+    }
+
+    if (engine == ENGINE_CPU) {
+        CpuBench b = {scenePath, pathName, jsonPath, dumpDir, genSplats, frames, warmup, dumpEvery,
+                      width, height, threads, scaling, shDegree};
+        return run_cpu_bench(b);
+    }
+
+    if (!headless_init(width, height)) return 1;
+    if (!graphics_init(nullptr, 0)) {
+        fprintf(stderr, "gsgl_bench: failed to initialize graphics\n");
+        headless_shutdown();
+        return 1;
+    }
+
+    GraphicsOptions *opt = graphics_options();
+    opt->streamBudgetMs = uploadBudget;
+    opt->gpuBudgetMB = gpuBudget;
+    opt->shDegree = shDegree;
+    opt->shAngleDeg = shAngle;
+    const GraphicsStats &stats = graphics_stats();
+    auto t0 = std::chrono::steady_clock::now();
+    bool loaded;
+    double firstChunkMs = -1.0;
+    if (stream) {
+        // render until the first chunks are in, so the camera path starts
+        // from the camera fitted to them. A scene that never draws anything
+        // (all culled, or the stream gave up) would otherwise hang here.
+        loaded = graphics_load_scene_async(scenePath);
+        int waitFrames = 0;
+        while (loaded && stats.drawCount == 0) {
+            // a few frames after the stream ends every chunk has been drawn
+            // at least once
+            bool ended = !stats.streaming && waitFrames >= k_streamEndFrames;
+            if (ended || ms_since(t0) > k_streamWaitMs) {
+                fprintf(stderr, "gsgl_bench: nothing drawn after %d frames (%.0f ms) of streaming %s%s\n",
+                        waitFrames, ms_since(t0), scenePath, ended ? ", and the stream has ended" : "");
+                loaded = false;
+                break;
+            }
+            glClear(GL_COLOR_BUFFER_BIT);
+            graphics_render();
+            glFinish();
+            ++waitFrames;
+        }
+        firstChunkMs = ms_since(t0);
+    } else if (scenePath) {
+        loaded = graphics_load_scene(scenePath);
+    } else {
+        std::vector<GpuSplat> splats = scene_generate_city(genSplats);
+        opt->lodMinSplats = 0; // a generated scene always gets a hierarchy
+        loaded = graphics_load_splats(splats.data(), splats.size());
+    }
+    double loadMs = ms_since(t0);
+    std::vector<Keyframe> keys;
+    bool pathOk = loaded && (builtin_path(pathName, *graphics_camera(), &keys) || load_path_file(pathName, &keys));
+    if (!pathOk) {
+        if (!loaded) fprintf(stderr, "gsgl_bench: failed to load the scene\n");
+        graphics_shutdown();
+        headless_shutdown();
+        return 1;
+    }
+
+    if (pipeline) sortMode = SORT_CPU;
+    if (sortMode < 0) sortMode = stats.gpuSortAvailable ? SORT_GPU : SORT_CPU;
+    if (sortMode == SORT_GPU && !stats.gpuSortAvailable) {
+        fprintf(stderr, "gsgl_bench: GPU sort unavailable, using the CPU sort\n");
+        sortMode = SORT_CPU;
+    }
+    if (engine == ENGINE_TILES && !stats.tileEngineAvailable) {
+        fprintf(stderr, "gsgl_bench: tile engine unavailable, using the raster engine\n");
+        engine = ENGINE_RASTER;
+    }
+    opt->sortMode = sortMode;
+    opt->pipelineSort = pipeline;
+    opt->engine = engine;
+    opt->lod = lod;
+    opt->lodPixelSize = lodPx;
+    opt->gpuCull = gpuCull;
+    opt->cullPixelRadius = cullPx;
+    // always on: the GPU stages below come from its zones
+    profiler_set_enabled(true);
+
+    // submit: CPU time inside graphics_render (LOD cut, CPU sort, command
+    // submission); frame: the same plus glFinish, i.e. until the GPU is done
+    Series frame = {"frame_ms", {}}, submit = {"submit_ms", {}}, lodSelect = {"lod_select_ms", {}};
+    Series sortKeys = {"sort_keys_ms", {}}, sortRadix = {"sort_ms", {}};
+    Series upload = {"stream_upload_ms", {}};
+    // one per GPU profiler zone (sort, cull, raster, tile passes, sh, ...),
+    // as gpu_<zone>_ms; a zone counts only in frames it ran. Results are
+    // read a frame late, so the first measured frame's come from warmup.
+    std::vector<Series> gpuStages;
+    uint64_t gpuFramesRead = profiler_stats().gpuFramesRead;
+    // pipelined: worker time and camera-to-draw latency of the order drawn
+    Series work = {"pipeline_work_ms", {}}, latency = {"pipeline_latency_ms", {}};
+    double lagFrames = 0.0;
+    // GPU cull: visible counts arrive a few frames late, so this lags too
+    double culledSum = 0.0;
+    bool gpuCulled = false;
+    double streamDoneMs = stream && !stats.streaming ? ms_since(t0) : -1.0;
+    // SH pass: runs and splats evaluated (counts arrive a few frames late)
+    int shPasses = 0;
+    double shEvaluatedSum = 0.0;
+    // --reference: the CPU engine's image of the same frames, with the SH
+    // bands the GPU evaluates
+    HostScene refScene;
+    if (reference && !load_host_scene(scenePath, genSplats, &refScene)) {
+        fprintf(stderr, "gsgl_bench: no host copy of the scene, skipping --reference\n");
+        reference = false;
+    }
+    std::vector<unsigned char> refPixels;
+    double refPsnrSum = 0.0, refPsnrMin = 100.0;
+    int refFrames = 0, refMaxError = 0;
+    // --edit: recolor, move or fade a window of the selection each frame,
+    // undoing every fourth frame instead
+    Series edit = {"edit_ms", {}};
+    std::vector<uint32_t> selection, editIndices;
+    double editBytes = 0.0, editUploads = 0.0;
+    float selectMs = 0.0f;
+    std::vector<double> drawCounts;
+    std::vector<unsigned char> pixels;
+    Camera *cam = graphics_camera();
+    int dumped = 0;
+    for (int i = -warmup; i < frames; ++i) {
+        float t = frames > 1 ? (float)std::max(i, 0) / (float)(frames - 1) : 0.0f;
+        path_sample(keys, t, cam);
+
+        if (editSplats && i == 0) {
+            if (!graphics_select(width * 0.25f, height * 0.25f, width * 0.75f, height * 0.75f, width, height,
+                                 &selection) || selection.empty()) {
+                fprintf(stderr, "gsgl_bench: nothing selected, skipping --edit\n");
+                editSplats = 0;
+            }
+            selectMs = stats.selectMs;
+        }
+        if (editSplats && i >= 0) {
+            if (i % 4 == 3) {
+                graphics_undo();
+            } else {
+                size_t n = std::min(editSplats, selection.size());
+                editIndices.resize(n);
+                for (size_t k = 0; k < n; ++k) editIndices[k] = selection[(i * n + k) % selection.size()];
+                SplatEdit e;
+                e.op = i % 4 == 0 ? SPLAT_EDIT_COLOR : i % 4 == 1 ? SPLAT_EDIT_TRANSFORM : SPLAT_EDIT_OPACITY;
+                e.indices = editIndices.data();
+                e.count = n;
+                e.color[1] = 0.2f;
+                e.translate[1] = 0.01f;
+                e.opacity = 0.3f;
+                graphics_edit(&e, 1);
+            }
+            edit.values.push_back(stats.editMs);
+            editBytes += (double)stats.editUploadBytes;
+            editUploads += (double)stats.editUploads;
+        }
+
+        profiler_begin_frame();
+        auto f0 = std::chrono::steady_clock::now();
+        glClearColor(k_clearColor[0], k_clearColor[1], k_clearColor[2], 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        graphics_scene_texture(width, height);
+        graphics_render();
+        double submitMs = ms_since(f0);
+        glFinish();
+        double frameMs = ms_since(f0);
+        profiler_end_frame();
+        if (stream && streamDoneMs < 0.0 && !stats.streaming) streamDoneMs = ms_since(t0);
+        if (i < 0) continue;
+
+        frame.values.push_back(frameMs);
+        submit.values.push_back(submitMs);
+        lodSelect.values.push_back(stats.lod.selectMs);
+        if (profiler_stats().gpuFramesRead != gpuFramesRead) {
+            gpuFramesRead = profiler_stats().gpuFramesRead;
+            collect_gpu_stages(&gpuStages);
+        }
+        sortKeys.values.push_back(stats.sort.keyMs);
+        sortRadix.values.push_back(stats.sort.sortMs);
+        drawCounts.push_back((double)stats.drawCount);
+        upload.values.push_back(stats.streamUploadMs);
+        work.values.push_back(stats.pipelineWorkMs);
+        latency.values.push_back(stats.pipelineLatencyMs);
+        lagFrames += stats.pipelineLagFrames;
+        culledSum += (double)stats.culled;
+        gpuCulled = gpuCulled || stats.gpuCulled;
+        if (stats.shEvaluating) ++shPasses;
+        shEvaluatedSum += (double)stats.shEvaluated;
+
+        if (reference && i % dumpEvery == 0) {
+            read_frame(&pixels);
+            if (render_reference(refScene, stats.shDegree, *cam, width, height, 0, &refPixels, nullptr)) {
+                double psnr = image_psnr(pixels, refPixels, &refMaxError);
+                refPsnrSum += psnr;
+                refPsnrMin = std::min(refPsnrMin, psnr);
+                ++refFrames;
+            }
+        }
+        if (dumpDir && i % dumpEvery == 0) {
+            if (!reference) read_frame(&pixels);
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/frame_%04d.ppm", dumpDir, i);
+            if (!headless_write_ppm(path, pixels.data(), width, height)) dumpDir = nullptr;
+            else ++dumped;
+        }
+    }
+
+    double meanDraw = 0.0;
+    for (double d : drawCounts) meanDraw += d;
+    meanDraw /= (double)drawCounts.size();
+    static const char *k_sortNames[] = {"none", "cpu", "gpu"};
+
+    FILE *out = jsonPath ? fopen(jsonPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "gsgl_bench: cannot write %s\n", jsonPath);
+        out = stdout;
+    }
+    fprintf(out, "{\n");
+    fprintf(out, "  \"renderer\": \"%s\",\n", json_escape((const char *)glGetString(GL_RENDERER)).c_str());
+    fprintf(out, "  \"scene\": \"%s\",\n", scenePath ? json_escape(scenePath).c_str() : "generated:city");
+    fprintf(out, "  \"splats\": %zu,\n", stats.splatCount);
+    fprintf(out, "  \"load_ms\": %.1f,\n", loadMs);
+    fprintf(out, "  \"width\": %d, \"height\": %d,\n", width, height);
+    fprintf(out, "  \"path\": \"%s\", \"frames\": %d, \"warmup\": %d,\n", json_escape(pathName).c_str(), frames,
+            warmup);
+    fprintf(out, "  \"sort\": \"%s\", \"engine\": \"%s\",\n", k_sortNames[sortMode],
+            engine == ENGINE_TILES ? "tiles" : "raster");
+    fprintf(out, "  \"lod\": %s, \"lod_px\": %.2f, \"lod_nodes\": %zu,\n",
+            lod && stats.lodAvailable ? "true" : "false", lodPx, stats.lodNodes);
+    fprintf(out, "  \"mean_draw_count\": %.0f,\n", meanDraw);
+    fprintf(out, "  \"frames_dumped\": %d,\n", dumped);
+    if (pipeline)
+        fprintf(out, "  \"pipeline\": true, \"mean_lag_frames\": %.2f, \"culled_last\": %zu,\n",
+                lagFrames / (double)frame.values.size(), stats.culled);
+    if (refFrames > 0)
+        fprintf(out, "  \"reference\": {\"frames\": %d, \"mean_psnr\": %.2f, \"min_psnr\": %.2f, \"max_error\": %d},\n",
+                refFrames, refPsnrSum / refFrames, refPsnrMin, refMaxError);
+    if (editSplats) {
+        double n = (double)edit.values.size();
+        fprintf(out, "  \"edit\": {\"splats\": %zu, \"selected\": %zu, \"select_ms\": %.2f, "
+                "\"mean_upload_bytes\": %.0f, \"mean_uploads\": %.1f, \"scene_bytes\": %zu, \"undo_bytes\": %zu},\n",
+                editSplats, selection.size(), selectMs, editBytes / n, editUploads / n,
+                stats.splatCount * sizeof(GpuSplat), stats.undoBytes);
+    }
+    if (stats.shDegreeLoaded > 0)
+        fprintf(out, "  \"sh\": {\"degree\": %d, \"loaded\": %d, \"angle_deg\": %.2f, \"mb\": %.1f, \"passes\": %d, "
+                "\"mean_evaluated\": %.0f},\n",
+                stats.shDegree, stats.shDegreeLoaded, shAngle, stats.shBytes / 1048576.0, shPasses,
+                shEvaluatedSum / (double)frame.values.size());
+    if (gpuCulled)
+        fprintf(out, "  \"gpu_cull\": true, \"cull_px\": %.2f, \"mean_culled\": %.0f,\n", cullPx,
+                culledSum / (double)frame.values.size());
+    if (stream) {
+        // -1: the scene was still streaming when the run ended
+        fprintf(out, "  \"stream\": true, \"upload_budget_ms\": %.2f, \"gpu_budget_mb\": %d,\n", uploadBudget,
+                gpuBudget);
+        fprintf(out, "  \"first_chunk_ms\": %.1f, \"stream_complete_ms\": %.1f,\n", firstChunkMs, streamDoneMs);
+        fprintf(out, "  \"out_of_core\": %s, \"chunks\": %zu, \"chunk_slots\": %zu, \"evictions\": %zu,\n",
+                stats.outOfCore ? "true" : "false", stats.chunkCount, stats.chunkSlots, stats.evictions);
+    }
+    std::vector<const Series *> stages = {&frame, &submit};
+    if (lod && stats.lodAvailable) stages.push_back(&lodSelect);
+    for (const Series &s : gpuStages) stages.push_back(&s);
+    if (sortMode == SORT_CPU) {
+        stages.push_back(&sortKeys);
+        stages.push_back(&sortRadix);
+    }
+    if (stream) stages.push_back(&upload);
+    if (editSplats) stages.push_back(&edit);
+    if (pipeline) {
+        stages.push_back(&work);
+        stages.push_back(&latency);
+    }
+    fprintf(out, "  \"stages\": {\n");
+    for (size_t i = 0; i < stages.size(); ++i) write_series(out, *stages[i], i + 1 == stages.size());
+    fprintf(out, "  }\n}\n");
+    if (out != stdout) fclose(out);
+
+    if (tracePath) profiler_export_chrome_trace(tracePath);
+    profiler_shutdown();
+    graphics_shutdown();
+    headless_shutdown();
+    return 0;
+}